@@ -42,7 +42,9 @@ public class FeedbackFileEditor : ModuleRules
                 "Projects",
                 "InputCore",
                 "HapticsManager",
-                "EditorStyle"
+                "EditorStyle",
+                "DirectoryWatcher",
+                "AssetRegistry"
                 //"Sockets",
 				// ... add private dependencies that you statically link with here ...	
 			}
@@ -4,6 +4,7 @@
 #include "Containers/UnrealString.h"
 #include "FeedbackFile.h"
 #include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
 
 #include "Templates/SharedPointer.h"
 
@@ -28,35 +29,47 @@ UFeedbackFileFactory::UFeedbackFileFactory(const FObjectInitializer& ObjectIniti
 	bEditorImport = true;
 }
 
+bool UFeedbackFileFactory::ParseFeedbackFile(const FString& Filename, FString& OutProjectString, FString& OutKey, FString& OutDevice, float& OutDuration)
+{
+	FString TextString;
+
+	if (!FFileHelper::LoadFileToString(TextString, *Filename))
+	{
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(TextString);
+
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject))
+	{
+		return false;
+	}
+
+	FString OutputString;
+	TSharedPtr<FJsonObject> JsonProject = JsonObject->GetObjectField("project");
+	TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutputString);
+	FJsonSerializer::Serialize(JsonProject.ToSharedRef(), Writer);
+
+	OutProjectString = OutputString;
+	OutKey = JsonProject->GetStringField("name");
+	OutDevice = JsonProject->GetObjectField("layout")->GetStringField("type");
+	OutDuration = JsonProject->GetNumberField("mediaFileDuration");
+	return true;
+}
+
 UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags,
 	const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled)
 {
 	UFeedbackFile* FeedbackFile = nullptr;
-	FString TextString;
 	FGuid Id = FGuid::NewGuid();
 	FString ProjectString = "";
 	FString Key = "";
 	FString Device = "Tact";
 	float Duration = 0;
+	FString SourceFile = FPaths::ConvertRelativePathToFull(Filename);
 
-	if (FFileHelper::LoadFileToString(TextString, *Filename))
-	{
-		TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
-		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(TextString);
-
-		if (FJsonSerializer::Deserialize(Reader, JsonObject))
-		{
-			FString OutputString;
-			TSharedPtr<FJsonObject> JsonProject = JsonObject->GetObjectField("project");
-			TSharedRef<TJsonWriter<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>> Writer = TJsonWriterFactory<TCHAR, TCondensedJsonPrintPolicy<TCHAR>>::Create(&OutputString);
-			FJsonSerializer::Serialize(JsonProject.ToSharedRef(), Writer);
-
-			ProjectString = OutputString;
-			Key = JsonProject->GetStringField("name");
-			Device = JsonProject->GetObjectField("layout")->GetStringField("type");
-			Duration = JsonProject->GetNumberField("mediaFileDuration");
-		}
-	}
+	ParseFeedbackFile(Filename, ProjectString, Key, Device, Duration);
 
 	bOutOperationCanceled = false;
 
@@ -69,6 +82,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 		TactotFile->Key = Key;
 		TactotFile->Device = Device;
 		TactotFile->Duration = Duration;
+		TactotFile->SourceFile = SourceFile;
 		return TactotFile;
 	}
 	else if (Device.StartsWith("Tactosy"))
@@ -80,6 +94,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 		TactosyFile->Key = Key;
 		TactosyFile->Device = Device;
 		TactosyFile->Duration = Duration;
+		TactosyFile->SourceFile = SourceFile;
 		return TactosyFile;
 	}
 	else if (Device.StartsWith("Tactal")|| Device.StartsWith("Head"))
@@ -91,6 +106,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 		TactalFile->Key = Key;
 		TactalFile->Device = Device;
 		TactalFile->Duration = Duration;
+		TactalFile->SourceFile = SourceFile;
 		return TactalFile;
 	}
 	else if (Device.StartsWith("Hand"))
@@ -102,6 +118,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 		HandFile->Key = Key;
 		HandFile->Device = Device;
 		HandFile->Duration = Duration;
+		HandFile->SourceFile = SourceFile;
 		return HandFile;
 	}
 	else if (Device.StartsWith("Foot"))
@@ -113,6 +130,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 		FootFile->Key = Key;
 		FootFile->Device = Device;
 		FootFile->Duration = Duration;
+		FootFile->SourceFile = SourceFile;
 		return FootFile;
 	}
 
@@ -122,6 +140,7 @@ UObject* UFeedbackFileFactory::FactoryCreateFile(UClass* InClass, UObject* InPar
 	FeedbackFile->Key = Key;
 	FeedbackFile->Device = Device;
 	FeedbackFile->Duration = Duration;
+	FeedbackFile->SourceFile = SourceFile;
 	
 	return FeedbackFile;
 }
\ No newline at end of file
@@ -18,5 +18,9 @@ class UFeedbackFileFactory : public UFactory
 
 public :
 	virtual UObject* FactoryCreateFile(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, const FString& Filename, const TCHAR* Parms, FFeedbackContext* Warn, bool& bOutOperationCanceled) override;
-	
+
+	//Parses a .tact file exported from the bHaptics Designer into the values stored on a UFeedbackFile.
+	//Returns false if the file could not be read or is not a valid feedback file.
+	static bool ParseFeedbackFile(const FString& Filename, FString& OutProjectString, FString& OutKey, FString& OutDevice, float& OutDuration);
+
 };
@@ -14,6 +14,7 @@
 #include "AssetTools/TactalFileActions.h"
 #include "AssetTools/HandFileActions.h"
 #include "AssetTools/FootFileActions.h"
+#include "HapticSettings.h"
 
 TArray<TSharedRef<IAssetTypeActions>> RegisteredAssetTypeActions;
 
@@ -95,12 +96,26 @@ void FFeedbackFileEditorModule::StartupModule()
 	RegisteredAssetTypeActions.Add(ActionFoot);
 
 	FSlateStyleRegistry::RegisterSlateStyle(*StyleSet);
+
+	GetMutableDefault<UHapticSettings>()->OnSettingChanged().AddRaw(this, &FFeedbackFileEditorModule::OnHapticSettingsChanged);
+	FeedbackWatcher.Refresh();
+}
+
+void FFeedbackFileEditorModule::OnHapticSettingsChanged(UObject* Settings, FPropertyChangedEvent& PropertyChangedEvent)
+{
+	FeedbackWatcher.Refresh();
 }
 
 void FFeedbackFileEditorModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FeedbackWatcher.Stop();
+	if (UObjectInitialized())
+	{
+		GetMutableDefault<UHapticSettings>()->OnSettingChanged().RemoveAll(this);
+	}
+
 	FSlateStyleRegistry::UnRegisterSlateStyle(StyleSet->GetStyleSetName());
 	FAssetToolsModule* AssetToolsModule = FModuleManager::GetModulePtr<FAssetToolsModule>("AssetTools");
 
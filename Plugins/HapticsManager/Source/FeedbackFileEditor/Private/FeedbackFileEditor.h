@@ -6,6 +6,8 @@
 #include "Styling/SlateStyle.h"
 #include "EditorStyle.h"
 
+#include "FeedbackFileWatcher.h"
+
 class FFeedbackFileEditorModule : public IModuleInterface
 {
 public:
@@ -16,4 +18,9 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 
+private:
+	void OnHapticSettingsChanged(UObject* Settings, struct FPropertyChangedEvent& PropertyChangedEvent);
+
+	FFeedbackFileWatcher FeedbackWatcher;
+
 };
\ No newline at end of file
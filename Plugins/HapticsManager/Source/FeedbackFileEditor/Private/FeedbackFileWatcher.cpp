@@ -0,0 +1,154 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#include "FeedbackFileWatcher.h"
+
+#include "AssetRegistryModule.h"
+#include "DirectoryWatcherModule.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+
+#include "BhapticsLibrary.h"
+#include "FeedbackFile.h"
+#include "HapticSettings.h"
+#include "Factories/FeedbackFileFactory.h"
+
+FFeedbackFileWatcher::~FFeedbackFileWatcher()
+{
+	Stop();
+}
+
+void FFeedbackFileWatcher::Refresh()
+{
+	Stop();
+
+	const UHapticSettings* Settings = GetDefault<UHapticSettings>();
+	if (Settings == nullptr || !Settings->bHotReloadFeedbackFiles || Settings->FeedbackSourceDirectory.Path.IsEmpty())
+	{
+		return;
+	}
+
+	FString Directory = FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), Settings->FeedbackSourceDirectory.Path);
+	FPaths::NormalizeDirectoryName(Directory);
+
+	if (!FPaths::DirectoryExists(Directory))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Feedback source directory does not exist: %s"), *Directory);
+		return;
+	}
+
+	// The platform directory watcher uses ReadDirectoryChangesW on Windows and inotify on Linux.
+	FDirectoryWatcherModule& DirectoryWatcherModule = FModuleManager::LoadModuleChecked<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	IDirectoryWatcher* DirectoryWatcher = DirectoryWatcherModule.Get();
+	if (DirectoryWatcher == nullptr)
+	{
+		return;
+	}
+
+	if (DirectoryWatcher->RegisterDirectoryChangedCallback_Handle(Directory,
+		IDirectoryWatcher::FDirectoryChanged::CreateRaw(this, &FFeedbackFileWatcher::OnDirectoryChanged), WatcherHandle))
+	{
+		WatchedDirectory = Directory;
+		UE_LOG(LogTemp, Log, TEXT("Hot-reloading feedback files from: %s"), *Directory);
+	}
+}
+
+void FFeedbackFileWatcher::Stop()
+{
+	if (!WatcherHandle.IsValid())
+	{
+		return;
+	}
+
+	FDirectoryWatcherModule* DirectoryWatcherModule = FModuleManager::GetModulePtr<FDirectoryWatcherModule>(TEXT("DirectoryWatcher"));
+	if (DirectoryWatcherModule != nullptr && DirectoryWatcherModule->Get() != nullptr)
+	{
+		DirectoryWatcherModule->Get()->UnregisterDirectoryChangedCallback_Handle(WatchedDirectory, WatcherHandle);
+	}
+
+	WatcherHandle.Reset();
+	WatchedDirectory.Empty();
+}
+
+void FFeedbackFileWatcher::OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges)
+{
+	// A single export usually raises several notifications for the same file, so reload each file once.
+	TArray<FString> ChangedFiles;
+
+	for (const FFileChangeData& Change : FileChanges)
+	{
+		if (Change.Action == FFileChangeData::FCA_Removed || FPaths::GetExtension(Change.Filename) != TEXT("tact"))
+		{
+			continue;
+		}
+
+		FString Filename = FPaths::ConvertRelativePathToFull(Change.Filename);
+		FPaths::NormalizeFilename(Filename);
+		ChangedFiles.AddUnique(Filename);
+	}
+
+	for (const FString& Filename : ChangedFiles)
+	{
+		ReloadFeedbackFile(Filename);
+	}
+}
+
+void FFeedbackFileWatcher::ReloadFeedbackFile(const FString& Filename)
+{
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>(TEXT("AssetRegistry")).Get();
+
+	TArray<FAssetData> Assets;
+	AssetRegistry.GetAssetsByClass(UFeedbackFile::StaticClass()->GetFName(), Assets, true);
+
+	for (const FAssetData& Asset : Assets)
+	{
+		FString AssetSource;
+		if (!Asset.GetTagValue(GET_MEMBER_NAME_CHECKED(UFeedbackFile, SourceFile), AssetSource) || AssetSource.IsEmpty())
+		{
+			continue;
+		}
+
+		FPaths::NormalizeFilename(AssetSource);
+		if (!FPaths::IsSamePath(AssetSource, Filename))
+		{
+			continue;
+		}
+
+		UFeedbackFile* Feedback = Cast<UFeedbackFile>(Asset.GetAsset());
+		if (Feedback != nullptr)
+		{
+			ReloadAsset(Feedback, Filename);
+		}
+	}
+}
+
+void FFeedbackFileWatcher::ReloadAsset(UFeedbackFile* Feedback, const FString& Filename)
+{
+	FString ProjectString;
+	FString Key;
+	FString Device;
+	float Duration = 0;
+
+	if (!UFeedbackFileFactory::ParseFeedbackFile(Filename, ProjectString, Key, Device, Duration))
+	{
+		// The Designer may still be writing the file; the next change notification will retry.
+		UE_LOG(LogTemp, Warning, TEXT("Could not parse feedback file: %s"), *Filename);
+		return;
+	}
+
+	if (ProjectString == Feedback->ProjectString)
+	{
+		return;
+	}
+
+	// Key and Id are kept, so the asset is re-registered under the Player key it is already playing with.
+	Feedback->Modify();
+	Feedback->ProjectString = ProjectString;
+	Feedback->Device = Device;
+	Feedback->Duration = Duration;
+	Feedback->MarkPackageDirty();
+
+	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
+	BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, ProjectString);
+
+	UE_LOG(LogTemp, Log, TEXT("Hot-reloaded feedback file %s into %s"), *Filename, *Feedback->GetPathName());
+}
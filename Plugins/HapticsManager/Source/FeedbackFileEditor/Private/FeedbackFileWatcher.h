@@ -0,0 +1,33 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IDirectoryWatcher.h"
+
+class UFeedbackFile;
+
+/**
+ * Watches the configured feedback source directory and hot-reloads Feedback File assets
+ * whose .tact file was re-exported from the bHaptics Designer.
+ */
+class FFeedbackFileWatcher
+{
+public:
+	~FFeedbackFileWatcher();
+
+	//Starts or stops watching according to the current Haptic Settings.
+	void Refresh();
+
+	void Stop();
+
+private:
+	void OnDirectoryChanged(const TArray<FFileChangeData>& FileChanges);
+
+	void ReloadFeedbackFile(const FString& Filename);
+
+	void ReloadAsset(UFeedbackFile* Feedback, const FString& Filename);
+
+	FString WatchedDirectory;
+	FDelegateHandle WatcherHandle;
+};
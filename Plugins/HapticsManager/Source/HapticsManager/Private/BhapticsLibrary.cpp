@@ -4,15 +4,106 @@
 #include "Interfaces/IPluginManager.h"
 
 #include "Misc/FileHelper.h"
+#include "HAL/FileManager.h"
+#include "Containers/Ticker.h"
 #include "Core/Public/Misc/Paths.h"
 
 #include "ThirdParty/HapticsManagerLibrary/HapticLibrary.h"
+#include "ThirdParty/HapticsManagerLibrary/motorLayout.h"
+#include "ThirdParty/HapticsManagerLibrary/positionSchema.h"
 
 #include "HapticsManager.h"
+#include "HapticsManagerStats.h"
+#include "HapticsSubmissionManager.h"
+
+#if defined(UE_TRACE_ENABLED) && UE_TRACE_ENABLED
+UE_TRACE_EVENT_BEGIN(Haptics, Submit)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, KeyHash)
+	UE_TRACE_EVENT_FIELD(uint8, Position)
+	UE_TRACE_EVENT_FIELD(uint32, PointCount)
+UE_TRACE_EVENT_END()
+#endif
+
+// Marks one submit in the frame's profile: a Haptics.Submit trace event where Unreal Insights is available,
+// and a named event spanning the call into the library while named events are being captured.
+struct FScopedHapticsSubmitEvent
+{
+	FScopedHapticsSubmitEvent(const FString& Key, EPosition Pos, int32 PointCount)
+	{
+		INC_DWORD_STAT(STAT_HapticsSubmitCount);
+
+#if defined(UE_TRACE_ENABLED) && UE_TRACE_ENABLED
+		UE_TRACE_LOG(Haptics, Submit, HapticsChannel)
+			<< Submit.Cycle(FPlatformTime::Cycles64())
+			<< Submit.KeyHash(GetTypeHash(Key))
+			<< Submit.Position((uint8)Pos)
+			<< Submit.PointCount((uint32)PointCount);
+#endif
+
+#if STATS
+		if (GCycleStatsShouldEmitNamedEvents > 0)
+		{
+			FString Name = FString::Printf(TEXT("HapticsSubmit %s %s %d"), *Key, *EnumToName(Pos), PointCount);
+			FPlatformMisc::BeginNamedEvent(FColor::Orange, *Name);
+			bEmitted = true;
+		}
+#endif
+	}
+
+	~FScopedHapticsSubmitEvent()
+	{
+		if (bEmitted)
+		{
+			FPlatformMisc::EndNamedEvent();
+		}
+	}
+
+private:
+	static FString EnumToName(EPosition Pos)
+	{
+		const UEnum* PositionEnum = FindObject<UEnum>(ANY_PACKAGE, TEXT("EPosition"), true);
+		return PositionEnum != nullptr ? PositionEnum->GetNameStringByValue((int64)Pos) : FString::FromInt((int32)Pos);
+	}
+
+	bool bEmitted = false;
+};
+
+// EPosition mirrors the bhaptics::Position values, so converting is a lookup in the library's position schema.
+static_assert((int)EPosition::Left == bhaptics::Position::Left && (int)EPosition::Right == bhaptics::Position::Right, "EPosition must mirror bhaptics::Position");
+static_assert((int)EPosition::Head == bhaptics::Position::Head, "EPosition must mirror bhaptics::Position");
+static_assert((int)EPosition::HandL == bhaptics::Position::HandL && (int)EPosition::HandR == bhaptics::Position::HandR, "EPosition must mirror bhaptics::Position");
+static_assert((int)EPosition::FootL == bhaptics::Position::FootL && (int)EPosition::FootR == bhaptics::Position::FootR, "EPosition must mirror bhaptics::Position");
+static_assert((int)EPosition::ForearmL == bhaptics::Position::ForearmL && (int)EPosition::ForearmR == bhaptics::Position::ForearmR, "EPosition must mirror bhaptics::Position");
+static_assert((int)EPosition::VestFront == bhaptics::Position::VestFront && (int)EPosition::VestBack == bhaptics::Position::VestBack, "EPosition must mirror bhaptics::Position");
+
+static bhaptics::Position ToHapticPosition(EPosition Pos)
+{
+	return bhaptics::positionFromValue((int)Pos);
+}
+
+// The devices status lists report, each once and in PositionSchema order: ForearmL, ForearmR, Head, VestFront, ...
+static const TArray<EPosition>& ListedPositions()
+{
+	static const TArray<EPosition> Positions = []()
+	{
+		TArray<EPosition> Listed;
+		for (const bhaptics::PositionInfo& Info : bhaptics::PositionSchema)
+		{
+			if (Info.Listed)
+			{
+				Listed.Add((EPosition)Info.Value);
+			}
+		}
+		return Listed;
+	}();
+	return Positions;
+}
 
 bool BhapticsLibrary::IsInitialised = false;
 bool BhapticsLibrary::IsLoaded = false;
 FProcHandle BhapticsLibrary::Handle;
+FDelegateHandle BhapticsLibrary::LatencyLogHandle;
 bool BhapticsLibrary::Success = false;
 
 BhapticsLibrary::BhapticsLibrary()
@@ -44,6 +135,13 @@ bool BhapticsLibrary::InitialiseConnection()
 	}
 
 	bool bLaunch = true;
+	bool bCompress = false;
+	bool bCull = false;
+	bool bTransformLocally = false;
+	bool bRasterizePaths = false;
+	float LatencyLogInterval = 0;
+	bool bRecordSession = false;
+	bool bRecordStatus = false;
 	if (GConfig)
 	{
 		GConfig->GetBool(
@@ -52,6 +150,48 @@ bool BhapticsLibrary::InitialiseConnection()
 			bLaunch,
 			GGameIni
 		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bCompressTraffic"),
+			bCompress,
+			GGameIni
+		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bCullDisconnectedDevices"),
+			bCull,
+			GGameIni
+		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bTransformLocally"),
+			bTransformLocally,
+			GGameIni
+		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bRasterizePaths"),
+			bRasterizePaths,
+			GGameIni
+		);
+		GConfig->GetFloat(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("SubmitLatencyLogInterval"),
+			LatencyLogInterval,
+			GGameIni
+		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bRecordSession"),
+			bRecordSession,
+			GGameIni
+		);
+		GConfig->GetBool(
+			TEXT("/Script/HapticsManager.HapticSettings"),
+			TEXT("bRecordStatus"),
+			bRecordStatus,
+			GGameIni
+		);
 	}
 
 	IsInitialised = true;
@@ -106,8 +246,37 @@ bool BhapticsLibrary::InitialiseConnection()
 
 	}
 
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	if (bRecordSession)
+	{
+		// Started before Initialise so the registrations sent on connect are part of the recording.
+		FString RecordingDir = FPaths::ConvertRelativePathToFull(FPaths::ProjectSavedDir() / TEXT("Haptics"));
+		IFileManager::Get().MakeDirectory(*RecordingDir, true);
+		FString RecordingPath = RecordingDir / FString::Printf(TEXT("Session-%s.bhrec"), *FDateTime::Now().ToString());
+		std::string StandardPath(TCHAR_TO_UTF8(*RecordingPath));
+		if (StartRecording(StandardPath, bRecordStatus))
+		{
+			UE_LOG(LogTemp, Log, TEXT("Recording haptic requests to %s"), *RecordingPath);
+		}
+	}
+
+	SetCompression(bCompress);
+	SetCullDisconnected(bCull);
+	SetLocalTransforms(bTransformLocally);
+	SetRasterizePaths(bRasterizePaths);
+#else
+	if (bRecordSession || bCompress || bCull || bTransformLocally || bRasterizePaths)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("The prebuilt HapticLibrary predates the recording, compression, culling, local transform and path rasterizing settings; rebuild it from HapticLibrary.sln to use them."));
+	}
+#endif
 	Initialise();
 	Success = true;
+
+	if (LatencyLogInterval > 0)
+	{
+		LatencyLogHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateStatic(&BhapticsLibrary::LogSubmitLatency), LatencyLogInterval);
+	}
 	return true;
 }
 
@@ -118,6 +287,12 @@ void BhapticsLibrary::Free()
 		return;
 	}
 
+	if (LatencyLogHandle.IsValid())
+	{
+		FTicker::GetCoreTicker().RemoveTicker(LatencyLogHandle);
+		LatencyLogHandle.Reset();
+	}
+
 	Destroy();
 
 	if (Handle.IsValid())
@@ -133,6 +308,7 @@ void BhapticsLibrary::Lib_RegisterFeedback(FString Key, FString ProjectJson)
 	{
 		return;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsRegister);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
 	std::string ProjectString = (TCHAR_TO_UTF8(*ProjectJson));
 	RegisterFeedback(StandardKey, ProjectString);
@@ -144,6 +320,8 @@ void BhapticsLibrary::Lib_SubmitRegistered(FString Key)
 	{
 		return;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	FScopedHapticsSubmitEvent SubmitEvent(Key, EPosition::Default, 0);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
 	SubmitRegistered(StandardKey);
 }
@@ -154,6 +332,8 @@ void BhapticsLibrary::Lib_SubmitRegistered(FString Key, FString AltKey, FScaleOp
 	{
 		return;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	FScopedHapticsSubmitEvent SubmitEvent(AltKey.IsEmpty() ? Key : AltKey, EPosition::Default, 0);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
 	std::string StandardAltKey(TCHAR_TO_UTF8(*AltKey));
 	bhaptics::RotationOption RotateOption;
@@ -172,61 +352,18 @@ void BhapticsLibrary::Lib_Submit(FString Key, EPosition Pos, TArray<uint8> Motor
 	{
 		return;
 	}
-	bhaptics::Position HapticPosition = bhaptics::Position::All;
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	FScopedHapticsSubmitEvent SubmitEvent(Key, Pos, MotorBytes.Num());
+	bhaptics::Position HapticPosition = ToHapticPosition(Pos);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
 
-	switch (Pos)
-	{
-	case EPosition::Left:
-		HapticPosition = bhaptics::Position::Left;
-		break;
-	case EPosition::Right:
-		HapticPosition = bhaptics::Position::Right;
-		break;
-	case EPosition::Head:
-		HapticPosition = bhaptics::Position::Head;
-		break;
-	case EPosition::VestFront:
-		HapticPosition = bhaptics::Position::VestFront;
-		break;
-	case EPosition::VestBack:
-		HapticPosition = bhaptics::Position::VestBack;
-		break;
-	case EPosition::HandL:
-		HapticPosition = bhaptics::Position::HandL;
-		break;
-	case EPosition::HandR:
-		HapticPosition = bhaptics::Position::HandR;
-		break;
-	case EPosition::FootL:
-		HapticPosition = bhaptics::Position::FootL;
-		break;
-	case EPosition::FootR:
-		HapticPosition = bhaptics::Position::FootR;
-		break;
-	case EPosition::ForearmL:
-		HapticPosition = bhaptics::Position::ForearmL;
-		break;
-	case EPosition::ForearmR:
-		HapticPosition = bhaptics::Position::ForearmR;
-		break;
-	default:
-		break;
-	}
-
-	if (MotorBytes.Num() != 20)
-	{
-		printf("Invalid Point Array\n");
-		return;
-	}
-
-	std::vector<uint8_t> SubmittedDots(20, 0);
-
-	for (int32 i = 0; i < MotorBytes.Num(); i++)
+	int32 NumMotors = Lib_FitMotorBytes(Pos, MotorBytes.Num());
+	if (NumMotors == INDEX_NONE)
 	{
-		SubmittedDots[i] = MotorBytes[i];
+		return;
 	}
 
+	std::vector<uint8_t> SubmittedDots(MotorBytes.GetData(), MotorBytes.GetData() + NumMotors);
 	Submit(StandardKey, HapticPosition, SubmittedDots, DurationMillis);
 }
 
@@ -236,46 +373,10 @@ void BhapticsLibrary::Lib_Submit(FString Key, EPosition Pos, TArray<FDotPoint> P
 	{
 		return;
 	}
-	bhaptics::Position HapticPosition = bhaptics::Position::All;
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	FScopedHapticsSubmitEvent SubmitEvent(Key, Pos, Points.Num());
+	bhaptics::Position HapticPosition = ToHapticPosition(Pos);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
-	switch (Pos)
-	{
-	case EPosition::Left:
-		HapticPosition = bhaptics::Position::Left;
-		break;
-	case EPosition::Right:
-		HapticPosition = bhaptics::Position::Right;
-		break;
-	case EPosition::Head:
-		HapticPosition = bhaptics::Position::Head;
-		break;
-	case EPosition::VestFront:
-		HapticPosition = bhaptics::Position::VestFront;
-		break;
-	case EPosition::VestBack:
-		HapticPosition = bhaptics::Position::VestBack;
-		break;
-	case EPosition::HandL:
-		HapticPosition = bhaptics::Position::HandL;
-		break;
-	case EPosition::HandR:
-		HapticPosition = bhaptics::Position::HandR;
-		break;
-	case EPosition::FootL:
-		HapticPosition = bhaptics::Position::FootL;
-		break;
-	case EPosition::FootR:
-		HapticPosition = bhaptics::Position::FootR;
-		break;
-	case EPosition::ForearmL:
-		HapticPosition = bhaptics::Position::ForearmL;
-		break;
-	case EPosition::ForearmR:
-		HapticPosition = bhaptics::Position::ForearmR;
-		break;
-	default:
-		break;
-	}
 
 	std::vector<bhaptics::DotPoint> SubmittedDots;
 
@@ -293,46 +394,10 @@ void BhapticsLibrary::Lib_Submit(FString Key, EPosition Pos, TArray<FPathPoint>
 	{
 		return;
 	}
-	bhaptics::Position HapticPosition = bhaptics::Position::All;
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	FScopedHapticsSubmitEvent SubmitEvent(Key, Pos, Points.Num());
+	bhaptics::Position HapticPosition = ToHapticPosition(Pos);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
-	switch (Pos)
-	{
-	case EPosition::Left:
-		HapticPosition = bhaptics::Position::Left;
-		break;
-	case EPosition::Right:
-		HapticPosition = bhaptics::Position::Right;
-		break;
-	case EPosition::Head:
-		HapticPosition = bhaptics::Position::Head;
-		break;
-	case EPosition::VestFront:
-		HapticPosition = bhaptics::Position::VestFront;
-		break;
-	case EPosition::VestBack:
-		HapticPosition = bhaptics::Position::VestBack;
-		break;
-	case EPosition::HandL:
-		HapticPosition = bhaptics::Position::HandL;
-		break;
-	case EPosition::HandR:
-		HapticPosition = bhaptics::Position::HandR;
-		break;
-	case EPosition::FootL:
-		HapticPosition = bhaptics::Position::FootL;
-		break;
-	case EPosition::FootR:
-		HapticPosition = bhaptics::Position::FootR;
-		break;
-	case EPosition::ForearmL:
-		HapticPosition = bhaptics::Position::ForearmL;
-		break;
-	case EPosition::ForearmR:
-		HapticPosition = bhaptics::Position::ForearmR;
-		break;
-	default:
-		break;
-	}
 
 	std::vector<bhaptics::PathPoint> PathVector;
 
@@ -347,12 +412,285 @@ void BhapticsLibrary::Lib_Submit(FString Key, EPosition Pos, TArray<FPathPoint>
 	SubmitPath(StandardKey, HapticPosition, PathVector, DurationMillis);
 }
 
+void BhapticsLibrary::Lib_SubmitBatch(const TArray<FHapticSubmission>& Submissions)
+{
+	if (!IsLoaded || Submissions.Num() == 0)
+	{
+		return;
+	}
+
+#if !BHAPTICS_LIBRARY_EXTENSIONS
+	// The original library neither batches nor schedules: send each submission by itself, at once.
+	for (const FHapticSubmission& Submission : Submissions)
+	{
+		switch (Submission.Type)
+		{
+		case EHapticSubmissionType::Dots:
+			Lib_Submit(Submission.Key, Submission.Position, Submission.Dots, Submission.DurationMillis);
+			break;
+		case EHapticSubmissionType::Paths:
+			Lib_Submit(Submission.Key, Submission.Position, Submission.Paths, Submission.DurationMillis);
+			break;
+		case EHapticSubmissionType::Registered:
+			if (Submission.bHasOptions)
+			{
+				Lib_SubmitRegistered(Submission.Key, Submission.AltKey, Submission.ScaleOption, Submission.RotationOption);
+			}
+			else
+			{
+				Lib_SubmitRegistered(Submission.Key);
+			}
+			break;
+		case EHapticSubmissionType::TurnOff:
+			Lib_TurnOff(Submission.Key);
+			break;
+		case EHapticSubmissionType::TurnOffAll:
+			Lib_TurnOff();
+			break;
+		default:
+			break;
+		}
+	}
+#else
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	INC_DWORD_STAT_BY(STAT_HapticsSubmitCount, Submissions.Num());
+
+	std::vector<bhaptics::SubmitRequest> Requests;
+	std::vector<bhaptics::ScheduledSubmit> Scheduled;
+	Requests.reserve(Submissions.Num());
+	for (const FHapticSubmission& Submission : Submissions)
+	{
+		std::string StandardKey(TCHAR_TO_UTF8(*Submission.Key));
+		if (Submission.Type == EHapticSubmissionType::CancelScheduled)
+		{
+			// Scheduled in order, so a cancel only drops what was scheduled before it.
+			SubmitScheduled(Scheduled);
+			Scheduled.clear();
+			CancelScheduled(StandardKey);
+			continue;
+		}
+
+		switch (Submission.Type)
+		{
+		case EHapticSubmissionType::Dots:
+		{
+			bhaptics::Frame Frame;
+			Frame.Position = ToHapticPosition(Submission.Position);
+			Frame.DurationMillis = Submission.DurationMillis;
+			if (Submission.Dots.Num() <= bhaptics::MaxMotors)
+			{
+				for (const FDotPoint& Dot : Submission.Dots)
+				{
+					Frame.DotPoints.push_back(bhaptics::DotPoint(Dot.Index, Dot.Intensity));
+				}
+			}
+			else
+			{
+				// More dots than motors repeat motors, and a frame holds one dot per motor: keep the strongest of each, as
+				// rasterized paths do, rather than dropping the dots past the frame's capacity.
+				int32 Intensities[bhaptics::MaxMotors] = {};
+				for (const FDotPoint& Dot : Submission.Dots)
+				{
+					bhaptics::DotPoint Point(Dot.Index, Dot.Intensity);
+					Intensities[Point.index] = FMath::Max(Intensities[Point.index], Point.intensity);
+				}
+				for (int32 i = 0; i < bhaptics::MaxMotors; i++)
+				{
+					if (Intensities[i] > 0)
+					{
+						Frame.DotPoints.push_back(bhaptics::DotPoint(i, Intensities[i]));
+					}
+				}
+			}
+			Requests.push_back(bhaptics::SubmitRequest::AsFrame(StandardKey, Frame));
+			break;
+		}
+		case EHapticSubmissionType::Paths:
+		{
+			// A frame holds up to bhaptics::MaxPathPoints points. Longer paths go to the library whole, which rasterizes
+			// every point or counts those it cannot send as DroppedPathPoints.
+			bhaptics::Frame Frame;
+			Frame.Position = ToHapticPosition(Submission.Position);
+			Frame.DurationMillis = Submission.DurationMillis;
+			Requests.push_back(bhaptics::SubmitRequest::AsFrame(StandardKey, Frame));
+			bool bFits = Submission.Paths.Num() <= bhaptics::MaxPathPoints;
+			if (!bFits)
+			{
+				Requests.back().AllPathPoints.reserve(Submission.Paths.Num());
+			}
+			for (const FPathPoint& Path : Submission.Paths)
+			{
+				bhaptics::PathPoint Point((int)(Path.X * 1000), (int)(Path.Y * 1000), Path.Intensity, Path.MotorCount);
+				if (bFits)
+				{
+					Requests.back().Frame.PathPoints.push_back(Point);
+				}
+				else
+				{
+					Requests.back().AllPathPoints.push_back(Point);
+				}
+			}
+			break;
+		}
+		case EHapticSubmissionType::Registered:
+			if (Submission.bHasOptions)
+			{
+				bhaptics::ScaleOption Option;
+				Option.Intensity = Submission.ScaleOption.Intensity;
+				Option.Duration = Submission.ScaleOption.Duration;
+				bhaptics::RotationOption RotateOption;
+				RotateOption.OffsetAngleX = Submission.RotationOption.OffsetAngleX;
+				RotateOption.OffsetY = Submission.RotationOption.OffsetY;
+				Requests.push_back(bhaptics::SubmitRequest::AsRegistered(StandardKey, TCHAR_TO_UTF8(*Submission.AltKey), Option, RotateOption));
+			}
+			else
+			{
+				Requests.push_back(bhaptics::SubmitRequest::AsRegistered(StandardKey));
+			}
+			break;
+		case EHapticSubmissionType::TurnOff:
+			Requests.push_back(bhaptics::SubmitRequest::AsTurnOff(StandardKey));
+			break;
+		case EHapticSubmissionType::TurnOffAll:
+			Requests.push_back(bhaptics::SubmitRequest::AsTurnOffAll());
+			break;
+		default:
+			break;
+		}
+
+		if (Submission.bAtOnset)
+		{
+			Scheduled.push_back(bhaptics::ScheduledSubmit::AtOnset(Submission.DelayMillis, Requests.back()));
+			Requests.pop_back();
+		}
+		else if (Submission.DelayMillis > 0)
+		{
+			Scheduled.push_back(bhaptics::ScheduledSubmit::After(Submission.DelayMillis, Requests.back()));
+			Requests.pop_back();
+		}
+	}
+
+	SubmitBatch(Requests);
+	SubmitScheduled(Scheduled);
+#endif
+}
+
+static_assert((int)EWaveShape::Constant == (int)bhaptics::WaveShape::Constant && (int)EWaveShape::Noise == (int)bhaptics::WaveShape::Noise, "EWaveShape must mirror bhaptics::WaveShape");
+
+#if BHAPTICS_LIBRARY_EXTENSIONS
+static bhaptics::SynthEffect ToSynthEffect(const FProceduralFeedback& Feedback)
+{
+	bhaptics::SynthEffect Effect;
+	Effect.Position = ToHapticPosition(Feedback.Position);
+	Effect.Intensity = FMath::Max(Feedback.Intensity, 0.0f);
+	Effect.DurationMillis = FMath::Max(Feedback.DurationMillis, 0);
+	Effect.Envelope.AttackMillis = FMath::Max(Feedback.AttackMillis, 0);
+	Effect.Envelope.DecayMillis = FMath::Max(Feedback.DecayMillis, 0);
+	Effect.Envelope.SustainLevel = FMath::Clamp(Feedback.SustainLevel, 0.0f, 1.0f);
+	Effect.Envelope.ReleaseMillis = FMath::Max(Feedback.ReleaseMillis, 0);
+	Effect.Shape = (bhaptics::WaveShape)Feedback.Shape;
+	Effect.FrequencyHz = FMath::Max(Feedback.FrequencyHz, 0.0f);
+	Effect.Depth = FMath::Clamp(Feedback.Depth, 0.0f, 1.0f);
+	Effect.MotorMask = (uint32)Feedback.MotorMask;
+	Effect.SweepFrom = Feedback.SweepFrom;
+	Effect.SweepTo = Feedback.SweepTo;
+	Effect.SweepWidth = Feedback.SweepWidth;
+	Effect.SweepMillis = FMath::Max(Feedback.SweepMillis, 0);
+	Effect.SweepLoop = Feedback.bSweepLoop;
+	Effect.Seed = (uint32)Feedback.Seed;
+	return Effect;
+}
+#endif
+
+void BhapticsLibrary::Lib_PlayProcedural(FString Key, const FProceduralFeedback& Feedback)
+{
+	if (!IsLoaded)
+	{
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	std::string StandardKey(TCHAR_TO_UTF8(*Key));
+	bhaptics::SynthEffect Effect = ToSynthEffect(Feedback);
+	PlaySynth(StandardKey, Effect);
+#endif
+}
+
+bool BhapticsLibrary::Lib_UpdateProcedural(FString Key, const FProceduralFeedback& Feedback)
+{
+	if (!IsLoaded)
+	{
+		return false;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	SCOPE_CYCLE_COUNTER(STAT_HapticsSubmit);
+	std::string StandardKey(TCHAR_TO_UTF8(*Key));
+	bhaptics::SynthEffect Effect = ToSynthEffect(Feedback);
+	return UpdateSynth(StandardKey, Effect);
+#else
+	return false;
+#endif
+}
+
+void BhapticsLibrary::Lib_ReleaseProcedural(FString Key)
+{
+	if (!IsLoaded)
+	{
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	std::string StandardKey(TCHAR_TO_UTF8(*Key));
+	ReleaseSynth(StandardKey);
+#endif
+}
+
+void BhapticsLibrary::Lib_SetAudioHaptics(const FAudioHapticsSettings& Settings)
+{
+	if (!IsLoaded)
+	{
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	bhaptics::AudioHapticsConfig Config;
+	Config.CrossoverHz[0] = Settings.BassCrossoverHz;
+	Config.CrossoverHz[1] = FMath::Max(Settings.LowMidCrossoverHz, Settings.BassCrossoverHz);
+	Config.CrossoverHz[2] = FMath::Max(Settings.HighMidCrossoverHz, Config.CrossoverHz[1]);
+	Config.UsePeak = Settings.bUsePeak;
+	Config.FloorDb = FMath::Min(Settings.FloorDb, -1.0f);
+	Config.ReleaseMillis = FMath::Max(Settings.ReleaseMillis, 0);
+	for (const FAudioHapticsRoute& Route : Settings.Routes)
+	{
+		bhaptics::AudioHapticsRoute LibraryRoute;
+		LibraryRoute.Position = ToHapticPosition(Route.Position);
+		LibraryRoute.Gain = FMath::Max(Route.Gain, 0.0f);
+		LibraryRoute.BandGains[0] = FMath::Max(Route.BassGain, 0.0f);
+		LibraryRoute.BandGains[1] = FMath::Max(Route.LowMidGain, 0.0f);
+		LibraryRoute.BandGains[2] = FMath::Max(Route.HighMidGain, 0.0f);
+		LibraryRoute.BandGains[3] = FMath::Max(Route.TrebleGain, 0.0f);
+		Config.Routes.push_back(LibraryRoute);
+	}
+	SetAudioHaptics(Config);
+#endif
+}
+
+void BhapticsLibrary::Lib_FeedAudio(const float* Samples, int32 Frames, int32 Channels, int32 SampleRate)
+{
+	if (!IsLoaded)
+	{
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	FeedAudio(Samples, Frames, Channels, SampleRate);
+#endif
+}
+
 bool BhapticsLibrary::Lib_IsFeedbackRegistered(FString key)
 {
 	if (!IsLoaded)
 	{
 		return false;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
 	std::string StandardKey(TCHAR_TO_UTF8(*key));
 	bool Value = false;
 	Value = IsFeedbackRegistered(StandardKey);
@@ -365,6 +703,7 @@ bool BhapticsLibrary::Lib_IsPlaying()
 	{
 		return false;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
 	bool Value = false;
 	Value = IsPlaying();
 	return Value;
@@ -376,6 +715,7 @@ bool BhapticsLibrary::Lib_IsPlaying(FString Key)
 	{
 		return false;
 	}
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
 	std::string StandardKey(TCHAR_TO_UTF8(*Key));
 	bool Value = false;
 	Value = IsPlayingKey(StandardKey);
@@ -434,51 +774,86 @@ bool BhapticsLibrary::Lib_IsDevicePlaying(EPosition Pos)
 	{
 		return false;
 	}
-	bhaptics::Position device = bhaptics::Position::All;
-
-	switch (Pos)
-	{
-	case EPosition::Left:
-		device = bhaptics::Position::Left;
-		break;
-	case EPosition::Right:
-		device = bhaptics::Position::Right;
-		break;
-	case EPosition::Head:
-		device = bhaptics::Position::Head;
-		break;
-	case EPosition::HandL:
-		device = bhaptics::Position::HandL;
-		break;
-	case EPosition::HandR:
-		device = bhaptics::Position::HandR;
-		break;
-	case EPosition::FootL:
-		device = bhaptics::Position::FootL;
-		break;
-	case EPosition::FootR:
-		device = bhaptics::Position::FootR;
-		break;
-	case EPosition::ForearmL:
-		device = bhaptics::Position::ForearmL;
-		break;
-	case EPosition::ForearmR:
-		device = bhaptics::Position::ForearmR;
-		break;
-	case EPosition::VestFront:
-		device = bhaptics::Position::Vest;
-		break;
-	case EPosition::VestBack:
-		device = bhaptics::Position::Vest;
-		break;
-	default:
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
+	if (Pos == EPosition::Default)
+	{
 		return false;
-		break;
 	}
 
-	bool Value = false;
-	Value = IsDevicePlaying(device);
-	return Value;
+	return IsDevicePlaying(ToHapticPosition(Pos));
+}
+
+int32 BhapticsLibrary::Lib_GetConnectedDeviceMask()
+{
+	if (!IsLoaded)
+	{
+		return 0;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	return (int32)GetConnectedPositionMask();
+#else
+	return (int32)bhaptics::AllPositionsMask;
+#endif
+}
+
+bool BhapticsLibrary::Lib_IsDeviceConnected(int32 DeviceMask, EPosition Pos)
+{
+	return ((uint32)DeviceMask & bhaptics::positionMask(ToHapticPosition(Pos))) != 0;
+}
+
+int32 BhapticsLibrary::Lib_GetMotorCount(EPosition Pos)
+{
+	return bhaptics::motorCount(ToHapticPosition(Pos));
+}
+
+int32 BhapticsLibrary::Lib_FitMotorBytes(EPosition Pos, int32 NumBytes)
+{
+	if (NumBytes > bhaptics::MaxMotors)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%d motor bytes for %s; at most %d are accepted."), NumBytes,
+			UTF8_TO_TCHAR(bhaptics::positionName(ToHapticPosition(Pos))), bhaptics::MaxMotors);
+		return INDEX_NONE;
+	}
+	return FMath::Min(NumBytes, Lib_GetMotorCount(Pos));
+}
+
+void BhapticsLibrary::Lib_GetSideDots(EPosition Pos, float Left, float Right, TArray<FDotPoint>& Dots)
+{
+	Dots.Reset();
+	const bhaptics::MotorLayout& Layout = bhaptics::motorLayout(ToHapticPosition(Pos));
+	for (int32 i = 0; i < Layout.MotorCount; i++)
+	{
+		float RightWeight;
+		switch (Pos)
+		{
+		case EPosition::Left:
+		case EPosition::HandL:
+		case EPosition::FootL:
+		case EPosition::ForearmL:
+			RightWeight = 0.0f;
+			break;
+		case EPosition::Right:
+		case EPosition::HandR:
+		case EPosition::FootR:
+		case EPosition::ForearmR:
+			RightWeight = 1.0f;
+			break;
+		default:
+			RightWeight = Layout.Columns > 1 ? Layout.X[i] / (Layout.Columns - 1) : 0.5f;
+			// The back columns continue around the wearer from the right side.
+			if (Pos == EPosition::VestBack)
+			{
+				RightWeight = 1.0f - RightWeight;
+			}
+			break;
+		}
+		float Value = FMath::Lerp(Left, Right, RightWeight);
+		int32 Intensity = FMath::Clamp(FMath::RoundToInt(Value * 100.0f), 0, 100);
+		if (Intensity > 0)
+		{
+			Dots.Add(FDotPoint(i, Intensity));
+		}
+	}
 }
 
 TArray<FHapticFeedback> BhapticsLibrary::Lib_GetResponseStatus()
@@ -488,25 +863,141 @@ TArray<FHapticFeedback> BhapticsLibrary::Lib_GetResponseStatus()
 	{
 		return ChangedFeedbacks;
 	}
-	std::string Positions [] = {"ForearmL","ForearmR","Head", "VestFront", "VestBack", "HandL", "HandR", "FootL", "FootR"};
-	TArray<EPosition> PositionEnum =
-		{ EPosition::ForearmL,EPosition::ForearmR,EPosition::Head, EPosition::VestFront,EPosition::VestBack,EPosition::HandL, EPosition::HandR, EPosition::FootL, EPosition::FootR };
-
-	for (int i = 0; i < 9; i++)
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
+	for (EPosition Device : ListedPositions())
 	{
 		std::vector<int> values;
-		values.resize(20);
-		GetResponseForPosition(values, Positions[i]);
+		values.resize(bhaptics::motorCount(ToHapticPosition(Device)));
+		std::string Position = bhaptics::positionName(ToHapticPosition(Device));
+		GetResponseForPosition(values, Position);
 		TArray<uint8> val;
 		for (size_t j = 0; j < values.size(); j++)
 		{
 			val.Add(values[j]);
 		}
 
-		FHapticFeedback Feedback = FHapticFeedback(PositionEnum[i], val, EFeedbackMode::DOT_MODE);
+		FHapticFeedback Feedback = FHapticFeedback(Device, val, EFeedbackMode::DOT_MODE);
 		ChangedFeedbacks.Add(Feedback);
 	}
 
 	return ChangedFeedbacks;
 }
 
+bool BhapticsLibrary::Lib_GetResponseStatusSince(uint64& Version, TArray<FHapticFeedback>& Feedbacks)
+{
+	if (!IsLoaded)
+	{
+		return false;
+	}
+#if !BHAPTICS_LIBRARY_EXTENSIONS
+	// The original library cannot tell whether the status changed, so every call reports it.
+	Feedbacks = Lib_GetResponseStatus();
+	Version++;
+	return true;
+#else
+	SCOPE_CYCLE_COUNTER(STAT_HapticsStatus);
+	uint64_t StatusVersion = Version;
+	bhaptics::DeviceStatus Status;
+	if (!GetResponseStatusSince(StatusVersion, Status))
+	{
+		return false;
+	}
+	Version = StatusVersion;
+
+	// Filled in place so a caller polling every frame reuses the same arrays.
+	const TArray<EPosition>& Listed = ListedPositions();
+	Feedbacks.SetNum(Listed.Num());
+	for (int32 i = 0; i < Listed.Num(); i++)
+	{
+		FHapticFeedback& Feedback = Feedbacks[i];
+		Feedback.Position = Listed[i];
+		Feedback.Mode = EFeedbackMode::DOT_MODE;
+		Feedback.Values.SetNumUninitialized(bhaptics::motorCount(ToHapticPosition(Listed[i])));
+
+		const uint8_t* Motors = Status.values(ToHapticPosition(Listed[i]));
+		if (Motors == nullptr)
+		{
+			FMemory::Memzero(Feedback.Values.GetData(), Feedback.Values.Num());
+			continue;
+		}
+		FMemory::Memcpy(Feedback.Values.GetData(), Motors, Feedback.Values.Num());
+	}
+	return true;
+#endif
+}
+
+
+void BhapticsLibrary::Lib_GetStats(bhaptics::HapticStats& Stats)
+{
+	if (!IsLoaded)
+	{
+		Stats = bhaptics::HapticStats();
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	GetHapticStats(Stats);
+#else
+	Stats = bhaptics::HapticStats();
+#endif
+}
+
+void BhapticsLibrary::Lib_GetLinkLatency(bhaptics::LinkLatency& Latency)
+{
+	if (!IsLoaded)
+	{
+		Latency = bhaptics::LinkLatency();
+		return;
+	}
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	GetLinkLatency(Latency);
+#else
+	Latency = bhaptics::LinkLatency();
+#endif
+}
+
+float BhapticsLibrary::Lib_GetLatencyMillis()
+{
+	bhaptics::LinkLatency Latency;
+	Lib_GetLinkLatency(Latency);
+	return Latency.LeadMicros / 1000.0f;
+}
+
+bool BhapticsLibrary::LogSubmitLatency(float DeltaTime)
+{
+	Lib_LogSubmitLatency();
+	return true;
+}
+
+void BhapticsLibrary::Lib_LogSubmitLatency()
+{
+#if BHAPTICS_LIBRARY_EXTENSIONS
+	if (!IsLoaded)
+	{
+		return;
+	}
+
+	bhaptics::SubmitLatencyStats Stats;
+	GetSubmitLatency(Stats);
+	ResetSubmitLatency();
+
+	if (Stats.Total.Count == 0 && Stats.Enqueue.Count == 0)
+	{
+		return;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("bHaptics submit latency (us, p50/p99/max) over %llu submits: serialize %llu/%llu/%llu, enqueue %llu/%llu/%llu, send %llu/%llu/%llu, total %llu/%llu/%llu"),
+		Stats.Enqueue.Count,
+		Stats.Serialize.P50Micros, Stats.Serialize.P99Micros, Stats.Serialize.MaxMicros,
+		Stats.Enqueue.P50Micros, Stats.Enqueue.P99Micros, Stats.Enqueue.MaxMicros,
+		Stats.Send.P50Micros, Stats.Send.P99Micros, Stats.Send.MaxMicros,
+		Stats.Total.P50Micros, Stats.Total.P99Micros, Stats.Total.MaxMicros);
+
+	bhaptics::LinkLatency Latency;
+	GetLinkLatency(Latency);
+	if (Latency.RoundTripSamples > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("bHaptics link latency (us): round trip %llu +/- %llu (min %llu), Player processing %llu, onset lead %llu"),
+			Latency.RoundTripMicros, Latency.RoundTripVarianceMicros, Latency.MinRoundTripMicros, Latency.ProcessingMicros, Latency.LeadMicros);
+	}
+#endif
+}
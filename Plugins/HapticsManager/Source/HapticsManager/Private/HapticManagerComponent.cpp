@@ -4,34 +4,27 @@
 #include "HapticStructures.h"
 
 #include "BhapticsLibrary.h"
-
-FCriticalSection UHapticManagerComponent::m_Mutex;
+#include "HapticsSubmissionManager.h"
+#include "HapticsAudioTap.h"
+#include "HapticsForceFeedbackBridge.h"
+#include "Engine/World.h"
 
 // Sets default values for this component's properties
 UHapticManagerComponent::UHapticManagerComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	// Submits are queued on the FHapticsSubmissionManager, which sends them once per frame, so the component never ticks.
+	PrimaryComponentTick.bCanEverTick = false;
 	FGuid Gui = FGuid::NewGuid();
 	Id = Gui.ToString();
 
 }
 
-// Called every frame
-void UHapticManagerComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-}
-
 void UHapticManagerComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	m_Mutex.Lock();
-	IsInitialised = BhapticsLibrary::InitialiseConnection();
-	m_Mutex.Unlock();
-	//IsInitialised = true;
+	FHapticsSubmissionManager* Manager = FHapticsSubmissionManager::Get();
+	IsInitialised = Manager != nullptr && Manager->EnsureConnection();
 }
 
 
@@ -48,7 +41,7 @@ void UHapticManagerComponent::SubmitFeedback(UFeedbackFile* Feedback)
 	{
 		BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, Feedback->ProjectString);
 	}
-	BhapticsLibrary::Lib_SubmitRegistered(FeedbackKey);
+	FHapticsSubmissionManager::Get()->SubmitRegistered(FeedbackKey);
 }
 
 void UHapticManagerComponent::SubmitFeedbackWithIntensityDuration(UFeedbackFile* Feedback, const FString &AltKey, FRotationOption RotationOption, FScaleOption ScaleOption,bool UseAltKey)
@@ -59,19 +52,26 @@ void UHapticManagerComponent::SubmitFeedbackWithIntensityDuration(UFeedbackFile*
 	}
 
 	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
-	FString UniqueKey = AltKey;
 
-	if (!UseAltKey)
+	if (!BhapticsLibrary::Lib_IsFeedbackRegistered(FeedbackKey))
 	{
-		 UniqueKey = Feedback->Key + FString::FromInt(FMath::Rand());
+		BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, Feedback->ProjectString);
 	}
 
-	if (!BhapticsLibrary::Lib_IsFeedbackRegistered(FeedbackKey))
+	if (!UseAltKey && bAggregateHits)
 	{
-		BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, Feedback->ProjectString);
+		FHapticsSubmissionManager::Get()->SubmitHit(FeedbackKey, ScaleOption, RotationOption, HitMergeAngle, HitMergeOffsetY);
+		return;
+	}
+
+	FString UniqueKey = AltKey;
+
+	if (!UseAltKey)
+	{
+		 UniqueKey = Feedback->Key + FString::FromInt(FMath::Rand());
 	}
 
-	BhapticsLibrary::Lib_SubmitRegistered(FeedbackKey, UniqueKey, ScaleOption, RotationOption);
+	FHapticsSubmissionManager::Get()->SubmitRegistered(FeedbackKey, UniqueKey, ScaleOption, RotationOption);
 }
 
 void UHapticManagerComponent::SubmitFeedbackWithTransform(UFeedbackFile* Feedback, const FString &AltKey, FRotationOption RotationOption, bool UseAltKey)
@@ -83,6 +83,20 @@ void UHapticManagerComponent::SubmitFeedbackWithTransform(UFeedbackFile* Feedbac
 	SubmitFeedbackWithIntensityDuration(Feedback, AltKey, RotationOption, FScaleOption(1, 1),UseAltKey);
 }
 
+void UHapticManagerComponent::SubmitFeedbackAtLocations(UFeedbackFile* Feedback, const TArray<FVector>& Locations, UPrimitiveComponent* HitComponent, float HalfHeight, FScaleOption ScaleOption)
+{
+	if (!IsInitialised || Feedback == NULL)
+	{
+		return;
+	}
+
+	TArray<FRotationOption> Rotations = CustomProjectToVestBatch(Locations, HitComponent, HalfHeight);
+	for (const FRotationOption& Rotation : Rotations)
+	{
+		SubmitFeedbackWithIntensityDuration(Feedback, FString(), Rotation, ScaleOption);
+	}
+}
+
 void UHapticManagerComponent::RegisterFeedbackFile(const FString &Key, UFeedbackFile* Feedback)
 {
 	if (!IsInitialised || Feedback == NULL)
@@ -102,7 +116,7 @@ void UHapticManagerComponent::SubmitBytes(const FString &Key, EPosition Position
 		return;
 	}
 
-	BhapticsLibrary::Lib_Submit(Key, PositionEnum, InputBytes, DurationInMilliSecs);
+	FHapticsSubmissionManager::Get()->SubmitBytes(Key, PositionEnum, InputBytes, DurationInMilliSecs);
 }
 
 void UHapticManagerComponent::SubmitDots(const FString &Key, EPosition PositionEnum, const TArray<FDotPoint> DotPoints, int32 DurationInMilliSecs)
@@ -111,7 +125,7 @@ void UHapticManagerComponent::SubmitDots(const FString &Key, EPosition PositionE
 	{
 		return;
 	}
-	BhapticsLibrary::Lib_Submit(Key, PositionEnum, DotPoints, DurationInMilliSecs);
+	FHapticsSubmissionManager::Get()->SubmitDots(Key, PositionEnum, DotPoints, DurationInMilliSecs);
 }
 
 void UHapticManagerComponent::SubmitPath(const FString &Key, EPosition PositionEnum, const TArray<FPathPoint>PathPoints, int32 DurationInMilliSecs)
@@ -120,7 +134,7 @@ void UHapticManagerComponent::SubmitPath(const FString &Key, EPosition PositionE
 	{
 		return;
 	}
-	BhapticsLibrary::Lib_Submit(Key, PositionEnum, PathPoints, DurationInMilliSecs);
+	FHapticsSubmissionManager::Get()->SubmitPath(Key, PositionEnum, PathPoints, DurationInMilliSecs);
 }
 
 bool UHapticManagerComponent::IsAnythingPlaying()
@@ -165,8 +179,7 @@ void UHapticManagerComponent::TurnOffAllFeedback()
 	{
 		return;
 	}
-	//bhaptics::HapticPlayer::instance()->turnOff();
-	BhapticsLibrary::Lib_TurnOff();
+	FHapticsSubmissionManager::Get()->TurnOffAll();
 }
 
 void UHapticManagerComponent::TurnOffRegisteredFeedback(const FString &Key)
@@ -175,8 +188,7 @@ void UHapticManagerComponent::TurnOffRegisteredFeedback(const FString &Key)
 	{
 		return;
 	}
-	//bhaptics::HapticPlayer::instance()->turnOff(StandardKey);
-	BhapticsLibrary::Lib_TurnOff(Key);
+	FHapticsSubmissionManager::Get()->TurnOff(Key);
 }
 
 void UHapticManagerComponent::TurnOffRegisteredFeedbackFile(UFeedbackFile* Feedback)
@@ -191,7 +203,138 @@ void UHapticManagerComponent::TurnOffRegisteredFeedbackFile(UFeedbackFile* Feedb
 	}
 	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
 
-	BhapticsLibrary::Lib_TurnOff(FeedbackKey);
+	FHapticsSubmissionManager::Get()->TurnOff(FeedbackKey);
+}
+
+void UHapticManagerComponent::SubmitFeedbackAfterDelay(UFeedbackFile* Feedback, int32 DelayInMilliSecs)
+{
+	if (!IsInitialised || Feedback == NULL)
+	{
+		return;
+	}
+
+	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
+
+	if (!BhapticsLibrary::Lib_IsFeedbackRegistered(FeedbackKey))
+	{
+		BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, Feedback->ProjectString);
+	}
+
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Registered;
+	Submission.Key = FeedbackKey;
+	FHapticsSubmissionManager::Get()->Schedule(MoveTemp(Submission), DelayInMilliSecs);
+}
+
+void UHapticManagerComponent::SubmitFeedbackAtOnset(UFeedbackFile* Feedback, int32 OnsetInMilliSecs)
+{
+	if (!IsInitialised || Feedback == NULL)
+	{
+		return;
+	}
+
+	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
+
+	if (!BhapticsLibrary::Lib_IsFeedbackRegistered(FeedbackKey))
+	{
+		BhapticsLibrary::Lib_RegisterFeedback(FeedbackKey, Feedback->ProjectString);
+	}
+
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Registered;
+	Submission.Key = FeedbackKey;
+	FHapticsSubmissionManager::Get()->ScheduleAtOnset(MoveTemp(Submission), OnsetInMilliSecs);
+}
+
+float UHapticManagerComponent::GetHapticLatency()
+{
+	if (!IsInitialised)
+	{
+		return 0.0f;
+	}
+	return BhapticsLibrary::Lib_GetLatencyMillis();
+}
+
+void UHapticManagerComponent::PlayProceduralFeedback(const FString &Key, const FProceduralFeedback& Feedback)
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	BhapticsLibrary::Lib_PlayProcedural(Key, Feedback);
+}
+
+bool UHapticManagerComponent::UpdateProceduralFeedback(const FString &Key, const FProceduralFeedback& Feedback)
+{
+	if (!IsInitialised)
+	{
+		return false;
+	}
+	return BhapticsLibrary::Lib_UpdateProcedural(Key, Feedback);
+}
+
+void UHapticManagerComponent::ReleaseProceduralFeedback(const FString &Key)
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	BhapticsLibrary::Lib_ReleaseProcedural(Key);
+}
+
+void UHapticManagerComponent::StartAudioHaptics(USoundSubmix* Submix, const FAudioHapticsSettings& Settings)
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	FHapticsAudioTap::Start(GetWorld(), Submix, Settings);
+}
+
+void UHapticManagerComponent::StopAudioHaptics()
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	FHapticsAudioTap::Stop();
+}
+
+void UHapticManagerComponent::StartForceFeedbackHaptics(APlayerController* Player, const FForceFeedbackHapticsSettings& Settings)
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	if (Player == nullptr && GetWorld() != nullptr)
+	{
+		Player = GetWorld()->GetFirstPlayerController();
+	}
+	FHapticsForceFeedbackBridge::Start(Player, Settings);
+}
+
+void UHapticManagerComponent::StopForceFeedbackHaptics(APlayerController* Player)
+{
+	if (!IsInitialised)
+	{
+		return;
+	}
+	if (Player == nullptr && GetWorld() != nullptr)
+	{
+		Player = GetWorld()->GetFirstPlayerController();
+	}
+	FHapticsForceFeedbackBridge::Stop(Player);
+}
+
+void UHapticManagerComponent::CancelDelayedFeedback(UFeedbackFile* Feedback)
+{
+	if (!IsInitialised || Feedback == NULL)
+	{
+		return;
+	}
+	FString FeedbackKey = Feedback->Key + Feedback->Id.ToString();
+
+	FHapticsSubmissionManager::Get()->CancelScheduled(FeedbackKey);
 }
 
 void UHapticManagerComponent::EnableHapticFeedback()
@@ -312,13 +455,107 @@ FRotationOption UHapticManagerComponent::CustomProjectToVest(FVector Location, U
 	return FRotationOption(Angle, Y_Offset);
 }
 
+// Atan2 in degrees, accurate to about 0.001 degrees. Branch-free apart from selects, so the batch loop vectorizes.
+static FORCEINLINE float FastAtan2Degrees(float Y, float X)
+{
+	const float AbsX = FMath::Abs(X);
+	const float AbsY = FMath::Abs(Y);
+	const float Ratio = FMath::Min(AbsX, AbsY) / FMath::Max(FMath::Max(AbsX, AbsY), SMALL_NUMBER);
+	const float Square = Ratio * Ratio;
+	float Angle = Ratio * (0.99997726f + Square * (-0.33262347f + Square * (0.19354346f + Square * (-0.11643287f + Square * (0.05265332f + Square * -0.01172120f)))));
+	Angle = AbsY > AbsX ? HALF_PI - Angle : Angle;
+	Angle = X < 0 ? PI - Angle : Angle;
+	Angle = Y < 0 ? -Angle : Angle;
+	return FMath::RadiansToDegrees(Angle);
+}
+
+TArray<FRotationOption> UHapticManagerComponent::CustomProjectToVestBatch(const TArray<FVector>& Locations, UPrimitiveComponent* HitComponent, float HalfHeight, FVector UpVector, FVector ForwardVector)
+{
+	TArray<FRotationOption> Rotations;
+	if (HitComponent == nullptr)
+	{
+		Rotations.Init(FRotationOption(0, 0), Locations.Num());
+		return Rotations;
+	}
+
+	// Everything that depends only on the component is computed once, as in CustomProjectToVest.
+	FRotator InverseRotation = HitComponent->GetComponentRotation().GetInverse();
+	FRotationMatrix InverseMatrix(InverseRotation);
+	FVector Origin = HitComponent->GetComponentLocation();
+	FVector InverseScale = FVector(1.0f) / HitComponent->GetComponentScale();
+	UpVector = InverseMatrix.TransformVector(UpVector == FVector::ZeroVector ? HitComponent->GetUpVector() : UpVector);
+	ForwardVector = InverseMatrix.TransformVector(ForwardVector == FVector::ZeroVector ? HitComponent->GetForwardVector() : ForwardVector);
+	UpVector.Normalize();
+	ForwardVector.Normalize();
+
+	// The hits are moved into component space first, then projected as separate X, Y and Z streams, which keeps the
+	// second loop free of calls and branches so the compiler can vectorize it.
+	const int32 Count = Locations.Num();
+	TArray<float> X, Y, Z, Angles, Offsets;
+	X.SetNumUninitialized(Count);
+	Y.SetNumUninitialized(Count);
+	Z.SetNumUninitialized(Count);
+	Angles.SetNumUninitialized(Count);
+	Offsets.SetNumUninitialized(Count);
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		const FVector HitPoint = InverseMatrix.TransformVector(Locations[i] - Origin) * InverseScale;
+		X[i] = HitPoint.X;
+		Y[i] = HitPoint.Y;
+		Z[i] = HitPoint.Z;
+	}
+
+	const FVector Up = UpVector;
+	const FVector Forward = ForwardVector;
+	const float InverseHeight = 1.0f / (HalfHeight * 2);
+	for (int32 i = 0; i < Count; i++)
+	{
+		const float DotProduct = X[i] * Up.X + Y[i] * Up.Y + Z[i] * Up.Z;
+		const float RX = X[i] - DotProduct * Up.X;
+		const float RY = Y[i] - DotProduct * Up.Y;
+		const float RZ = Z[i] - DotProduct * Up.Z;
+
+		// Atan2 only depends on the direction of the projected hit, so it is not normalized.
+		const float A = RX * Forward.Y - Forward.X * RY + RY * Forward.Z - Forward.Y * RZ + RZ * Forward.X - Forward.Z * RX;
+		const float B = Forward.X * RX + RY * Forward.Y + RZ * Forward.Z;
+
+		Angles[i] = FastAtan2Degrees(A, B);
+		Offsets[i] = FMath::Clamp(DotProduct * InverseHeight, -0.5f, 0.5f);
+	}
+
+	Rotations.Reserve(Count);
+	for (int32 i = 0; i < Count; i++)
+	{
+		Rotations.Add(FRotationOption(Angles[i], Offsets[i]));
+	}
+	return Rotations;
+}
+
 bool UHapticManagerComponent::IsDeviceConnected(EPosition device)
 {
 	if (!IsInitialised)
 	{
 		return false;
 	}
-	bool Value = false;
-	Value = BhapticsLibrary::Lib_IsDevicePlaying(device);
-	return Value;
+	return BhapticsLibrary::Lib_IsDeviceConnected(BhapticsLibrary::Lib_GetConnectedDeviceMask(), device);
+}
+
+int32 UHapticManagerComponent::GetConnectedDeviceMask()
+{
+	if (!IsInitialised)
+	{
+		return 0;
+	}
+	return BhapticsLibrary::Lib_GetConnectedDeviceMask();
+}
+
+bool UHapticManagerComponent::IsDeviceInMask(int32 DeviceMask, EPosition device)
+{
+	return BhapticsLibrary::Lib_IsDeviceConnected(DeviceMask, device);
+}
+
+int32 UHapticManagerComponent::GetDeviceMotorCount(EPosition device)
+{
+	return BhapticsLibrary::Lib_GetMotorCount(device);
 }
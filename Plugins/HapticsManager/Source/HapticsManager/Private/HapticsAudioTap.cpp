@@ -0,0 +1,62 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#include "HapticsAudioTap.h"
+#include "AudioDeviceManager.h"
+#include "AudioThread.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "BhapticsLibrary.h"
+
+FHapticsAudioTap FHapticsAudioTap::Instance;
+
+void FHapticsAudioTap::Start(UWorld* World, USoundSubmix* Submix, const FAudioHapticsSettings& Settings)
+{
+	Stop();
+	FAudioDevice* AudioDevice = World != nullptr ? World->GetAudioDevice() : nullptr;
+	if (AudioDevice == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Audio haptics need an audio device."));
+		return;
+	}
+	if (!AudioDevice->IsAudioMixerEnabled())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Audio haptics need the audio mixer; run with -audiomixer."));
+		return;
+	}
+
+	BhapticsLibrary::Lib_SetAudioHaptics(Settings);
+	Instance.bFeeding = true;
+	AudioDevice->RegisterSubmixBufferListener(&Instance, Submix);
+	Instance.bRegistered = true;
+	Instance.DeviceHandle = AudioDevice->DeviceHandle;
+	Instance.Submix = Submix;
+}
+
+void FHapticsAudioTap::Stop()
+{
+	if (!Instance.bRegistered)
+	{
+		return;
+	}
+	Instance.bRegistered = false;
+	Instance.bFeeding = false;
+	FAudioDeviceManager* DeviceManager = GEngine != nullptr ? GEngine->GetAudioDeviceManager() : nullptr;
+	FAudioDevice* AudioDevice = DeviceManager != nullptr ? DeviceManager->GetAudioDevice(Instance.DeviceHandle) : nullptr;
+	if (AudioDevice != nullptr)
+	{
+		// Unregistering is queued to the audio thread, and it takes the submix's listener lock, so once the queue is
+		// flushed no OnNewSubmixBuffer is running or will run.
+		AudioDevice->UnregisterSubmixBufferListener(&Instance, Instance.Submix.Get());
+		FlushAudioRenderingCommands();
+	}
+	BhapticsLibrary::Lib_SetAudioHaptics(FAudioHapticsSettings());
+}
+
+void FHapticsAudioTap::OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 NumChannels, const int32 SampleRate, double AudioClock)
+{
+	if (!bFeeding || NumChannels <= 0)
+	{
+		return;
+	}
+	BhapticsLibrary::Lib_FeedAudio(AudioData, NumSamples / NumChannels, NumChannels, SampleRate);
+}
@@ -0,0 +1,33 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AudioDevice.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HapticStructures.h"
+
+// Passes every buffer of one submix to the HapticLibrary's audio haptics. OnNewSubmixBuffer runs on the audio render
+// thread, so it only hands the samples over; the analysis never blocks the mixer.
+class FHapticsAudioTap : public ISubmixBufferListener
+{
+public:
+	// Listens to Submix, or the master submix if it is null, on World's audio device, replacing any submix listened to
+	// before. Game thread only.
+	static void Start(UWorld* World, USoundSubmix* Submix, const FAudioHapticsSettings& Settings);
+
+	// Stops listening and waits until the audio thread has processed it, so no buffer reaches the library afterwards
+	// and it can be unloaded. Game thread only.
+	static void Stop();
+
+	virtual void OnNewSubmixBuffer(const USoundSubmix* OwningSubmix, float* AudioData, int32 NumSamples, int32 NumChannels, const int32 SampleRate, double AudioClock) override;
+
+private:
+	// The audio device may call a listener until it has processed the unregistration, so the tap is never destroyed.
+	static FHapticsAudioTap Instance;
+
+	bool bRegistered = false;
+	FThreadSafeBool bFeeding; // read by the audio render thread, so it stops before the unregistration is processed
+	uint32 DeviceHandle = 0;
+	TWeakObjectPtr<USoundSubmix> Submix;
+};
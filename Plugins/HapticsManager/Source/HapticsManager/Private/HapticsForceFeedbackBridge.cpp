@@ -0,0 +1,179 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#include "HapticsForceFeedbackBridge.h"
+#include "GameFramework/ForceFeedbackEffect.h"
+#include "GameFramework/PlayerController.h"
+#include "BhapticsLibrary.h"
+#include "HapticsSubmissionManager.h"
+
+namespace
+{
+	// Each frame is submitted to last this long and resent at half of it while unchanged, so a hitch of a few frames
+	// does not cut the feedback and a steady rumble costs only a few messages a second.
+	const int32 FrameMillis = 100;
+
+	FString DeviceKey(EPosition Position)
+	{
+		return FString::Printf(TEXT("ForceFeedback%d"), (int32)Position);
+	}
+
+	bool SameDots(const TArray<FDotPoint>& A, const TArray<FDotPoint>& B)
+	{
+		if (A.Num() != B.Num())
+		{
+			return false;
+		}
+		for (int32 i = 0; i < A.Num(); i++)
+		{
+			if (A[i].Index != B[i].Index || A[i].Intensity != B[i].Intensity)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TArray<FHapticsForceFeedbackBridge::FPlayer> FHapticsForceFeedbackBridge::Players;
+TArray<FHapticsForceFeedbackBridge::FDeviceFrame> FHapticsForceFeedbackBridge::Devices;
+
+void FHapticsForceFeedbackBridge::Start(APlayerController* Player, const FForceFeedbackHapticsSettings& Settings)
+{
+	if (Player == nullptr)
+	{
+		return;
+	}
+	for (FPlayer& Existing : Players)
+	{
+		if (Existing.Controller.Get() == Player)
+		{
+			Existing.Settings = Settings;
+			return;
+		}
+	}
+	FPlayer Added;
+	Added.Controller = Player;
+	Added.Settings = Settings;
+	Players.Add(MoveTemp(Added));
+}
+
+void FHapticsForceFeedbackBridge::Stop(APlayerController* Player)
+{
+	Players.RemoveAll([Player](const FPlayer& Existing) { return Existing.Controller.Get() == Player; });
+}
+
+void FHapticsForceFeedbackBridge::Reset()
+{
+	Players.Reset();
+	Devices.Reset();
+}
+
+void FHapticsForceFeedbackBridge::Tick(FHapticsSubmissionManager& Manager)
+{
+	if (Players.Num() == 0 && Devices.Num() == 0)
+	{
+		return;
+	}
+
+	// Left and right value of every routed device, the strongest over all players.
+	TArray<EPosition, TInlineAllocator<8>> Positions;
+	TArray<FVector2D, TInlineAllocator<8>> Sides;
+	for (int32 i = Players.Num() - 1; i >= 0; i--)
+	{
+		APlayerController* Controller = Players[i].Controller.Get();
+		if (Controller == nullptr)
+		{
+			Players.RemoveAtSwap(i);
+			continue;
+		}
+
+		float LeftLarge, LeftSmall, RightLarge, RightSmall;
+		EvaluateChannels(*Controller, LeftLarge, LeftSmall, RightLarge, RightSmall);
+		for (const FForceFeedbackHapticsRoute& Route : Players[i].Settings.Routes)
+		{
+			float Left = Route.Gain * FMath::Max(LeftLarge * Route.LargeGain, LeftSmall * Route.SmallGain);
+			float Right = Route.Gain * FMath::Max(RightLarge * Route.LargeGain, RightSmall * Route.SmallGain);
+			int32 Index = Positions.Find(Route.Position);
+			if (Index == INDEX_NONE)
+			{
+				Index = Positions.Add(Route.Position);
+				Sides.Add(FVector2D::ZeroVector);
+			}
+			Sides[Index].X = FMath::Max(Sides[Index].X, Left);
+			Sides[Index].Y = FMath::Max(Sides[Index].Y, Right);
+		}
+	}
+
+	double Now = FPlatformTime::Seconds();
+	TArray<EPosition, TInlineAllocator<8>> Playing;
+	TArray<FDotPoint> Dots;
+	for (int32 i = 0; i < Positions.Num(); i++)
+	{
+		BhapticsLibrary::Lib_GetSideDots(Positions[i], Sides[i].X, Sides[i].Y, Dots);
+		if (Dots.Num() == 0)
+		{
+			continue;
+		}
+		Playing.Add(Positions[i]);
+
+		FDeviceFrame* Device = Devices.FindByPredicate([&](const FDeviceFrame& Frame) { return Frame.Position == Positions[i]; });
+		if (Device == nullptr)
+		{
+			Device = &Devices[Devices.AddDefaulted()];
+			Device->Position = Positions[i];
+		}
+		else if (SameDots(Device->Dots, Dots) && Now - Device->SubmitSeconds < FrameMillis / 2000.0)
+		{
+			continue;
+		}
+		Manager.SubmitDots(DeviceKey(Positions[i]), Positions[i], Dots, FrameMillis);
+		Device->Dots = Dots;
+		Device->SubmitSeconds = Now;
+	}
+
+	// Devices that went quiet stop at once rather than when their last frame expires.
+	for (int32 i = Devices.Num() - 1; i >= 0; i--)
+	{
+		if (!Playing.Contains(Devices[i].Position))
+		{
+			Manager.TurnOff(DeviceKey(Devices[i].Position));
+			Devices.RemoveAtSwap(i);
+		}
+	}
+}
+
+void FHapticsForceFeedbackBridge::EvaluateChannels(const APlayerController& Player, float& LeftLarge, float& LeftSmall, float& RightLarge, float& RightSmall)
+{
+	LeftLarge = LeftSmall = RightLarge = RightSmall = 0.0f;
+	if (!Player.bForceFeedbackEnabled)
+	{
+		return;
+	}
+
+	// The controller plays the strongest effect on each motor, so the devices do too.
+	for (const FActiveForceFeedbackEffect& Active : Player.ActiveForceFeedbackEffects)
+	{
+		if (Active.ForceFeedbackEffect == nullptr)
+		{
+			continue;
+		}
+		float Duration = Active.ForceFeedbackEffect->GetDuration();
+		float EvalTime = Active.PlayTime;
+		if (Duration > 0.0f)
+		{
+			EvalTime = Active.Parameters.bLooping ? FMath::Fmod(Active.PlayTime, Duration) : FMath::Min(Active.PlayTime, Duration);
+		}
+		FForceFeedbackValues Values;
+		Active.ForceFeedbackEffect->GetValues(EvalTime, Values);
+		LeftLarge = FMath::Max(LeftLarge, Values.LeftLarge);
+		LeftSmall = FMath::Max(LeftSmall, Values.LeftSmall);
+		RightLarge = FMath::Max(RightLarge, Values.RightLarge);
+		RightSmall = FMath::Max(RightSmall, Values.RightSmall);
+	}
+
+	float Scale = Player.ForceFeedbackScale;
+	LeftLarge = FMath::Clamp(LeftLarge * Scale, 0.0f, 1.0f);
+	LeftSmall = FMath::Clamp(LeftSmall * Scale, 0.0f, 1.0f);
+	RightLarge = FMath::Clamp(RightLarge * Scale, 0.0f, 1.0f);
+	RightSmall = FMath::Clamp(RightSmall * Scale, 0.0f, 1.0f);
+}
@@ -0,0 +1,51 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/WeakObjectPtr.h"
+#include "HapticStructures.h"
+
+class APlayerController;
+class FHapticsSubmissionManager;
+
+// Plays the force feedback effects of player controllers on bHaptics devices, so gameplay keeps one set of
+// UForceFeedbackEffect assets instead of a .tact file for each. Every tick it evaluates the channels of each player's
+// active effects, takes the strongest value of every device over all players and queues one frame per device on the
+// FHapticsSubmissionManager. Game thread only.
+class FHapticsForceFeedbackBridge
+{
+public:
+	// Starts playing Player's force feedback as Settings route it, replacing the routes it had.
+	static void Start(APlayerController* Player, const FForceFeedbackHapticsSettings& Settings);
+
+	// Stops playing Player's force feedback; its devices stop on the next tick unless another player drives them.
+	static void Stop(APlayerController* Player);
+
+	// Queues this tick's frames. Called by the submission manager before it flushes.
+	static void Tick(FHapticsSubmissionManager& Manager);
+
+	// Forgets every player without sending anything.
+	static void Reset();
+
+private:
+	struct FPlayer
+	{
+		TWeakObjectPtr<APlayerController> Controller;
+		FForceFeedbackHapticsSettings Settings;
+	};
+
+	// What was last submitted to a device, so unchanged frames are only resent before they expire.
+	struct FDeviceFrame
+	{
+		EPosition Position;
+		TArray<FDotPoint> Dots;
+		double SubmitSeconds = 0.0;
+	};
+
+	// Strongest value of every controller motor over Player's active effects, scaled like the controller's.
+	static void EvaluateChannels(const APlayerController& Player, float& LeftLarge, float& LeftSmall, float& RightLarge, float& RightSmall);
+
+	static TArray<FPlayer> Players;
+	static TArray<FDeviceFrame> Devices;
+};
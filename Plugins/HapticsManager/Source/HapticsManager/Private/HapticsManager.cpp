@@ -3,6 +3,21 @@
 #include "HapticsManager.h"
 #include "BhapticsLibrary.h"
 #include "Interfaces/IPluginManager.h"
+#include "HapticsManagerStats.h"
+#include "HapticsSubmissionManager.h"
+#include "HapticsAudioTap.h"
+#include "HapticsForceFeedbackBridge.h"
+
+DEFINE_STAT(STAT_HapticsSubmit);
+DEFINE_STAT(STAT_HapticsRegister);
+DEFINE_STAT(STAT_HapticsStatus);
+DEFINE_STAT(STAT_HapticsVisualise);
+DEFINE_STAT(STAT_HapticsSubmitCount);
+DEFINE_STAT(STAT_HapticsMergedHits);
+
+#if defined(UE_TRACE_ENABLED) && UE_TRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE(HapticsChannel);
+#endif
 
 #define LOCTEXT_NAMESPACE "FHapticsManagerModule"
 void FHapticsManagerModule::StartupModule()
@@ -28,6 +43,7 @@ void FHapticsManagerModule::StartupModule()
 	if (HapticLibraryHandle != nullptr)
 	{
 		BhapticsLibrary::SetLibraryLoaded();
+		SubmissionManager = MakeUnique<FHapticsSubmissionManager>();
 	}
 	else
 	{
@@ -40,6 +56,16 @@ void FHapticsManagerModule::ShutdownModule()
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
 
+	FHapticsForceFeedbackBridge::Reset();
+	if (SubmissionManager.IsValid())
+	{
+		SubmissionManager->Flush();
+		SubmissionManager.Reset();
+	}
+
+	// The audio render thread must stop feeding the library before it is unloaded; Stop waits for it.
+	FHapticsAudioTap::Stop();
+
 	if (HapticLibraryHandle != nullptr)
 	{
 		BhapticsLibrary::Free();
@@ -3,8 +3,7 @@
 #include "HapticsManagerActor.h"
 #include "HapticStructures.h"
 #include "BhapticsLibrary.h"
-
-FCriticalSection AHapticsManagerActor::m_Mutex;
+#include "HapticsManagerStats.h"
 
 // Sets default values
 AHapticsManagerActor::AHapticsManagerActor()
@@ -27,85 +26,77 @@ void AHapticsManagerActor::BeginPlay()
 	Super::BeginPlay();
 	ChangedFeedbacks = {};
 
-	InitialiseDots(Tactal);
-	InitialiseDots(TactosyLeft);
-	InitialiseDots(TactosyRight);
-	InitialiseDots(TactotBack);
-	InitialiseDots(TactotFront);
-	InitialiseDots(TactGloveLeft);
-	InitialiseDots(TactGloveRight);
-	InitialiseDots(TactShoeLeft);
-	InitialiseDots(TactShoeRight);
-	
+	InitialiseAllDots();
 }
 
 // Called every frame
 void AHapticsManagerActor::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	SCOPE_CYCLE_COUNTER(STAT_HapticsVisualise);
 
-	if (IsTicking)
+	// Nothing is copied or redrawn until the Player reports different motor values.
+	if (!BhapticsLibrary::Lib_GetResponseStatusSince(StatusVersion, ChangedFeedbacks))
 	{
 		return;
 	}
 
-	IsTicking = true;
-
-	UpdateFeedback();
-	TArray<FHapticFeedback> Visualisation = ChangedFeedbacks;
-
-	for (int i = 0; i < Visualisation.Num(); i++)
+	for (const FHapticFeedback& Feedback : ChangedFeedbacks)
 	{
-		FHapticFeedback Feedback = Visualisation[i];
-
-		switch (Feedback.Position)
+		TArray<FHapticDotVisual>* Dots = DotsForPosition(Feedback.Position);
+		if (Dots != nullptr)
 		{
-		case EPosition::ForearmR:
-			VisualiseFeedback(Feedback, TactosyRight);
-			break;
-		case EPosition::ForearmL:
-			VisualiseFeedback(Feedback, TactosyLeft);
-			break;
-		case EPosition::VestFront:
-			VisualiseFeedback(Feedback, TactotFront);
-			break;
-		case EPosition::VestBack:
-			VisualiseFeedback(Feedback, TactotBack);
-			break;
-		case EPosition::Head:
-			VisualiseFeedback(Feedback, Tactal);
-			break;
-		case EPosition::HandL:
-			VisualiseFeedback(Feedback, TactGloveLeft);
-			break;
-		case EPosition::HandR:
-			VisualiseFeedback(Feedback, TactGloveRight);
-			break;
-		case EPosition::FootL:
-			VisualiseFeedback(Feedback, TactShoeLeft);
-			break;
-		case EPosition::FootR:
-			VisualiseFeedback(Feedback, TactShoeRight);
-			break;
-		default:
-			printf("Position not found.");
-			break;
+			VisualiseFeedback(Feedback, *Dots);
 		}
 	}
+}
 
-	ChangedFeedbacks.Empty();
-
-	IsTicking = false;
+TArray<FHapticDotVisual>* AHapticsManagerActor::DotsForPosition(EPosition Position)
+{
+	switch (Position)
+	{
+	case EPosition::ForearmR:
+		return &TactosyRightDots;
+	case EPosition::ForearmL:
+		return &TactosyLeftDots;
+	case EPosition::VestFront:
+		return &TactotFrontDots;
+	case EPosition::VestBack:
+		return &TactotBackDots;
+	case EPosition::Head:
+		return &TactalDots;
+	case EPosition::HandL:
+		return &TactGloveLeftDots;
+	case EPosition::HandR:
+		return &TactGloveRightDots;
+	case EPosition::FootL:
+		return &TactShoeLeftDots;
+	case EPosition::FootR:
+		return &TactShoeRightDots;
+	default:
+		return nullptr;
+	}
 }
 
-void AHapticsManagerActor::UpdateFeedback()
+void AHapticsManagerActor::InitialiseAllDots()
 {
-	//std::map<std::string, std::vector<int>> DeviceMotors = bhaptics::HapticPlayer::instance()->getResponseStatus();//fix
-	ChangedFeedbacks = BhapticsLibrary::Lib_GetResponseStatus();
+	InitialiseDots(Tactal, TactalDots);
+	InitialiseDots(TactosyLeft, TactosyLeftDots);
+	InitialiseDots(TactosyRight, TactosyRightDots);
+	InitialiseDots(TactotBack, TactotBackDots);
+	InitialiseDots(TactotFront, TactotFrontDots);
+	InitialiseDots(TactGloveLeft, TactGloveLeftDots);
+	InitialiseDots(TactGloveRight, TactGloveRightDots);
+	InitialiseDots(TactShoeLeft, TactShoeLeftDots);
+	InitialiseDots(TactShoeRight, TactShoeRightDots);
+
+	// The dots start idle; show the current status on the next tick.
+	StatusVersion = 0;
 }
 
-void AHapticsManagerActor::InitialiseDots(TArray<USceneComponent*> TactSuitItem, float Scale)
+void AHapticsManagerActor::InitialiseDots(const TArray<USceneComponent*>& TactSuitItem, TArray<FHapticDotVisual>& Dots, float Scale)
 {
+	Dots.Reset(TactSuitItem.Num());
 	for (int i = 0; i < TactSuitItem.Num(); i++)
 	{
 		UStaticMeshComponent* DotMesh = Cast<UStaticMeshComponent>(TactSuitItem[i]);
@@ -114,30 +105,37 @@ void AHapticsManagerActor::InitialiseDots(TArray<USceneComponent*> TactSuitItem,
 			continue;
 		}
 
+		// Dots are named after their motor, with a two character prefix.
+		FString ComponentName = DotMesh->GetName();
+		ComponentName.RemoveAt(0, 2);
+
 		UMaterialInstanceDynamic* DotMaterial = DotMesh->CreateAndSetMaterialInstanceDynamicFromMaterial(0, DotMesh->GetMaterial(0));
 		DotMaterial->SetVectorParameterValue("Base Color", FLinearColor(0.8, 0.8, 0.8, 1.0));
 		DotMesh->SetRelativeScale3D(FVector(0.3, 0.3*Scale, 0.5*Scale));
+
+		FHapticDotVisual Dot;
+		Dot.Mesh = DotMesh;
+		Dot.Material = DotMaterial;
+		Dot.MotorIndex = FCString::Atoi(*ComponentName);
+		Dot.Value = 0;
+		Dots.Add(Dot);
 	}
 }
 
-void AHapticsManagerActor::VisualiseFeedback(FHapticFeedback Feedback, TArray<USceneComponent*> TactSuitItem, float DeviceScale)
+void AHapticsManagerActor::VisualiseFeedback(const FHapticFeedback& Feedback, TArray<FHapticDotVisual>& Dots)
 {
-	for (int i = 0; i < TactSuitItem.Num(); i++)
+	for (FHapticDotVisual& Dot : Dots)
 	{
-		FString ComponentName = TactSuitItem[i]->GetName();
-		ComponentName.RemoveAt(0, 2);
-		float DotPosition = FCString::Atof(*ComponentName);
-		float Scale = Feedback.Values[DotPosition] / 100.0;
-		UStaticMeshComponent* DotMesh = Cast<UStaticMeshComponent>(TactSuitItem[i]);
-
-		if (DotMesh == NULL)
+		uint8 Value = Feedback.Values.IsValidIndex(Dot.MotorIndex) ? Feedback.Values[Dot.MotorIndex] : 0;
+		if (Value == Dot.Value)
 		{
 			continue;
 		}
+		Dot.Value = Value;
 
-		UMaterialInstanceDynamic* DotMaterial = Cast<UMaterialInstanceDynamic>(DotMesh->GetMaterial(0));
-		DotMaterial->SetVectorParameterValue("Base Color", FLinearColor(0.8 + Scale * 0.2, 0.8 + Scale * 0.01, 0.8 - Scale * 0.8, 1.0));
-		DotMesh->SetRelativeScale3D(FVector(0.3 + 0.15*(Scale*0.8), 0.3 + 0.15*(Scale*0.8), 0.5 + 0.15*(Scale*0.8)));
+		float Scale = Value / 100.0;
+		Dot.Material->SetVectorParameterValue("Base Color", FLinearColor(0.8 + Scale * 0.2, 0.8 + Scale * 0.01, 0.8 - Scale * 0.8, 1.0));
+		Dot.Mesh->SetRelativeScale3D(FVector(0.3 + 0.15*(Scale*0.8), 0.3 + 0.15*(Scale*0.8), 0.5 + 0.15*(Scale*0.8)));
 	}
 }
 
@@ -187,4 +185,9 @@ void AHapticsManagerActor::SetTactSuit(USceneComponent * SleeveLeft, USceneCompo
 		ShoeRight->GetChildrenComponents(false, TactShoeRight);
 	}
 
+	if (HasActorBegunPlay())
+	{
+		InitialiseAllDots();
+	}
+
 }
\ No newline at end of file
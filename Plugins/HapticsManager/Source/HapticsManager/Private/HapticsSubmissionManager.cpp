@@ -0,0 +1,208 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#include "HapticsSubmissionManager.h"
+#include "BhapticsLibrary.h"
+#include "HapticsManagerStats.h"
+#include "HapticsForceFeedbackBridge.h"
+
+FHapticsSubmissionManager* FHapticsSubmissionManager::Instance = nullptr;
+
+FHapticsSubmissionManager::FHapticsSubmissionManager()
+{
+	Instance = this;
+}
+
+FHapticsSubmissionManager::~FHapticsSubmissionManager()
+{
+	if (Instance == this)
+	{
+		Instance = nullptr;
+	}
+}
+
+FHapticsSubmissionManager* FHapticsSubmissionManager::Get()
+{
+	return Instance;
+}
+
+bool FHapticsSubmissionManager::EnsureConnection()
+{
+	FScopeLock Lock(&ConnectionLock);
+	return BhapticsLibrary::InitialiseConnection();
+}
+
+void FHapticsSubmissionManager::SubmitBytes(const FString& Key, EPosition Position, const TArray<uint8>& MotorBytes, int32 DurationMillis)
+{
+	int32 NumMotors = BhapticsLibrary::Lib_FitMotorBytes(Position, MotorBytes.Num());
+	if (NumMotors == INDEX_NONE)
+	{
+		return;
+	}
+
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Dots;
+	Submission.Key = Key;
+	Submission.Position = Position;
+	Submission.DurationMillis = DurationMillis;
+	for (int32 i = 0; i < NumMotors; i++)
+	{
+		if (MotorBytes[i] > 0)
+		{
+			Submission.Dots.Add(FDotPoint(i, MotorBytes[i]));
+		}
+	}
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::SubmitDots(const FString& Key, EPosition Position, const TArray<FDotPoint>& Points, int32 DurationMillis)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Dots;
+	Submission.Key = Key;
+	Submission.Position = Position;
+	Submission.DurationMillis = DurationMillis;
+	Submission.Dots = Points;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::SubmitPath(const FString& Key, EPosition Position, const TArray<FPathPoint>& Points, int32 DurationMillis)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Paths;
+	Submission.Key = Key;
+	Submission.Position = Position;
+	Submission.DurationMillis = DurationMillis;
+	Submission.Paths = Points;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::SubmitRegistered(const FString& Key)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Registered;
+	Submission.Key = Key;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::SubmitRegistered(const FString& Key, const FString& AltKey, FScaleOption ScaleOption, FRotationOption RotationOption)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Registered;
+	Submission.Key = Key;
+	Submission.AltKey = AltKey;
+	Submission.ScaleOption = ScaleOption;
+	Submission.RotationOption = RotationOption;
+	Submission.bHasOptions = true;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::SubmitHit(const FString& Key, FScaleOption ScaleOption, FRotationOption RotationOption, float MergeAngle, float MergeOffsetY)
+{
+	FScopeLock Lock(&PendingLock);
+	for (int32 i = Pending.Num() - 1; i >= 0; i--)
+	{
+		FHapticSubmission& Queued = Pending[i];
+		if (Queued.Type == EHapticSubmissionType::TurnOffAll || (Queued.Type == EHapticSubmissionType::TurnOff && Queued.Key == Key))
+		{
+			break;
+		}
+		if (Queued.HitCount == 0 || Queued.Key != Key)
+		{
+			continue;
+		}
+
+		float DeltaAngle = FMath::FindDeltaAngleDegrees(Queued.RotationOption.OffsetAngleX, RotationOption.OffsetAngleX);
+		float DeltaY = RotationOption.OffsetY - Queued.RotationOption.OffsetY;
+		if (FMath::Abs(DeltaAngle) > MergeAngle || FMath::Abs(DeltaY) > MergeOffsetY)
+		{
+			continue;
+		}
+
+		// Running average of the merged positions, taking the angle along the shorter arc.
+		Queued.HitCount++;
+		Queued.RotationOption.OffsetAngleX = FMath::UnwindDegrees(Queued.RotationOption.OffsetAngleX + DeltaAngle / Queued.HitCount);
+		Queued.RotationOption.OffsetY += DeltaY / Queued.HitCount;
+		Queued.ScaleOption.Intensity = FMath::Max(Queued.ScaleOption.Intensity, ScaleOption.Intensity);
+		Queued.ScaleOption.Duration = FMath::Max(Queued.ScaleOption.Duration, ScaleOption.Duration);
+		INC_DWORD_STAT(STAT_HapticsMergedHits);
+		return;
+	}
+
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::Registered;
+	Submission.Key = Key;
+	Submission.AltKey = FString::Printf(TEXT("%sHit%u"), *Key, NextHitId++);
+	Submission.ScaleOption = ScaleOption;
+	Submission.RotationOption = RotationOption;
+	Submission.bHasOptions = true;
+	Submission.HitCount = 1;
+	Pending.Add(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::TurnOff(const FString& Key)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::TurnOff;
+	Submission.Key = Key;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::TurnOffAll()
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::TurnOffAll;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::Schedule(FHapticSubmission&& Submission, int32 DelayMillis)
+{
+	Submission.DelayMillis = FMath::Max(DelayMillis, 0);
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::ScheduleAtOnset(FHapticSubmission&& Submission, int32 OnsetMillis)
+{
+	Submission.DelayMillis = FMath::Max(OnsetMillis, 0);
+	Submission.bAtOnset = true;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::CancelScheduled(const FString& Key)
+{
+	FHapticSubmission Submission;
+	Submission.Type = EHapticSubmissionType::CancelScheduled;
+	Submission.Key = Key;
+	Queue(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::Queue(FHapticSubmission&& Submission)
+{
+	FScopeLock Lock(&PendingLock);
+	Pending.Add(MoveTemp(Submission));
+}
+
+void FHapticsSubmissionManager::Flush()
+{
+	{
+		FScopeLock Lock(&PendingLock);
+		if (Pending.Num() == 0)
+		{
+			return;
+		}
+		Swap(Pending, Flushing);
+	}
+
+	BhapticsLibrary::Lib_SubmitBatch(Flushing);
+	Flushing.Reset();
+}
+
+void FHapticsSubmissionManager::Tick(float DeltaTime)
+{
+	FHapticsForceFeedbackBridge::Tick(*this);
+	Flush();
+}
+
+TStatId FHapticsSubmissionManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(FHapticsSubmissionManager, STATGROUP_Haptics);
+}
@@ -5,6 +5,14 @@
 #include "HapticStructures.h"
 #include "Engine/Engine.h"
 
+namespace bhaptics
+{
+	struct HapticStats;
+	struct LinkLatency;
+}
+
+struct FHapticSubmission;
+
 class HAPTICSMANAGER_API BhapticsLibrary
 {
 public:
@@ -27,6 +35,22 @@ public:
 
 	static void Lib_Submit(FString Key, EPosition Pos, TArray<FPathPoint> Points, int DurationMillis);
 
+	// Sends the queued submissions in one message; see FHapticsSubmissionManager.
+	static void Lib_SubmitBatch(const TArray<FHapticSubmission>& Submissions);
+
+	// Plays, updates and releases procedural feedback rendered by the HapticLibrary; Lib_TurnOff stops it at once.
+	static void Lib_PlayProcedural(FString Key, const FProceduralFeedback& Feedback);
+
+	static bool Lib_UpdateProcedural(FString Key, const FProceduralFeedback& Feedback);
+
+	static void Lib_ReleaseProcedural(FString Key);
+
+	// Plays the audio passed to Lib_FeedAudio as Settings routes it; no routes turns it off.
+	static void Lib_SetAudioHaptics(const FAudioHapticsSettings& Settings);
+
+	// Analyses interleaved samples for audio haptics. Called on the audio render thread; never locks or allocates.
+	static void Lib_FeedAudio(const float* Samples, int32 Frames, int32 Channels, int32 SampleRate);
+
 	static bool Lib_IsFeedbackRegistered(FString key);
 
 	static bool Lib_IsPlaying();
@@ -44,12 +68,50 @@ public:
 	static void Lib_ToggleFeedback();
 
 	static bool Lib_IsDevicePlaying(EPosition Pos);
+
+	// Bitmask of the devices connected to the Player, as of its last status; zero until the first one arrives.
+	// Lock-free, cheap enough to check before computing a feedback at all.
+	static int32 Lib_GetConnectedDeviceMask();
+
+	// Whether a mask from Lib_GetConnectedDeviceMask includes the device at Pos. Default is always included.
+	static bool Lib_IsDeviceConnected(int32 DeviceMask, EPosition Pos);
+
+	// Number of motors of the device at Pos, and of the Values the status functions return for it.
+	static int32 Lib_GetMotorCount(EPosition Pos);
+
+	// How many of NumBytes motor bytes to submit to the device at Pos: up to its motor count, since bytes past it address
+	// no motor. Fewer leave the remaining motors off. Returns INDEX_NONE, logging a warning, for more than the 20 bytes
+	// every device accepted before motor layouts.
+	static int32 Lib_FitMotorBytes(EPosition Pos, int32 NumBytes);
 	
+	// Dots that play Left on the left half of the device at Pos and Right on its right half, blending across the middle
+	// columns; a device worn on one side plays only that side. Values are from 0 to 1.
+	static void Lib_GetSideDots(EPosition Pos, float Left, float Right, TArray<FDotPoint>& Dots);
+
 	static void SetLibraryLoaded();
 
 	static TArray<FHapticFeedback> Lib_GetResponseStatus();
 
+	// Fills Feedbacks with the motor values of every device only if they changed since Version, which it then updates.
+	// Returns false, without copying anything, while the Player keeps reporting the same values. Start from 0.
+	static bool Lib_GetResponseStatusSince(uint64& Version, TArray<FHapticFeedback>& Feedbacks);
+
+	// Copies the haptics client's counters, see HapticStats in the HapticLibrary's model.h. Lock-free.
+	static void Lib_GetStats(bhaptics::HapticStats& Stats);
+
+	// Copies the round trip and Player processing delay measured by the haptics client, see LinkLatency in model.h.
+	static void Lib_GetLinkLatency(bhaptics::LinkLatency& Latency);
+
+	// Milliseconds between submitting feedback and feeling it: the lead Lib_GetLinkLatency reports.
+	static float Lib_GetLatencyMillis();
+
+	// Logs the submit latency per stage and the link latency, and starts a new measurement interval.
+	static void Lib_LogSubmitLatency();
+
 private:
+	static bool LogSubmitLatency(float DeltaTime);
+
+	static FDelegateHandle LatencyLogHandle;
 	static bool IsLoaded;
 	static bool IsInitialised;
 	static FProcHandle Handle;
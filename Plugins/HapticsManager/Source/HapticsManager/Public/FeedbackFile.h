@@ -32,5 +32,11 @@ public :
 	//Duration of the haptic feedback effect (in seconds)
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "FeedbackFile")
 		float Duration;
+
+#if WITH_EDITORONLY_DATA
+	//Absolute path of the .tact file this asset was imported from, used to hot-reload the feedback when the file changes.
+	UPROPERTY(VisibleAnywhere, AssetRegistrySearchable, Category = "FeedbackFile")
+		FString SourceFile;
+#endif
 };
 
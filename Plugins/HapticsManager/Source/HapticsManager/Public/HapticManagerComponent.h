@@ -7,6 +7,9 @@
 #include "FeedbackFile.h"
 #include "HapticManagerComponent.generated.h"
 
+class USoundSubmix;
+class APlayerController;
+
 
 UCLASS(ClassGroup = (bHaptics), meta = (BlueprintSpawnableComponent))
 class HAPTICSMANAGER_API UHapticManagerComponent : public UActorComponent
@@ -20,9 +23,6 @@ public:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
-
 	//Submit a haptic feedback file to be played by the Player.
 	UFUNCTION(BlueprintCallable,
 		meta = (DisplayName = "Submit Feedback",
@@ -56,7 +56,8 @@ public:
 		Category = "bHaptics")
 		void RegisterFeedbackFile(const FString &Key, UFeedbackFile* Feedback);
 
-	//Submit a haptic feeback pattern to the given device using a byte array.
+	//Submit a haptic feeback pattern to the given device using a byte array, one intensity per motor. Up to 20 bytes are
+	//accepted; those past the device's motor count (Get Device Motor Count) are ignored.
 	UFUNCTION(BlueprintCallable,
 		meta = (DisplayName = "Submit Using Bytes",
 			Keywords = "bHaptics"),
@@ -98,13 +99,35 @@ public:
 		Category = "bHaptics")
 	bool IsRegisteredFilePlaying(UFeedbackFile* Feedback);
 
-	//Is the given haptic device connected
+	//Is the given haptic device connected. False until the bHaptics Player has reported its devices
 	UFUNCTION(BlueprintPure,
 		meta = (DisplayName = "Is Device Connected",
 			Keywords = "bHaptics"),
 		Category = "bHaptics")
 		bool IsDeviceConnected(EPosition device);
 
+	//Bitmask of the connected haptic devices, for checking several devices, or the same device every frame, before
+	//computing their feedback (e.g. Project To Vest). Test it with Is Device In Mask.
+	UFUNCTION(BlueprintPure,
+		meta = (DisplayName = "Get Connected Device Mask",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		int32 GetConnectedDeviceMask();
+
+	//Is the given haptic device part of a mask returned by Get Connected Device Mask
+	UFUNCTION(BlueprintPure,
+		meta = (DisplayName = "Is Device In Mask",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		static bool IsDeviceInMask(int32 DeviceMask, EPosition device);
+
+	//Number of motors of the device, and of the values reported for it in the device status
+	UFUNCTION(BlueprintPure,
+		meta = (DisplayName = "Get Device Motor Count",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		static int32 GetDeviceMotorCount(EPosition device);
+
 	//Turn off all currently playing haptic feedback patterns
 	UFUNCTION(BlueprintCallable,
 		meta = (DisplayName = "Turn Off All Feedback",
@@ -128,6 +151,86 @@ public:
 		Category = "bHaptics")
 		void TurnOffRegisteredFeedbackFile(UFeedbackFile* Feedback);
 
+	//Submit a haptic feedback file to be played after the given delay, timed by the HapticLibrary rather than a game timer.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Submit Feedback After Delay",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void SubmitFeedbackAfterDelay(UFeedbackFile* Feedback, int32 DelayInMilliSecs);
+
+	//Submit a haptic feedback file to be felt after the given delay. It is sent early by the measured latency to the Player,
+	//so effects synced to sound or animation start on time; if the latency is longer than the delay it is sent right away.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Submit Feedback At Onset",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void SubmitFeedbackAtOnset(UFeedbackFile* Feedback, int32 OnsetInMilliSecs);
+
+	//Time in milliseconds between submitting feedback and feeling it, as measured on the connection to the Player.
+	UFUNCTION(BlueprintPure,
+		meta = (DisplayName = "Get Haptic Latency",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		float GetHapticLatency();
+
+	//Play a procedural feedback under the given Key, generated by the HapticLibrary without a feedback file.
+	//Playing the same Key again restarts it; Turn Off Feedback stops it at once.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Play Procedural Feedback",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void PlayProceduralFeedback(const FString &Key, const FProceduralFeedback& Feedback);
+
+	//Change the parameters of the procedural feedback playing under the given Key without restarting it, e.g. every tick
+	//to follow an engine's RPM. Returns false if it is not playing.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Update Procedural Feedback",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		bool UpdateProceduralFeedback(const FString &Key, const FProceduralFeedback& Feedback);
+
+	//Fade out the procedural feedback playing under the given Key over its release time.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Release Procedural Feedback",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void ReleaseProceduralFeedback(const FString &Key);
+
+	//Play feedback derived from the audio of the given Submix, or of the master submix if none is given, as the Settings
+	//route it to the devices. Requires the audio mixer.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Start Audio Haptics",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void StartAudioHaptics(USoundSubmix* Submix, const FAudioHapticsSettings& Settings);
+
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Stop Audio Haptics",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void StopAudioHaptics();
+
+	//Play the force feedback effects of the given Player, or of the first player if none is given, on the devices the
+	//Settings route them to. Effects keep playing on the controller as well.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Start Force Feedback Haptics",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void StartForceFeedbackHaptics(APlayerController* Player, const FForceFeedbackHapticsSettings& Settings);
+
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Stop Force Feedback Haptics",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void StopForceFeedbackHaptics(APlayerController* Player);
+
+	//Cancel the delayed submissions of the specified haptic feedback file that have not played yet.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Cancel Delayed Feedback",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void CancelDelayedFeedback(UFeedbackFile* Feedback);
+
 	//Enable haptic feedback
 	UFUNCTION(BlueprintCallable,
 		meta = (DisplayName = "Enable Feedback",
@@ -167,6 +270,35 @@ public:
 		Category = "bHaptics")
 		static FRotationOption CustomProjectToVest(FVector Location, UPrimitiveComponent* HitComponent, float HalfHeight = 50, FVector UpVector = FVector::ZeroVector, FVector ForwardVector = FVector::ZeroVector);
 
+	//Performs Custom Project To Vest for every location against the same component, in a single pass.
+	//Use it instead of calling Project To Vest per projectile when many hits land in the same frame.
+	UFUNCTION(BlueprintPure,
+		meta = (DisplayName = "Custom Project To Vest (Batch)",
+			Keywords = "bHaptics",
+			AdvancedDisplay = "3"),
+		Category = "bHaptics")
+		static TArray<FRotationOption> CustomProjectToVestBatch(const TArray<FVector>& Locations, UPrimitiveComponent* HitComponent, float HalfHeight = 50, FVector UpVector = FVector::ZeroVector, FVector ForwardVector = FVector::ZeroVector);
+
+	//Submit a haptic feedback file once per hit location, rotated onto the vest as with Project To Vest.
+	//With Aggregate Hits set, hits close to each other are merged into one submission.
+	UFUNCTION(BlueprintCallable,
+		meta = (DisplayName = "Submit Feedback at Hit Locations",
+			Keywords = "bHaptics"),
+		Category = "bHaptics")
+		void SubmitFeedbackAtLocations(UFeedbackFile* Feedback, const TArray<FVector>& Locations, UPrimitiveComponent* HitComponent, float HalfHeight, FScaleOption ScaleOption);
+
+	// Merge hits of the same feedback file submitted without an AltKey in the same frame, when they land within
+	// HitMergeAngle degrees and HitMergeOffsetY of each other. The merged hit plays at their average position,
+	// with the strongest intensity and longest duration among them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "bHaptics")
+	bool bAggregateHits = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "bHaptics", meta = (EditCondition = "bAggregateHits", ClampMin = "0", ClampMax = "180"))
+	float HitMergeAngle = 30;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "bHaptics", meta = (EditCondition = "bAggregateHits", ClampMin = "0", ClampMax = "1"))
+	float HitMergeOffsetY = 0.2;
+
 	// Set to check if the Player should launch when starting the level.
 	// If true, bHaptics Player will launch when the game is run, if its installed.
 	// If false, the user must launch the Player themselves.
@@ -174,7 +306,6 @@ public:
 	bool ComponentLaunch = true;
 	
 private:
-	static FCriticalSection m_Mutex;
 	bool IsInitialised = false;
 	FString Id;
 };
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "Engine/DeveloperSettings.h"
+#include "Engine/EngineTypes.h"
 #include "HapticSettings.generated.h"
 
 /**
@@ -24,4 +25,49 @@ public:
 	UPROPERTY(EditAnywhere, config, Category = Haptic)
 		bool bShouldLaunch = true;
 
+	// Offer permessage-deflate compression to the Player, shrinking the large registration payloads
+	// that are resent on every reconnect. Requires a HapticLibrary built with BHAPTICS_WS_DEFLATE, as HapticLibrary.sln
+	// does; the prebuilt DLLs must be rebuilt from it for this to take effect on Windows.
+	UPROPERTY(EditAnywhere, config, Category = Haptic)
+		bool bCompressTraffic = false;
+
+	// Drop byte, dot and path submits for devices the Player does not report as connected, before they are converted
+	// or sent. Registered feedback files are always sent. The dropped submits are counted as CulledSubmits.
+	UPROPERTY(EditAnywhere, config, Category = Haptic)
+		bool bCullDisconnectedDevices = false;
+
+	// Rotate and scale registered feedback files in the HapticLibrary and send the result as frames, instead of asking
+	// the Player to transform each hit under its own AltKey. Rotated hits then mix with each other on the vest.
+	UPROPERTY(EditAnywhere, config, Category = Haptic)
+		bool bTransformLocally = false;
+
+	// Turn path points into motor intensities in the HapticLibrary and send them as dot frames, which are smaller and
+	// mix with other feedback. Useful for effects that submit many path points per second.
+	UPROPERTY(EditAnywhere, config, Category = Haptic)
+		bool bRasterizePaths = false;
+
+	// Seconds between log lines reporting p50/p99/max submit latency, from the submit call to the frame leaving the socket.
+	// 0 disables the log line.
+	UPROPERTY(EditAnywhere, config, Category = Diagnostics, meta = (ClampMin = "0"))
+		float SubmitLatencyLogInterval = 0;
+
+	// Record every request sent to the Player to Saved/Haptics/Session-<time>.bhrec, to be replayed
+	// against the Player or the Mock Player with the HapticLibrary's Replayer tool.
+	UPROPERTY(EditAnywhere, config, Category = Diagnostics)
+		bool bRecordSession = false;
+
+	// Also record the status messages received from the Player.
+	UPROPERTY(EditAnywhere, config, Category = Diagnostics, meta = (EditCondition = "bRecordSession"))
+		bool bRecordStatus = false;
+
+	// Editor only: watch FeedbackSourceDirectory for .tact files re-exported from the bHaptics Designer.
+	// Changed files are re-parsed into their imported Feedback File assets and re-registered with the Player,
+	// so the new feedback plays without re-importing or restarting Play In Editor.
+	UPROPERTY(EditAnywhere, config, Category = HotReload)
+		bool bHotReloadFeedbackFiles = false;
+
+	// Directory containing the source .tact files of the imported Feedback File assets.
+	UPROPERTY(EditAnywhere, config, Category = HotReload, meta = (EditCondition = "bHotReloadFeedbackFiles"))
+		FDirectoryPath FeedbackSourceDirectory;
+
 };
@@ -24,6 +24,18 @@ enum class EFeedbackMode : uint8
 	DOT_MODE	UMETA(DisplayName = "DOTMODE")
 };
 
+//Waveform of a procedural feedback's oscillator.
+UENUM(BlueprintType)
+enum class EWaveShape : uint8
+{
+	Constant,
+	Sine,
+	Square,
+	Triangle,
+	Saw,
+	Noise
+};
+
 //Structure used to play individual motors on each device.
 USTRUCT(BlueprintType)
 struct FDotPoint
@@ -186,6 +198,167 @@ struct FScaleOption
 	}
 };
 
+//A feedback generated by the HapticLibrary from an envelope, an oscillator and a sweep across the motors, instead of
+//being designed as a feedback file. Its parameters may be changed while it plays.
+USTRUCT(BlueprintType)
+struct FProceduralFeedback
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		EPosition Position = EPosition::VestFront;
+
+	//Peak intensity of the motors, from 0 to 1.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		float Intensity = 1.0f;
+
+	//Time from the start to the release in milliseconds. 0 plays until the feedback is released or turned off.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		int32 DurationMillis = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Envelope)
+		int32 AttackMillis = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Envelope)
+		int32 DecayMillis = 0;
+
+	//Level held from the end of the decay to the release, from 0 to 1.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Envelope)
+		float SustainLevel = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Envelope)
+		int32 ReleaseMillis = 0;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Oscillator)
+		EWaveShape Shape = EWaveShape::Constant;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Oscillator)
+		float FrequencyHz = 0.0f;
+
+	//How far the oscillator swings the intensity, where 0 ignores it and 1 swings it fully to 0.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Oscillator)
+		float Depth = 1.0f;
+
+	//Seed of the noise waveform, so a feedback can be replayed identically.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Oscillator)
+		int32 Seed = 1;
+
+	//Bit i lets the feedback play motor i; -1 plays every motor.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		int32 MotorMask = -1;
+
+	//A spot SweepWidth motors wide either side moves from motor index SweepFrom to SweepTo over SweepMillis.
+	//A SweepMillis of 0 plays every motor evenly.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		float SweepFrom = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		float SweepTo = 0.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		float SweepWidth = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		int32 SweepMillis = 0;
+
+	//Start the sweep over each time it reaches SweepTo.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Motors)
+		bool bSweepLoop = false;
+};
+
+//Plays the level of four frequency bands of the game's audio on one device, with the bass at the bottom of the device
+//and the treble at the top. Devices with a single row of motors play the loudest band.
+USTRUCT(BlueprintType)
+struct FAudioHapticsRoute
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		EPosition Position = EPosition::VestFront;
+
+	//Multiplier of every motor's intensity.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		float Gain = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float BassGain = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float LowMidGain = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float HighMidGain = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float TrebleGain = 1.0f;
+};
+
+//How the HapticLibrary turns a submix's audio into feedback. The audio is split into bands at the three crossovers
+//and measured every 20 ms.
+USTRUCT(BlueprintType)
+struct FAudioHapticsSettings
+{
+	GENERATED_BODY()
+
+	//Upper edge of the bass band in Hz.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float BassCrossoverHz = 150.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float LowMidCrossoverHz = 600.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Bands)
+		float HighMidCrossoverHz = 2500.0f;
+
+	//Follow the peak of each band rather than its RMS level, which favours sharp transients such as gunshots.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Levels)
+		bool bUsePeak = false;
+
+	//Level in dB that plays as intensity 0; 0 dB plays as full intensity.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Levels)
+		float FloorDb = -48.0f;
+
+	//Time in milliseconds a band takes to fall from full intensity to 0 once it goes quiet.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Levels)
+		int32 ReleaseMillis = 100;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		TArray<FAudioHapticsRoute> Routes;
+};
+
+//Plays a player's force feedback on one device: the left motors of the controller on the left of the device and the
+//right motors on its right, blending across the middle. Devices worn on one side only play that side.
+USTRUCT(BlueprintType)
+struct FForceFeedbackHapticsRoute
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		EPosition Position = EPosition::VestFront;
+
+	//Multiplier of every motor's intensity.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		float Gain = 1.0f;
+
+	//Multiplier of the large, low frequency controller motors.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+		float LargeGain = 1.0f;
+
+	//Multiplier of the small, high frequency controller motors.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Channels)
+		float SmallGain = 0.5f;
+};
+
+//Which devices play the force feedback effects of a player controller.
+USTRUCT(BlueprintType)
+struct FForceFeedbackHapticsSettings
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Vars)
+		TArray<FForceFeedbackHapticsRoute> Routes;
+};
+
 class HAPTICSMANAGER_API HapticStructures
 {
 public:
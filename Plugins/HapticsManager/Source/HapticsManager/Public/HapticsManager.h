@@ -4,6 +4,8 @@
 
 #include "Modules/ModuleManager.h"
 
+class FHapticsSubmissionManager;
+
 class FHapticsManagerModule : public IModuleInterface
 {
 public:
@@ -16,4 +18,7 @@ private:
 	/** Handle to the test dll we will load */
 	void*	HapticLibraryHandle;
 
+	/** Batches the submits of every HapticManagerComponent, see FHapticsSubmissionManager */
+	TUniquePtr<FHapticsSubmissionManager> SubmissionManager;
+
 };
\ No newline at end of file
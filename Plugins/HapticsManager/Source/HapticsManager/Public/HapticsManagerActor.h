@@ -8,6 +8,14 @@
 #include "FeedbackFile.h"
 #include "HapticsManagerActor.generated.h"
 
+// A dot of the visualiser and the motor it shows, parsed from the component name once when the dots are set up.
+struct FHapticDotVisual
+{
+	UStaticMeshComponent* Mesh;
+	UMaterialInstanceDynamic* Material;
+	int32 MotorIndex;
+	uint8 Value;
+};
 
 UCLASS()
 class HAPTICSMANAGER_API AHapticsManagerActor : public AActor
@@ -55,11 +63,23 @@ public:
 			USceneComponent* GloveLeft, USceneComponent* GloveRight, USceneComponent* ShoeLeft, USceneComponent* ShoeRight);
 
 private:
-	static FCriticalSection m_Mutex;
-	bool IsTicking = false;
-	void UpdateFeedback();
-	void VisualiseFeedback(FHapticFeedback Feedback, TArray<USceneComponent*> TactoSuitItem, float DeviceScale = 1.0f);
-	void InitialiseDots(TArray<USceneComponent*> TactoSuitItem, float Scale = 1.0f);
+	// Status version of the motor values last shown, see BhapticsLibrary::Lib_GetResponseStatusSince.
+	uint64 StatusVersion = 0;
+
+	TArray<FHapticDotVisual> TactotFrontDots;
+	TArray<FHapticDotVisual> TactotBackDots;
+	TArray<FHapticDotVisual> TactosyLeftDots;
+	TArray<FHapticDotVisual> TactosyRightDots;
+	TArray<FHapticDotVisual> TactalDots;
+	TArray<FHapticDotVisual> TactGloveLeftDots;
+	TArray<FHapticDotVisual> TactGloveRightDots;
+	TArray<FHapticDotVisual> TactShoeLeftDots;
+	TArray<FHapticDotVisual> TactShoeRightDots;
+
+	TArray<FHapticDotVisual>* DotsForPosition(EPosition Position);
+	void InitialiseAllDots();
+	void VisualiseFeedback(const FHapticFeedback& Feedback, TArray<FHapticDotVisual>& Dots);
+	void InitialiseDots(const TArray<USceneComponent*>& TactSuitItem, TArray<FHapticDotVisual>& Dots, float Scale = 1.0f);
 	FString Id;
 
 };
\ No newline at end of file
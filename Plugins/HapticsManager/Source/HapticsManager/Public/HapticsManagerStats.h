@@ -0,0 +1,27 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+// "stat Haptics" shows the game thread cost of the calls into the HapticLibrary and of the visualiser.
+DECLARE_STATS_GROUP(TEXT("Haptics"), STATGROUP_Haptics, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Submit"), STAT_HapticsSubmit, STATGROUP_Haptics, HAPTICSMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Register"), STAT_HapticsRegister, STATGROUP_Haptics, HAPTICSMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Status Fetch"), STAT_HapticsStatus, STATGROUP_Haptics, HAPTICSMANAGER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Visualise"), STAT_HapticsVisualise, STATGROUP_Haptics, HAPTICSMANAGER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Submits"), STAT_HapticsSubmitCount, STATGROUP_Haptics, HAPTICSMANAGER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Merged Hits"), STAT_HapticsMergedHits, STATGROUP_Haptics, HAPTICSMANAGER_API);
+
+// Unreal Insights only exists from 4.26. Older engines still see each submit as a named event
+// (key, position and point count) in any profiler that captures named events, e.g. after "stat namedevents".
+#if ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 26
+#include "Trace/Trace.h"
+#endif
+
+#if defined(UE_TRACE_ENABLED) && UE_TRACE_ENABLED
+UE_TRACE_CHANNEL_EXTERN(HapticsChannel, HAPTICSMANAGER_API);
+#endif
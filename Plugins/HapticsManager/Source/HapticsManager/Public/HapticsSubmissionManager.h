@@ -0,0 +1,103 @@
+//Copyright bHaptics Inc. 2017-2019
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+#include "HapticStructures.h"
+
+enum class EHapticSubmissionType : uint8
+{
+	Dots,
+	Paths,
+	Registered,
+	TurnOff,
+	TurnOffAll,
+	CancelScheduled
+};
+
+// One request waiting for the next flush. Byte arrays are queued as the dots they switch on.
+struct FHapticSubmission
+{
+	EHapticSubmissionType Type = EHapticSubmissionType::Dots;
+	FString Key;
+	FString AltKey;
+	EPosition Position = EPosition::Default;
+	int32 DurationMillis = 0;
+	TArray<FDotPoint> Dots;
+	TArray<FPathPoint> Paths;
+	FScaleOption ScaleOption;
+	FRotationOption RotationOption;
+	bool bHasOptions = false;
+	int32 HitCount = 0; // hits merged into this registered submission by SubmitHit, 0 for everything else
+	int32 DelayMillis = 0; // sent this long after the flush by the HapticLibrary's scheduler, 0 to send with it
+	bool bAtOnset = false; // DelayMillis is when it should be felt; sent earlier by the measured link latency
+};
+
+// Owns the connection to the bHaptics Player for every UHapticManagerComponent and collects what they submit during a frame.
+// The queue is sent to the Player as one message when the manager ticks, after the world has ticked, so components do not
+// need to tick themselves; force feedback routed by FHapticsForceFeedbackBridge joins the queue just before. Created by
+// the HapticsManager module once the HapticLibrary is loaded.
+class HAPTICSMANAGER_API FHapticsSubmissionManager : public FTickableGameObject
+{
+public:
+	FHapticsSubmissionManager();
+	virtual ~FHapticsSubmissionManager();
+
+	// Null when the HapticLibrary could not be loaded.
+	static FHapticsSubmissionManager* Get();
+
+	// Connects to the Player, launching it if configured to, the first time any component asks.
+	bool EnsureConnection();
+
+	// Queue functions may be called from any thread.
+	void SubmitBytes(const FString& Key, EPosition Position, const TArray<uint8>& MotorBytes, int32 DurationMillis);
+
+	void SubmitDots(const FString& Key, EPosition Position, const TArray<FDotPoint>& Points, int32 DurationMillis);
+
+	void SubmitPath(const FString& Key, EPosition Position, const TArray<FPathPoint>& Points, int32 DurationMillis);
+
+	void SubmitRegistered(const FString& Key);
+
+	void SubmitRegistered(const FString& Key, const FString& AltKey, FScaleOption ScaleOption, FRotationOption RotationOption);
+
+	// Queues a registered feedback under a new AltKey, or merges it into a hit of the same Key queued this frame
+	// that lies within MergeAngle degrees and MergeOffsetY of it.
+	void SubmitHit(const FString& Key, FScaleOption ScaleOption, FRotationOption RotationOption, float MergeAngle, float MergeOffsetY);
+
+	void TurnOff(const FString& Key);
+
+	void TurnOffAll();
+
+	// Queues a submission built like the ones above to be sent DelayMillis after the flush. The HapticLibrary times it
+	// on its own thread to about a millisecond, so a sequence of steps needs no game-side timers.
+	void Schedule(FHapticSubmission&& Submission, int32 DelayMillis);
+
+	// Like Schedule, but OnsetMillis is when the feedback should be felt: the HapticLibrary sends it ahead by the round
+	// trip and Player delay it measures, or right away if that lead is longer.
+	void ScheduleAtOnset(FHapticSubmission&& Submission, int32 OnsetMillis);
+
+	// Drops the scheduled submissions of Key (or of their AltKey), or every scheduled submission if Key is empty.
+	void CancelScheduled(const FString& Key);
+
+	// Sends everything queued so far as one batch. Game thread only.
+	void Flush();
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return true; }
+	virtual bool IsTickableWhenPaused() const override { return true; }
+	virtual bool IsTickableInEditor() const override { return false; }
+	virtual TStatId GetStatId() const override;
+
+private:
+	void Queue(FHapticSubmission&& Submission);
+
+	static FHapticsSubmissionManager* Instance;
+
+	FCriticalSection ConnectionLock;
+	FCriticalSection PendingLock;
+	TArray<FHapticSubmission> Pending;
+	uint32 NextHitId = 0; // guarded by PendingLock
+	TArray<FHapticSubmission> Flushing; // only touched by Flush, keeps its allocation between frames
+};
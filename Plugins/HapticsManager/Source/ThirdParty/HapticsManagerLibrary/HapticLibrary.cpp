@@ -8,6 +8,7 @@
 
 #include "hapticsManager.h"
 #include "model.h"
+#include "traceLog.h"
 #ifndef DLLEXPORT
     #define DLLEXPORT
 #endif
@@ -51,6 +52,31 @@ DLLEXPORT const char* getExePath()
 #endif
 }
 
+DLLEXPORT void SetCompression(bool Enable)
+{
+	bhaptics::HapticPlayer::instance()->setCompression(Enable);
+}
+
+DLLEXPORT void SetCullDisconnected(bool Enable)
+{
+	bhaptics::HapticPlayer::instance()->setCullDisconnected(Enable);
+}
+
+DLLEXPORT void SetRasterizePaths(bool Enable)
+{
+	bhaptics::HapticPlayer::instance()->setRasterizePaths(Enable);
+}
+
+DLLEXPORT void SetLocalTransforms(bool Enable)
+{
+	bhaptics::HapticPlayer::instance()->setLocalTransforms(Enable);
+}
+
+DLLEXPORT uint32_t GetConnectedPositionMask()
+{
+	return bhaptics::HapticPlayer::instance()->getConnectedMask();
+}
+
 DLLEXPORT void Initialise()
 {
 	bhaptics::HapticPlayer::instance()->registerConnection("Plugin");
@@ -97,6 +123,46 @@ DLLEXPORT void SubmitPath(std::string& Key, bhaptics::Position Pos, std::vector<
 	bhaptics::HapticPlayer::instance()->submit(Key, Pos, Points, DurationMillis);
 }
 
+DLLEXPORT void SubmitBatch(std::vector<bhaptics::SubmitRequest>& Requests)
+{
+	bhaptics::HapticPlayer::instance()->submitBatch(Requests);
+}
+
+DLLEXPORT void SubmitScheduled(std::vector<bhaptics::ScheduledSubmit>& Requests)
+{
+	bhaptics::HapticPlayer::instance()->scheduleBatch(Requests);
+}
+
+DLLEXPORT int CancelScheduled(std::string& Key)
+{
+	return (int)bhaptics::HapticPlayer::instance()->cancelScheduled(Key);
+}
+
+DLLEXPORT void PlaySynth(std::string& Key, bhaptics::SynthEffect& Effect)
+{
+	bhaptics::HapticPlayer::instance()->playSynth(Key, Effect);
+}
+
+DLLEXPORT bool UpdateSynth(std::string& Key, bhaptics::SynthEffect& Effect)
+{
+	return bhaptics::HapticPlayer::instance()->updateSynth(Key, Effect);
+}
+
+DLLEXPORT void ReleaseSynth(std::string& Key)
+{
+	bhaptics::HapticPlayer::instance()->releaseSynth(Key);
+}
+
+DLLEXPORT void SetAudioHaptics(bhaptics::AudioHapticsConfig& Config)
+{
+	bhaptics::HapticPlayer::instance()->setAudioHaptics(Config);
+}
+
+DLLEXPORT void FeedAudio(const float* Samples, int Frames, int Channels, int SampleRate)
+{
+	bhaptics::HapticPlayer::instance()->feedAudio(Samples, Frames, Channels, SampleRate);
+}
+
 DLLEXPORT bool IsFeedbackRegistered(std::string& key)
 {
 	return bhaptics::HapticPlayer::instance()->isFeedbackRegistered(key);
@@ -144,84 +210,92 @@ DLLEXPORT bool IsDevicePlaying(bhaptics::Position Pos)
 
 DLLEXPORT void GetResponseForPosition(std::vector<int>& retValues, std::string& pos)
 {
-	if (!bhaptics::HapticPlayer::instance()->getResponseStatus().empty())
+	bhaptics::Position position;
+	if (!bhaptics::positionFromName(pos, position))
+	{
+		return;
+	}
+	bhaptics::DeviceStatus status = bhaptics::HapticPlayer::instance()->getResponseStatus();
+	const uint8_t* values = status.values(position);
+	if (values != nullptr)
 	{
-		std::map<std::string, std::vector<int>> responseMap = bhaptics::HapticPlayer::instance()->getResponseStatus();
-		if (responseMap.find(pos) != responseMap.end())
+		for (size_t i = 0; i < retValues.size() && i < (size_t)bhaptics::motorCount(position); i++)
 		{
-			std::vector<int> response = responseMap.at(pos);//bhaptics::HapticPlayer::instance()->getResponseStatus().at(pos);
-			/*retValues = response.at(pos);*/
-			for (int i = 0; i < retValues.size(); i++)
-			{
-				retValues[i] = response.at(i);
-			}
+			retValues[i] = values[i];
 		}
 	}
 }
 
+DLLEXPORT bool GetResponseStatusSince(uint64_t& Version, bhaptics::DeviceStatus& Status)
+{
+	return bhaptics::HapticPlayer::instance()->getResponseStatusSince(Version, Status);
+}
+
+DLLEXPORT void GetTrafficStats(bhaptics::TrafficStats& Stats)
+{
+	Stats = bhaptics::HapticPlayer::instance()->getTrafficStats();
+}
+
+DLLEXPORT void GetHapticStats(bhaptics::HapticStats& Stats)
+{
+	Stats = bhaptics::HapticPlayer::instance()->getStats();
+}
+
+DLLEXPORT void GetSubmitLatency(bhaptics::SubmitLatencyStats& Stats)
+{
+	Stats = bhaptics::HapticPlayer::instance()->getSubmitLatency();
+}
+
+DLLEXPORT void ResetSubmitLatency()
+{
+	bhaptics::HapticPlayer::instance()->resetSubmitLatency();
+}
+
+DLLEXPORT void GetLinkLatency(bhaptics::LinkLatency& Latency)
+{
+	Latency = bhaptics::HapticPlayer::instance()->getLinkLatency();
+}
+
+DLLEXPORT void StartTrace(int Capacity, std::string& DumpPathOnShutdown)
+{
+	bhaptics::TraceLog::instance()->start(Capacity > 0 ? (size_t)Capacity : 0, DumpPathOnShutdown);
+}
+
+DLLEXPORT void StopTrace()
+{
+	bhaptics::TraceLog::instance()->stop();
+}
+
+DLLEXPORT bool DumpTrace(std::string& FilePath)
+{
+	return bhaptics::TraceLog::instance()->dump(FilePath);
+}
+
+DLLEXPORT bool StartRecording(std::string& FilePath, bool IncludeStatus)
+{
+	return bhaptics::HapticPlayer::instance()->startRecording(FilePath, IncludeStatus);
+}
+
+DLLEXPORT void StopRecording()
+{
+	bhaptics::HapticPlayer::instance()->stopRecording();
+}
+
 DLLEXPORT void GetResponseStatus(std::vector<bhaptics::HapticFeedback>& retValues)
 {
-	std::map<std::string, std::vector<int>> response = bhaptics::HapticPlayer::instance()->getResponseStatus();
-	for (auto& Device : response)
+	retValues.clear();
+	bhaptics::DeviceStatus response = bhaptics::HapticPlayer::instance()->getResponseStatus();
+	for (const bhaptics::PositionInfo& Device : bhaptics::PositionSchema)
 	{
-		bhaptics::Position Position = bhaptics::Position::ForearmL;
-
-		if (Device.first == "Left")
-		{
-			Position = bhaptics::Position::Left;
-		}
-		else if (Device.first == "Right")
-		{
-			Position = bhaptics::Position::Right;
-		}
-		if (Device.first == "ForearmL")
-		{
-			Position = bhaptics::Position::ForearmL;
-		}
-		else if (Device.first == "ForearmR")
-		{
-			Position = bhaptics::Position::ForearmR;
-		}
-		else if (Device.first == "Head")
-		{
-			Position = bhaptics::Position::Head;
-		}
-		else if (Device.first == "VestFront")
-		{
-			Position = bhaptics::Position::VestFront;
-		}
-		else if (Device.first == "VestBack")
-		{
-			Position = bhaptics::Position::VestBack;
-		}
-		else if (Device.first == "Racket")
-		{
-			Position = bhaptics::Position::Racket;
-		}
-		else if (Device.first == "HandL")
-		{
-			Position = bhaptics::Position::HandL;
-		}
-		else if (Device.first == "HandR")
-		{
-			Position = bhaptics::Position::HandR;
-		}
-		else if (Device.first == "FootL")
-		{
-			Position = bhaptics::Position::FootL;
-		}
-		else if (Device.first == "FootR")
-		{
-			Position = bhaptics::Position::FootR;
-		}
-		else
+		const uint8_t* values = response.values(Device.Value);
+		if (!Device.Listed || values == nullptr)
 		{
 			continue;
 		}
 
-		//bhaptics::HapticFeedback Feedback;
-		//Feedback.DevicePosition = Position;
-		//Feedback.Values = Device.second;
-		//retValues.push_back(Feedback);
+		bhaptics::HapticFeedback Feedback;
+		Feedback.DevicePosition = Device.Value;
+		Feedback.Values.assign(values, values + bhaptics::motorCount(Device.Value));
+		retValues.push_back(Feedback);
 	}
 }
\ No newline at end of file
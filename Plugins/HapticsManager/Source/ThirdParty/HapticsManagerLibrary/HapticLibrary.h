@@ -5,10 +5,38 @@
 #endif
 
 #include "model.h"
+#include "motorLayout.h"
 #include <vector>
 
+// Threading: SetCompression, Initialise and Destroy are meant for one thread, e.g. the game thread.
+// Every other function may be called from any thread, including several at once (task graph workers, physics
+// callbacks). Submits serialize on the calling thread and queue the message without waiting for the socket.
+
 DLLIMPORT const char* getExePath();
 
+// Offer permessage-deflate compression when connecting to the bHaptics Player. Call before Initialise.
+// Only effective in builds with BHAPTICS_WS_DEFLATE defined, and if the Player accepts the extension.
+DLLIMPORT void SetCompression(bool Enable);
+
+// Reject Submit, SubmitDot and SubmitPath calls for devices the bHaptics Player does not report as connected,
+// before any conversion or serialization. Rejected calls are counted as CulledSubmits. Off by default.
+DLLIMPORT void SetCullDisconnected(bool Enable);
+
+// Returns the bhaptics::positionMask bits of the devices connected to the bHaptics Player, as of its last status.
+// Zero until the first status arrives. Lock-free.
+DLLIMPORT uint32_t GetConnectedPositionMask();
+
+// Convert the path points of SubmitPath, SubmitBatch and locally transformed feedback into motor intensities in the
+// library, so they are sent as compact dot frames and mix with other frames. Each point drives its MotorCount nearest
+// motors. Devices without a known motor layout still receive path points. Off by default.
+DLLIMPORT void SetRasterizePaths(bool Enable);
+
+// Apply the ScaleOption and RotationOption of SubmitRegisteredAlt (and registered requests in SubmitBatch) in the
+// library: the feedback is rendered into 20ms frames, rotated around the vest and scaled, and sent as frames mixed
+// with the other rotated feedbacks, so AltKeys no longer need to be unique per hit. Transforms are cached per key
+// and option, quantized to 1 degree and 0.01 of the other values. Off by default.
+DLLIMPORT void SetLocalTransforms(bool Enable);
+
 // Initialises a connection to the bHaptics Player. Should only be called once: when the game starts.
 DLLIMPORT void Initialise();
 
@@ -18,6 +46,7 @@ DLLIMPORT void Destroy();
 // Register a preset .tact feedback file, created using the bHaptics Designer.
 // Registered files can then be called and played back using the given key.
 // File is submitted as an already processed JSON string of the Project attribute.
+// Registering an existing Key again replaces its project and only sends that Key to the Player.
 DLLIMPORT void RegisterFeedback(std::string& Key, std::string& ProjectJson);
 
 // Register a preset .tact feedback file, created using the bHaptics Designer.
@@ -47,6 +76,39 @@ DLLIMPORT void SubmitDot(std::string& Key, bhaptics::Position Pos, std::vector<b
 // Specify the Position (playback device) as well as the duration of the feedback effect in milliseconds.
 DLLIMPORT void SubmitPath(std::string& Key, bhaptics::Position Pos, std::vector<bhaptics::PathPoint>& Points, int DurationMillis);
 
+// Submit several frames, registered feedbacks and turn-offs in a single message to the bHaptics Player, e.g. everything
+// requested during one game frame. Only the last request per key is sent; a turnOffAll drops the requests before it.
+// A frame with more path points than it holds passes them all in SubmitRequest::AllPathPoints.
+DLLIMPORT void SubmitBatch(std::vector<bhaptics::SubmitRequest>& Requests);
+
+// Submit each request DelayMillis after this call, within about a millisecond, from the library's own thread.
+// Requests that fall due together are sent like SubmitBatch. Requests made with ScheduledSubmit::AtOnset are
+// sent early by the measured lead (see GetLinkLatency), so they are felt DelayMillis after this call.
+DLLIMPORT void SubmitScheduled(std::vector<bhaptics::ScheduledSubmit>& Requests);
+
+// Drop the scheduled requests whose key (or altKey) is Key, or every scheduled request if Key is empty.
+// Returns how many were dropped.
+DLLIMPORT int CancelScheduled(std::string& Key);
+
+// Play a procedural effect (envelope, oscillator, noise, sweep across motors) under Key. The library renders it into a
+// frame every 20 ms; nothing is registered with the Player. Playing Key again restarts it, TurnOffKey stops it at once.
+DLLIMPORT void PlaySynth(std::string& Key, bhaptics::SynthEffect& Effect);
+
+// Change the parameters of the effect playing under Key without restarting it, e.g. every game frame.
+// Returns false if Key is not playing.
+DLLIMPORT bool UpdateSynth(std::string& Key, bhaptics::SynthEffect& Effect);
+
+// Fade out the effect playing under Key, or every effect if Key is empty, over its envelope's release.
+DLLIMPORT void ReleaseSynth(std::string& Key);
+
+// Play haptics derived from the audio passed to FeedAudio: each route maps the level of four frequency bands onto the
+// rows of a device. Empty Routes turn audio haptics off.
+DLLIMPORT void SetAudioHaptics(bhaptics::AudioHapticsConfig& Config);
+
+// Pass interleaved float samples, e.g. each buffer of an audio mixer, to audio haptics. Call from one audio thread at
+// a time; it never locks or allocates, and returns at once while audio haptics are off.
+DLLIMPORT void FeedAudio(const float* Samples, int Frames, int Channels, int SampleRate);
+
 // Boolean to check if a Feedback has been registered or not under the given Key.
 DLLIMPORT bool IsFeedbackRegistered(std::string& key);
 
@@ -74,10 +136,49 @@ DLLIMPORT void ToggleFeedback();
 // Boolean to check if a specific device is connected to the bHaptics Player.
 DLLIMPORT bool IsDevicePlaying(bhaptics::Position Pos);
 
-// Returns an array of the current status of each device.
-// Used for UI to ensure that haptic feedback is playing.
+// Returns an array of the current status of each device the Player has reported, in PositionSchema order, with
+// motorCount values each. Used for UI to ensure that haptic feedback is playing.
 DLLIMPORT void GetResponseStatus(std::vector<bhaptics::HapticFeedback>& retValues);
 
 // Returns the current motor values for a given device.
 // Used for UI to ensure that haptic feedback is playing.
 DLLIMPORT void GetResponseForPosition(std::vector<int>& retValues, std::string& pos);
+
+// Copies the current motor values of every device, see DeviceStatus in motorLayout.h, only if they changed since Version.
+// Returns false without copying or locking when Version is current; otherwise updates Version. Start from 0.
+DLLIMPORT bool GetResponseStatusSince(uint64_t& Version, bhaptics::DeviceStatus& Status);
+
+// Returns the payload and on-the-wire byte counts exchanged with the bHaptics Player.
+DLLIMPORT void GetTrafficStats(bhaptics::TrafficStats& Stats);
+
+// Returns the client's counters: submits per type, messages, bytes, dropped frames, reconnects and time spent
+// serializing, parsing status and waiting on locks. Lock-free, callable from any thread.
+DLLIMPORT void GetHapticStats(bhaptics::HapticStats& Stats);
+
+// Returns p50/p99/max latency of submits, from the submit call to the frame leaving the socket, split by stage.
+DLLIMPORT void GetSubmitLatency(bhaptics::SubmitLatencyStats& Stats);
+
+// Clears the submit latency histograms, e.g. to measure one scene or one logging interval at a time.
+DLLIMPORT void ResetSubmitLatency();
+
+// Round trip to the Player and its processing delay, measured with pings and status reports while connected.
+// LeadMicros is how much earlier than their onset ScheduledSubmit::AtOnset requests are sent.
+DLLIMPORT void GetLinkLatency(bhaptics::LinkLatency& Latency);
+
+// Starts recording library events (submits, serialization, socket writes, status parses, reconnects, lock waits)
+// into a ring of Capacity events. The ring size is fixed by the first call. A non-empty DumpPathOnShutdown is
+// written when the connection is destroyed. Traces open in chrome://tracing or ui.perfetto.dev.
+DLLIMPORT void StartTrace(int Capacity, std::string& DumpPathOnShutdown);
+
+// Stops recording; the recorded events are kept until the next StartTrace.
+DLLIMPORT void StopTrace();
+
+// Writes the recorded events as a Chrome trace-event JSON file. Returns false if nothing was recorded or the file
+// could not be written.
+DLLIMPORT bool DumpTrace(std::string& FilePath);
+
+// Records every request sent to the bHaptics Player, and the status messages received if IncludeStatus is set,
+// to a compact binary session log at FilePath. Replay it with Tools/Replayer. Recording stops on Destroy.
+DLLIMPORT bool StartRecording(std::string& FilePath, bool IncludeStatus);
+
+DLLIMPORT void StopRecording();
\ No newline at end of file
@@ -0,0 +1,591 @@
+//Copyright bHaptics Inc. 2017-2019
+// Benchmarks for the HapticLibrary hot paths: request serialization, status parsing, WebSocket framing,
+// submits against a loopback Player and status queries. Reports ns/op, allocations/op and bytes/op.
+// Standalone executable, not part of the library project. It compiles easywsclient.cpp into this file
+// to reach _RealWebSocket, so that file is left out of the build line. POSIX only; see Tools/README.md.
+#include "easywsclient.cpp"
+#include "hapticsManager.h"
+#include "Tools/MockPlayer/mockServer.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Allocation counting. Only allocations made by the benchmarking thread while a measurement runs are counted,
+// so the library's timer thread and the loopback server do not skew the numbers.
+static thread_local bool countAllocations = false;
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t allocationBytes = 0;
+
+static void* countedAllocate(size_t size)
+{
+	if (countAllocations)
+	{
+		allocationCount++;
+		allocationBytes += size;
+	}
+	void* memory = malloc(size ? size : 1);
+	if (!memory)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+// Every replaceable form is defined, so each allocation is counted and freed by its matching function.
+void* operator new(size_t size)
+{
+	return countedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return countedAllocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	try
+	{
+		return countedAllocate(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	free(memory);
+}
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct BenchmarkOptions
+	{
+		int iterations = 100000;
+		int networkIterations = 20000;
+		std::string filter;
+		bool csv = false;
+	};
+
+	BenchmarkOptions options;
+
+	template<class Operation>
+	void run(const char* name, int iterations, Operation operation, int opsPerIteration = 1)
+	{
+		if (!options.filter.empty() && strstr(name, options.filter.c_str()) == nullptr)
+		{
+			return;
+		}
+
+		// Warm up caches and any lazily grown buffers before measuring.
+		for (int i = 0; i < iterations / 10 + 1; i++)
+		{
+			operation();
+		}
+
+		allocationCount = 0;
+		allocationBytes = 0;
+		countAllocations = true;
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			operation();
+		}
+		Clock::time_point end = Clock::now();
+		countAllocations = false;
+
+		double ops = (double)iterations * opsPerIteration;
+		double nanos = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		if (options.csv)
+		{
+			printf("%s,%.1f,%.2f,%.1f\n", name, nanos / ops, allocationCount / ops, allocationBytes / ops);
+		}
+		else
+		{
+			printf("%-40s %12.1f ns/op %8.2f allocs/op %10.1f bytes/op\n", name, nanos / ops, allocationCount / ops, allocationBytes / ops);
+		}
+		fflush(stdout);
+	}
+
+	// Keeps the optimizer from discarding benchmarked results.
+	volatile size_t sink = 0;
+
+	std::vector<bhaptics::DotPoint> makeDots()
+	{
+		std::vector<bhaptics::DotPoint> dots;
+		for (int i = 0; i < 20; i++)
+		{
+			dots.push_back(bhaptics::DotPoint(i, (i * 7) % 100));
+		}
+		return dots;
+	}
+
+	std::vector<bhaptics::PathPoint> makePath()
+	{
+		std::vector<bhaptics::PathPoint> points;
+		for (int i = 0; i < 5; i++)
+		{
+			points.push_back(bhaptics::PathPoint(200 * i, 1000 - 200 * i, 80));
+		}
+		return points;
+	}
+
+	std::vector<uint8_t> makeBytes()
+	{
+		std::vector<uint8_t> bytes(20, 0);
+		for (size_t i = 0; i < bytes.size(); i += 2)
+		{
+			bytes[i] = 100;
+		}
+		return bytes;
+	}
+
+	// A Player status message with a few active keys and all motor arrays populated.
+	std::string makeStatusMessage()
+	{
+		const char* positions[] = { "Left", "Right", "ForearmL", "ForearmR", "Head", "VestFront", "VestBack", "HandL", "HandR", "FootL", "FootR" };
+		std::string motors = "[";
+		for (int i = 0; i < 20; i++)
+		{
+			motors += std::to_string((i * 13) % 100);
+			motors += i + 1 < 20 ? "," : "]";
+		}
+
+		std::string status = "{\"RegisteredKeys\":[\"Shot\",\"Explosion\",\"Heartbeat\",\"Rain\"],\"ActiveKeys\":[\"Shot\",\"Heartbeat\"],"
+			"\"ConnectedDeviceCount\":3,\"ConnectedPositions\":[\"Vest\",\"ForearmL\",\"Head\"],\"Status\":{";
+		for (size_t i = 0; i < sizeof(positions) / sizeof(positions[0]); i++)
+		{
+			status += std::string(i ? "," : "") + "\"" + positions[i] + "\":" + motors;
+		}
+		status += "}}";
+		return status;
+	}
+
+	bhaptics::PlayerRequest makeRequest(const bhaptics::Frame& frame)
+	{
+		bhaptics::PlayerRequest request;
+		request.Submit.push_back(bhaptics::SubmitRequest::AsFrame("Benchmark", frame));
+		return request;
+	}
+
+	void benchmarkSerialization()
+	{
+		std::vector<bhaptics::DotPoint> dots = makeDots();
+		std::vector<bhaptics::PathPoint> path = makePath();
+		std::vector<uint8_t> bytes = makeBytes();
+
+		bhaptics::PlayerRequest dotRequest = makeRequest(bhaptics::Frame::AsDotPointFrame(dots, bhaptics::VestFront, 100));
+		run("to_string/dot (20 dots)", options.iterations, [&]()
+		{
+			sink += dotRequest.to_string().size();
+		});
+
+		bhaptics::PlayerRequest pathRequest = makeRequest(bhaptics::Frame::AsPathPointFrame(path, bhaptics::VestBack, 100));
+		run("to_string/path (5 points)", options.iterations, [&]()
+		{
+			sink += pathRequest.to_string().size();
+		});
+
+		// Frames and submit requests keep their points inline, so building one does not allocate.
+		run("SubmitRequest::AsFrame (20 dots)", options.iterations, [&]()
+		{
+			bhaptics::SubmitRequest submit = bhaptics::SubmitRequest::AsFrame("Benchmark",
+				bhaptics::Frame::AsDotPointFrame(dots, bhaptics::VestFront, 100));
+			sink += submit.Frame.DotPoints.size();
+		});
+
+		const std::string statusName = "VestFront";
+		run("positionFromName (VestFront)", options.iterations, [&]()
+		{
+			sink += bhaptics::positionFromName(statusName);
+		});
+
+		const bhaptics::MotorLayout& tactot = bhaptics::motorLayout(bhaptics::VestBack);
+		run("rasterizePath (5 points)", options.iterations, [&]()
+		{
+			uint8_t motors[bhaptics::MaxMotors] = {};
+			bhaptics::rasterizePath(tactot, path.data(), path.size(), motors);
+			sink += motors[0];
+		});
+
+		// One tick of the timer thread with a sweep, a pulse and a noise voice playing on the vest.
+		bhaptics::WaveformSynth synth;
+		std::chrono::steady_clock::time_point synthTime = std::chrono::steady_clock::now();
+		bhaptics::SynthEffect sweep;
+		sweep.SweepTo = 19;
+		sweep.SweepMillis = 400;
+		sweep.SweepLoop = true;
+		synth.play("sweep", sweep, synthTime);
+		bhaptics::SynthEffect pulse;
+		pulse.Position = bhaptics::VestBack;
+		pulse.Shape = bhaptics::WaveShape::Sine;
+		pulse.FrequencyHz = 4;
+		synth.play("pulse", pulse, synthTime);
+		bhaptics::SynthEffect rumble;
+		rumble.Shape = bhaptics::WaveShape::Noise;
+		rumble.Intensity = 0.3f;
+		synth.play("rumble", rumble, synthTime);
+		std::vector<bhaptics::SynthFrame> synthFrames;
+		run("WaveformSynth::render (3 voices)", options.iterations, [&]()
+		{
+			synthTime += std::chrono::milliseconds(20);
+			synth.render(synthTime, synthFrames);
+			sink += synthFrames[0].Dots[0];
+		});
+
+		// One buffer of the audio mixer: 1024 stereo frames at 48 kHz, analysed on the audio thread.
+		bhaptics::AudioHaptics audio;
+		bhaptics::AudioHapticsConfig audioConfig;
+		audioConfig.Routes.push_back(bhaptics::AudioHapticsRoute());
+		audio.configure(audioConfig);
+		std::vector<float> audioBuffer(1024 * 2);
+		for (size_t i = 0; i < audioBuffer.size(); i++)
+		{
+			audioBuffer[i] = 0.5f * std::sin(i * 0.01f) + 0.1f * std::sin(i * 0.7f);
+		}
+		run("AudioHaptics::process (1024 frames, stereo)", options.iterations / 10, [&]()
+		{
+			audio.process(audioBuffer.data(), 1024, 2, 48000);
+		});
+
+		// Bytes are converted to dot points on submit, so the conversion is part of the serialization cost.
+		run("to_string/bytes (20 motors)", options.iterations, [&]()
+		{
+			std::vector<bhaptics::DotPoint> points;
+			for (size_t i = 0; i < bytes.size(); i++)
+			{
+				if (bytes[i] > 0)
+				{
+					points.push_back(bhaptics::DotPoint((int)i, bytes[i]));
+				}
+			}
+			bhaptics::PlayerRequest request = makeRequest(bhaptics::Frame::AsDotPointFrame(points, bhaptics::Head, 100));
+			sink += request.to_string().size();
+		});
+	}
+
+	void benchmarkStatusParsing()
+	{
+		std::string message = makeStatusMessage();
+		nlohmann::json parsed = nlohmann::json::parse(message);
+
+		run("PlayerResponse::from_json", options.iterations / 10, [&]()
+		{
+			bhaptics::PlayerResponse response;
+			bhaptics::PlayerResponse::from_json(parsed, response);
+			sink += response.Status.Reported;
+		});
+
+		run("PlayerResponse parse+from_json", options.iterations / 10, [&]()
+		{
+			bhaptics::PlayerResponse response;
+			bhaptics::PlayerResponse::from_json(nlohmann::json::parse(message), response);
+			sink += response.Status.Reported;
+		});
+	}
+
+	void drain(int fd)
+	{
+		char buffer[65536];
+		while (recv(fd, buffer, sizeof(buffer), 0) > 0)
+		{
+		}
+	}
+
+	// Framing is measured over a socketpair so that no network stack beyond a local buffer copy is involved.
+	void benchmarkFraming()
+	{
+		int fds[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+		{
+			fprintf(stderr, "socketpair failed, skipping framing benchmarks\n");
+			return;
+		}
+		fcntl(fds[0], F_SETFL, O_NONBLOCK);
+		fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+		{
+			easywsclient::_RealWebSocket client(fds[0], true);
+			std::string message = makeRequest(bhaptics::Frame::AsDotPointFrame(makeDots(), bhaptics::VestFront, 100)).to_string();
+
+			run("_RealWebSocket send+mask (dot frame)", options.iterations, [&]()
+			{
+				client.send(message);
+				client.poll();
+				drain(fds[1]);
+			});
+
+			// Build a batch of masked frames, as a client would send them, and time receiving and unmasking them.
+			const int batch = 32;
+			std::string status = makeStatusMessage();
+			std::vector<uint8_t> frames;
+			const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+			for (int i = 0; i < batch; i++)
+			{
+				frames.push_back(0x81);
+				frames.push_back(0x80 | 126);
+				frames.push_back((uint8_t)(status.size() >> 8));
+				frames.push_back((uint8_t)(status.size() & 0xff));
+				frames.insert(frames.end(), mask, mask + 4);
+				for (size_t j = 0; j < status.size(); j++)
+				{
+					frames.push_back((uint8_t)status[j] ^ mask[j & 3]);
+				}
+			}
+
+			run("_RealWebSocket recv+unmask (status)", options.networkIterations / batch, [&]()
+			{
+				size_t written = 0;
+				while (written < frames.size())
+				{
+					ssize_t ret = ::send(fds[1], (const char*)&frames[written], frames.size() - written, 0);
+					if (ret > 0)
+					{
+						written += ret;
+					}
+					client.poll();
+					client.dispatchChar([](const char* message) { sink += message[0]; });
+				}
+				client.poll();
+				client.dispatchChar([](const char* message) { sink += message[0]; });
+			}, batch);
+		}
+		close(fds[1]);
+	}
+
+	// Loopback Player that counts the requests it receives and reports one status with active keys.
+	class LoopbackPlayer
+	{
+	public:
+		std::atomic<uint64_t> received{ 0 };
+
+		bool start()
+		{
+			server.onOpen = [this](int client) { server.sendText(client, makeStatusMessage()); };
+			server.onMessage = [this](int, const std::string&) { received++; };
+			if (!server.listen("127.0.0.1", 15881, "v2/feedbacks", false))
+			{
+				return false;
+			}
+			thread = std::thread([this]()
+			{
+				while (running)
+				{
+					server.poll(1);
+				}
+				server.closeAll();
+			});
+			return true;
+		}
+
+		void stop()
+		{
+			running = false;
+			if (thread.joinable())
+			{
+				thread.join();
+			}
+		}
+
+	private:
+		bhaptics::MockServer server;
+		std::thread thread;
+		std::atomic<bool> running{ true };
+	};
+
+	template<class Predicate>
+	bool waitFor(Predicate predicate, int timeoutMillis)
+	{
+		Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMillis);
+		while (!predicate())
+		{
+			if (Clock::now() > deadline)
+			{
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	void benchmarkPlayer()
+	{
+		LoopbackPlayer loopback;
+		bool ownServer = loopback.start();
+		if (!ownServer)
+		{
+			printf("port 15881 in use, benchmarking against the running Player\n");
+		}
+
+		bhaptics::HapticPlayer* player = bhaptics::HapticPlayer::instance();
+		player->init();
+		if (!waitFor([&]() { return player->isPlaying(); }, 2000))
+		{
+			fprintf(stderr, "no status from the Player, skipping submit and status benchmarks\n");
+			player->destroy();
+			loopback.stop();
+			return;
+		}
+
+		std::vector<bhaptics::DotPoint> dots = makeDots();
+		std::vector<bhaptics::PathPoint> path = makePath();
+		std::vector<uint8_t> bytes = makeBytes();
+		std::string key = "Benchmark";
+
+		run("HapticPlayer::submit/dot", options.networkIterations, [&]()
+		{
+			player->submit(key, bhaptics::VestFront, dots, 100);
+		});
+
+		run("HapticPlayer::submit/path", options.networkIterations, [&]()
+		{
+			player->submit(key, bhaptics::VestBack, path, 100);
+		});
+
+		run("HapticPlayer::submit/bytes", options.networkIterations, [&]()
+		{
+			player->submit(key, bhaptics::Head, bytes, 100);
+		});
+
+		const char* deliveredName = "HapticPlayer::submit/dot delivered";
+		if (ownServer && (options.filter.empty() || strstr(deliveredName, options.filter.c_str()) != nullptr))
+		{
+			// Time until the Player has actually received every submit, not just until send returned.
+			uint64_t target = loopback.received + options.networkIterations;
+			Clock::time_point start = Clock::now();
+			for (int i = 0; i < options.networkIterations; i++)
+			{
+				player->submit(key, bhaptics::VestFront, dots, 100);
+			}
+			bool delivered = waitFor([&]() { return loopback.received >= target; }, 10000);
+			double nanos = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+			if (!delivered)
+			{
+				printf(options.csv ? "%s,timed out\n" : "%-40s %12s\n", deliveredName, "timed out");
+			}
+			else if (options.csv)
+			{
+				printf("%s,%.1f,,\n", deliveredName, nanos / options.networkIterations);
+			}
+			else
+			{
+				printf("%-40s %12.1f ns/op\n", deliveredName, nanos / options.networkIterations);
+			}
+		}
+
+		run("HapticPlayer::isPlaying", options.iterations, [&]()
+		{
+			sink += player->isPlaying();
+		});
+
+		std::string active = "Shot";
+		run("HapticPlayer::isPlaying(key)", options.iterations, [&]()
+		{
+			sink += player->isPlaying(active);
+		});
+
+		run("HapticPlayer::getResponseStatus", options.iterations / 10, [&]()
+		{
+			sink += player->getResponseStatus().Reported;
+		});
+
+		player->destroy();
+		loopback.stop();
+	}
+
+	void printUsage()
+	{
+		printf("Usage: HapticLibraryBenchmark [options]\n"
+			"  --iterations <n>   iterations of the in-memory benchmarks (100000)\n"
+			"  --network <n>      iterations of the socket benchmarks (20000)\n"
+			"  --filter <text>    only run benchmarks whose name contains text\n"
+			"  --csv              print name,ns/op,allocs/op,bytes/op\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--iterations" && hasValue) { options.iterations = atoi(argv[++i]); }
+		else if (arg == "--network" && hasValue) { options.networkIterations = atoi(argv[++i]); }
+		else if (arg == "--filter" && hasValue) { options.filter = argv[++i]; }
+		else if (arg == "--csv") { options.csv = true; }
+		else { printUsage(); return 1; }
+	}
+
+	if (options.iterations < 10 || options.networkIterations < 32)
+	{
+		printUsage();
+		return 1;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+
+	if (options.csv)
+	{
+		printf("benchmark,ns_per_op,allocs_per_op,bytes_per_op\n");
+	}
+
+	benchmarkSerialization();
+	benchmarkStatusParsing();
+	benchmarkFraming();
+	benchmarkPlayer();
+	return 0;
+}
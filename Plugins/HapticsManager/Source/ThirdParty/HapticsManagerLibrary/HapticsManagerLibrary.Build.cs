@@ -1,6 +1,10 @@
 //Copyright bHaptics Inc. 2017-2019
 
+using System.Collections.Generic;
 using System.IO;
+using System.Text;
+using System.Text.RegularExpressions;
+using Tools.DotNETCommon;
 using UnrealBuildTool;
 
 public class HapticsManagerLibrary : ModuleRules
@@ -14,7 +18,8 @@ public class HapticsManagerLibrary : ModuleRules
             // Add the import library
             PublicLibraryPaths.Add(Path.Combine(ModuleDirectory, "x64", "Release"));
             PublicAdditionalLibraries.Add("HapticLibrary.lib");
-            
+            DefineLibraryExports(Path.Combine(ModuleDirectory, "x64", "Release", "HapticLibrary.lib"));
+
             // Delay-load the DLL, so we can load it from the right place first
             PublicDelayLoadDLLs.Add("HapticLibrary.dll");
         }
@@ -23,6 +28,7 @@ public class HapticsManagerLibrary : ModuleRules
             // Add the import library
             PublicLibraryPaths.Add(Path.Combine(ModuleDirectory, "x86", "Release"));
             PublicAdditionalLibraries.Add("HapticLibrary.lib");
+            DefineLibraryExports(Path.Combine(ModuleDirectory, "x86", "Release", "HapticLibrary.lib"));
 
             // Delay-load the DLL, so we can load it from the right place first
             PublicDelayLoadDLLs.Add("HapticLibrary.dll");
@@ -30,6 +36,34 @@ public class HapticsManagerLibrary : ModuleRules
         else if (Target.Platform == UnrealTargetPlatform.Mac)
         {
             PublicDelayLoadDLLs.Add(Path.Combine(ModuleDirectory, "Mac", "Release", "HapticLibrary.dylib"));
+            PublicDefinitions.Add("BHAPTICS_LIBRARY_EXTENSIONS=1");
+        }
+    }
+
+    // The import library and DLL are prebuilt from HapticLibrary.sln and may predate HapticLibrary.h. Rather than fail
+    // to link with unresolved externals, BHAPTICS_LIBRARY_EXTENSIONS is only set when every export is present;
+    // otherwise BhapticsLibrary.cpp keeps to the exports of the original library and the missing ones are named here.
+    private void DefineLibraryExports(string LibraryPath)
+    {
+        string Header = File.ReadAllText(Path.Combine(ModuleDirectory, "HapticLibrary.h"));
+        string Library = Encoding.GetEncoding(28591).GetString(File.ReadAllBytes(LibraryPath));
+
+        List<string> Missing = new List<string>();
+        foreach (Match Export in Regex.Matches(Header, @"DLLIMPORT\s[^(;]*?(\w+)\s*\("))
+        {
+            string Name = Export.Groups[1].Value;
+            // C++ exports are decorated as ?Name@@..., extern "C" ones as Name or _Name.
+            if (!Library.Contains("?" + Name + "@@") && !Library.Contains("__imp_" + Name) && !Library.Contains("__imp__" + Name))
+            {
+                Missing.Add(Name);
+            }
+        }
+
+        if (Missing.Count > 0)
+        {
+            Log.TraceWarning("{0} does not export {1}. Rebuild HapticLibrary.sln (Release, x64 and Win32), which copies the DLLs into Plugins/HapticsManager/DLLs; until then the plugin uses only the original library functions.",
+                LibraryPath, string.Join(", ", Missing));
         }
+        PublicDefinitions.Add("BHAPTICS_LIBRARY_EXTENSIONS=" + (Missing.Count > 0 ? "0" : "1"));
     }
 }
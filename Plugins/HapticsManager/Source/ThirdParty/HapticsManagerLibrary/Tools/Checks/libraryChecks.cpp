@@ -0,0 +1,187 @@
+//Copyright bHaptics Inc. 2017-2019
+// Regression checks of the HapticLibrary API against the Mock Player, run in-process. Prints each check and exits
+// non-zero if any failed. See Tools/README.md.
+#include "HapticLibrary.h"
+#include "../MockPlayer/mockPlayer.h"
+
+#include <signal.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static int failures = 0;
+
+static void check(bool passed, const char* name)
+{
+	printf("%s  %s\n", passed ? "ok  " : "FAIL", name);
+	failures += passed ? 0 : 1;
+}
+
+static bool waitForStatus()
+{
+	Clock::time_point deadline = Clock::now() + std::chrono::seconds(3);
+	bhaptics::HapticStats stats;
+	do
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		GetHapticStats(stats);
+	} while (stats.MessagesReceived == 0 && Clock::now() < deadline);
+	return stats.MessagesReceived > 0;
+}
+
+static void playSynth(const std::string& key)
+{
+	std::string synthKey = key;
+	bhaptics::SynthEffect effect; // plays until stopped
+	PlaySynth(synthKey, effect);
+}
+
+static bool isSynthPlaying(const std::string& key)
+{
+	std::string synthKey = key;
+	bhaptics::SynthEffect effect;
+	return UpdateSynth(synthKey, effect);
+}
+
+static void submitBatch(const bhaptics::SubmitRequest& request)
+{
+	std::vector<bhaptics::SubmitRequest> requests(1, request);
+	SubmitBatch(requests);
+}
+
+static void checkResponseStatus()
+{
+	std::string key = "Status";
+	std::vector<bhaptics::DotPoint> points(1, bhaptics::DotPoint(3, 100));
+	SubmitDot(key, bhaptics::Position::VestFront, points, 1000);
+
+	std::vector<bhaptics::HapticFeedback> status;
+	const bhaptics::HapticFeedback* vestFront = nullptr;
+	Clock::time_point deadline = Clock::now() + std::chrono::seconds(1);
+	while (vestFront == nullptr && Clock::now() < deadline)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		GetResponseStatus(status);
+		for (const bhaptics::HapticFeedback& feedback : status)
+		{
+			if (feedback.DevicePosition == bhaptics::Position::VestFront && feedback.Values[3] > 0)
+			{
+				vestFront = &feedback;
+			}
+		}
+	}
+	check(vestFront != nullptr && vestFront->Values.size() == (size_t)bhaptics::motorCount(bhaptics::Position::VestFront),
+		"GetResponseStatus returns the motor values of each reported device");
+
+	std::string turnOffKey = key;
+	TurnOffKey(turnOffKey);
+}
+
+static void checkBatchTurnOffStopsSynth()
+{
+	playSynth("Engine");
+	playSynth("Rain");
+	check(isSynthPlaying("Engine") && isSynthPlaying("Rain"), "PlaySynth starts voices");
+
+	submitBatch(bhaptics::SubmitRequest::AsTurnOff("Engine"));
+	check(!isSynthPlaying("Engine"), "SubmitBatch turnOff stops the synth voice of its key");
+	check(isSynthPlaying("Rain"), "SubmitBatch turnOff keeps the synth voices of other keys");
+
+	playSynth("Engine");
+	submitBatch(bhaptics::SubmitRequest::AsTurnOffAll());
+	check(!isSynthPlaying("Engine") && !isSynthPlaying("Rain"), "SubmitBatch turnOffAll stops every synth voice");
+}
+
+static void checkBatchLongPaths()
+{
+	const int pointCount = bhaptics::MaxPathPoints + 8;
+	bhaptics::Frame frame;
+	frame.Position = bhaptics::Position::VestFront;
+	frame.DurationMillis = 100;
+	bhaptics::SubmitRequest request = bhaptics::SubmitRequest::AsFrame("Path", frame);
+	for (int i = 0; i < pointCount; i++)
+	{
+		request.AllPathPoints.push_back(bhaptics::PathPoint(i * 1000 / pointCount, 500, 80));
+	}
+
+	bhaptics::HapticStats before, after;
+	GetHapticStats(before);
+	submitBatch(request);
+	GetHapticStats(after);
+	check(after.DroppedPathPoints - before.DroppedPathPoints == 8,
+		"SubmitBatch counts the path points past MaxPathPoints it drops");
+
+	SetRasterizePaths(true);
+	GetHapticStats(before);
+	submitBatch(request);
+	GetHapticStats(after);
+	SetRasterizePaths(false);
+	check(after.RasterizedPathPoints - before.RasterizedPathPoints == (uint64_t)pointCount
+		&& after.DroppedPathPoints == before.DroppedPathPoints, "SubmitBatch rasterizes every path point");
+}
+
+// Runs before Initialise, so no status has arrived yet.
+static void checkNoDevicesBeforeStatus()
+{
+	check(GetConnectedPositionMask() == 0, "GetConnectedPositionMask reports no devices before the first status");
+
+	bhaptics::HapticStats before, after;
+	GetHapticStats(before);
+	SetCullDisconnected(true);
+	std::string key = "Dot";
+	std::vector<bhaptics::DotPoint> points(1, bhaptics::DotPoint(0, 100));
+	SubmitDot(key, bhaptics::Position::VestFront, points, 100);
+	SetCullDisconnected(false);
+	GetHapticStats(after);
+	check(after.CulledSubmits == before.CulledSubmits, "SetCullDisconnected culls nothing before the first status");
+}
+
+static void checkDevicesAfterStatus()
+{
+	uint32_t mask = GetConnectedPositionMask();
+	check((mask & bhaptics::positionMask(bhaptics::Position::VestFront)) != 0,
+		"GetConnectedPositionMask reports the Player's devices after its status");
+}
+
+int main()
+{
+	signal(SIGPIPE, SIG_IGN);
+
+	bhaptics::MockOptions mockOptions;
+	mockOptions.reportSec = 0;
+	mockOptions.quiet = true;
+	bhaptics::MockPlayer mockPlayer(mockOptions);
+	if (!mockPlayer.start())
+	{
+		fprintf(stderr, "Could not start the Mock Player on ws://127.0.0.1:15881; is another Player running?\n");
+		return 1;
+	}
+	std::thread mockThread([&mockPlayer]() { mockPlayer.run(); });
+
+	checkNoDevicesBeforeStatus();
+
+	Initialise();
+	if (waitForStatus())
+	{
+		checkDevicesAfterStatus();
+		checkResponseStatus();
+		checkBatchTurnOffStopsSynth();
+		checkBatchLongPaths();
+	}
+	else
+	{
+		check(false, "connect to the Mock Player");
+	}
+
+	Destroy();
+	mockPlayer.stop();
+	mockThread.join();
+
+	printf("%s\n", failures == 0 ? "all checks passed" : "checks failed");
+	return failures == 0 ? 0 : 1;
+}
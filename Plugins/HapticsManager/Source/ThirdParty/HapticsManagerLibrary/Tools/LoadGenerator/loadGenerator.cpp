@@ -0,0 +1,597 @@
+//Copyright bHaptics Inc. 2017-2019
+// Drives the HapticLibrary from many producer threads, each calling the submit API at a fixed rate, and reports
+// throughput, call and submit latency, CPU usage and the time spent waiting on each of the client's locks.
+// Meant to run against the Mock Player, which --mock starts in-process. See Tools/README.md.
+#include "HapticLibrary.h"
+#include "latencyHistogram.h"
+#include "../MockPlayer/mockPlayer.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t running = 1;
+static std::atomic<bool> producing{ true }; // the signal flag is only for the main thread
+
+static void onSignal(int)
+{
+	running = 0;
+}
+
+enum Operation
+{
+	OpBytes,
+	OpDots,
+	OpPaths,
+	OpRegistered,
+	OpTurnOff,
+	OpCount,
+};
+
+static const char* OperationNames[OpCount] = { "bytes", "dots", "paths", "registered", "turnoff" };
+
+static const bhaptics::Position Positions[] = {
+	bhaptics::Position::VestFront, bhaptics::Position::VestBack, bhaptics::Position::Head,
+	bhaptics::Position::ForearmL, bhaptics::Position::ForearmR,
+};
+
+struct LoadOptions
+{
+	int threads = 4;
+	int rateHz = 60;
+	int durationSec = 10;
+	int reportSec = 1;
+	int points = 5;
+	int frameMillis = 100;
+	int registeredKeys = 4;
+	int weights[OpCount] = { 30, 20, 20, 25, 5 };
+	bool compress = false;
+	bool stress = false;
+	bool mock = false;
+	std::string tracePath;
+};
+
+struct OpCounters
+{
+	std::atomic<uint64_t> calls{ 0 };
+	bhaptics::LatencyHistogram callLatency;
+};
+
+struct LoadCounters
+{
+	OpCounters operations[OpCount];
+	std::atomic<uint64_t> lateTicks{ 0 };
+	std::atomic<uint64_t> queries{ 0 };
+	std::atomic<uint64_t> lifecycles{ 0 };
+	std::atomic<uint64_t> audioBuffers{ 0 };
+};
+
+static void printUsage()
+{
+	printf("usage: loadGenerator [--threads 4] [--rate 60] [--duration 10] [--report 1] [--points 5] [--frame 100]\n"
+		"                     [--registered-keys 4] [--mix bytes=30,dots=20,paths=20,registered=25,turnoff=5]\n"
+		"                     [--compress] [--trace trace.json] [--stress] [--mock]\n");
+}
+
+static bool parseMix(const std::string& mix, int weights[OpCount])
+{
+	for (int op = 0; op < OpCount; op++)
+	{
+		weights[op] = 0;
+	}
+
+	std::stringstream list(mix);
+	std::string entry;
+	while (std::getline(list, entry, ','))
+	{
+		size_t equals = entry.find('=');
+		if (equals == std::string::npos)
+		{
+			return false;
+		}
+		std::string name = entry.substr(0, equals);
+		int op = 0;
+		while (op < OpCount && name != OperationNames[op])
+		{
+			op++;
+		}
+		if (op == OpCount)
+		{
+			return false;
+		}
+		weights[op] = atoi(entry.c_str() + equals + 1);
+	}
+	return true;
+}
+
+static std::string registeredKey(int index)
+{
+	return "Load" + std::to_string(index);
+}
+
+static std::string projectJson(int durationMillis)
+{
+	return "{\"mediaFileDuration\":" + std::to_string(durationMillis / 1000.0) + ",\"layout\":{\"type\":\"Tactot\"},\"tracks\":[]}";
+}
+
+static bhaptics::AudioHapticsConfig audioConfig(bool enable)
+{
+	bhaptics::AudioHapticsConfig config;
+	if (enable)
+	{
+		config.Routes.push_back(bhaptics::AudioHapticsRoute());
+	}
+	return config;
+}
+
+// --stress: every call is followed by a status query, and registrations, feedback toggles, scheduled submits and
+// procedural effects are mixed in, so every public entry point runs concurrently with the submits, the scheduler and
+// the latency probes on the timer thread. Meant for builds with -fsanitize=thread.
+static void stressQueries(int tick, const std::string& key, bhaptics::Position position, const LoadOptions& options,
+	LoadCounters& counters)
+{
+	std::string registered = registeredKey(tick % options.registeredKeys);
+	switch (tick % 10)
+	{
+	case 0:
+		IsPlaying();
+		break;
+	case 1:
+	{
+		std::string playingKey = key;
+		IsPlayingKey(playingKey);
+		break;
+	}
+	case 2:
+		IsDevicePlaying(position);
+		break;
+	case 3:
+	{
+		std::vector<bhaptics::HapticFeedback> status;
+		GetResponseStatus(status);
+		break;
+	}
+	case 4:
+		IsFeedbackRegistered(registered);
+		break;
+	case 5:
+	{
+		bhaptics::HapticStats stats;
+		GetHapticStats(stats);
+		break;
+	}
+	case 6:
+	{
+		std::vector<bhaptics::DotPoint> dots = { bhaptics::DotPoint(tick % 20, 50) };
+		std::vector<bhaptics::ScheduledSubmit> scheduled;
+		scheduled.push_back(bhaptics::ScheduledSubmit::After(5 + tick % 20,
+			bhaptics::SubmitRequest::AsFrame(key, bhaptics::Frame::AsDotPointFrame(dots, position, options.frameMillis))));
+		scheduled.push_back(bhaptics::ScheduledSubmit::AtOnset(30 + tick % 50,
+			bhaptics::SubmitRequest::AsFrame(key, bhaptics::Frame::AsDotPointFrame(dots, position, options.frameMillis))));
+		SubmitScheduled(scheduled);
+		break;
+	}
+	case 7:
+	{
+		std::string scheduledKey = key;
+		CancelScheduled(scheduledKey);
+		break;
+	}
+	case 8:
+	{
+		bhaptics::LinkLatency latency;
+		GetLinkLatency(latency);
+		break;
+	}
+	default:
+	{
+		std::string synthKey = key + "Synth";
+		bhaptics::SynthEffect effect;
+		effect.Position = position;
+		effect.Shape = bhaptics::WaveShape::Sine;
+		effect.FrequencyHz = 2.0f + tick % 8;
+		effect.Envelope.ReleaseMillis = 50;
+		if (tick % 40 == 9)
+		{
+			PlaySynth(synthKey, effect);
+		}
+		else if (tick % 40 == 29)
+		{
+			ReleaseSynth(synthKey);
+		}
+		else
+		{
+			UpdateSynth(synthKey, effect);
+		}
+		break;
+	}
+	}
+
+	if (tick % 50 == 0)
+	{
+		std::string project = projectJson(500);
+		RegisterFeedback(registered, project);
+	}
+	if (tick % 200 == 0)
+	{
+		ToggleFeedback();
+		ToggleFeedback();
+	}
+	if (tick % 300 == 150)
+	{
+		// Reconfigures audio haptics under the audio thread's feet, switching it off and on again.
+		bhaptics::AudioHapticsConfig config = audioConfig(tick % 600 != 150);
+		SetAudioHaptics(config);
+	}
+	counters.queries.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void produce(int producer, const LoadOptions& options, LoadCounters& counters)
+{
+	std::mt19937 random(1000 + producer);
+	int totalWeight = 0;
+	for (int op = 0; op < OpCount; op++)
+	{
+		totalWeight += options.weights[op];
+	}
+	std::uniform_int_distribution<int> pickOperation(0, totalWeight - 1);
+	std::uniform_int_distribution<int> pickIndex(0, 19);
+	std::uniform_int_distribution<int> pickCoordinate(0, 1000);
+	std::uniform_int_distribution<int> pickIntensity(10, 100);
+
+	std::string key = "Producer" + std::to_string(producer);
+	std::vector<uint8_t> motorBytes(20, 0);
+	std::vector<bhaptics::DotPoint> dots;
+	std::vector<bhaptics::PathPoint> paths;
+
+	Clock::duration period = std::chrono::microseconds(1000000 / options.rateHz);
+	Clock::time_point next = Clock::now();
+	for (int tick = 0; producing; tick++)
+	{
+		next += period;
+		Clock::time_point now = Clock::now();
+		if (now > next + period)
+		{
+			// Too far behind to catch up without bursting: count the lost ticks and restart the schedule.
+			counters.lateTicks.fetch_add(1, std::memory_order_relaxed);
+			next = now;
+		}
+		std::this_thread::sleep_until(next);
+
+		int roll = pickOperation(random);
+		int op = 0;
+		while (roll >= options.weights[op])
+		{
+			roll -= options.weights[op];
+			op++;
+		}
+
+		bhaptics::Position position = Positions[tick % (sizeof(Positions) / sizeof(Positions[0]))];
+		Clock::time_point start;
+		switch (op)
+		{
+		case OpBytes:
+			for (size_t i = 0; i < motorBytes.size(); i++)
+			{
+				motorBytes[i] = (uint8_t)(i % 4 == (size_t)tick % 4 ? pickIntensity(random) : 0);
+			}
+			start = Clock::now();
+			Submit(key, position, motorBytes, options.frameMillis);
+			break;
+		case OpDots:
+			dots.clear();
+			for (int i = 0; i < options.points; i++)
+			{
+				dots.push_back(bhaptics::DotPoint(pickIndex(random), pickIntensity(random)));
+			}
+			start = Clock::now();
+			SubmitDot(key, position, dots, options.frameMillis);
+			break;
+		case OpPaths:
+			paths.clear();
+			for (int i = 0; i < options.points; i++)
+			{
+				paths.push_back(bhaptics::PathPoint(pickCoordinate(random), pickCoordinate(random), pickIntensity(random)));
+			}
+			start = Clock::now();
+			SubmitPath(key, position, paths, options.frameMillis);
+			break;
+		case OpRegistered:
+		{
+			std::string registered = registeredKey(tick % options.registeredKeys);
+			std::string altKey = registered + "-" + key;
+			bhaptics::ScaleOption scale;
+			scale.Intensity = 0.5f + (tick % 4) * 0.25f;
+			scale.Duration = 1.0f;
+			bhaptics::RotationOption rotation;
+			rotation.OffsetAngleX = (float)((tick * 45) % 360);
+			rotation.OffsetY = 0;
+			start = Clock::now();
+			SubmitRegisteredAlt(registered, altKey, scale, rotation);
+			break;
+		}
+		default:
+			start = Clock::now();
+			TurnOffKey(key);
+			break;
+		}
+
+		uint64_t micros = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+		counters.operations[op].callLatency.record(micros);
+		counters.operations[op].calls.fetch_add(1, std::memory_order_relaxed);
+
+		if (options.stress)
+		{
+			stressQueries(tick, key, position, options, counters);
+		}
+	}
+}
+
+static double cpuSeconds()
+{
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static void printLockWait(const char* name, uint64_t waitNanos, double producerSeconds)
+{
+	printf("  %-12s %10.3f ms  %6.3f%% of producer time\n", name, waitNanos / 1e6,
+		producerSeconds > 0 ? waitNanos / 1e9 / producerSeconds * 100 : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+	LoadOptions options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--threads" && hasValue) { options.threads = atoi(argv[++i]); }
+		else if (arg == "--rate" && hasValue) { options.rateHz = atoi(argv[++i]); }
+		else if (arg == "--duration" && hasValue) { options.durationSec = atoi(argv[++i]); }
+		else if (arg == "--report" && hasValue) { options.reportSec = atoi(argv[++i]); }
+		else if (arg == "--points" && hasValue) { options.points = atoi(argv[++i]); }
+		else if (arg == "--frame" && hasValue) { options.frameMillis = atoi(argv[++i]); }
+		else if (arg == "--registered-keys" && hasValue) { options.registeredKeys = atoi(argv[++i]); }
+		else if (arg == "--mix" && hasValue)
+		{
+			if (!parseMix(argv[++i], options.weights))
+			{
+				printUsage();
+				return 1;
+			}
+		}
+		else if (arg == "--compress") { options.compress = true; }
+		else if (arg == "--trace" && hasValue) { options.tracePath = argv[++i]; }
+		else if (arg == "--stress") { options.stress = true; }
+		else if (arg == "--mock") { options.mock = true; }
+		else { printUsage(); return 1; }
+	}
+
+	int totalWeight = 0;
+	for (int op = 0; op < OpCount; op++)
+	{
+		totalWeight += options.weights[op] > 0 ? options.weights[op] : 0;
+		options.weights[op] = options.weights[op] > 0 ? options.weights[op] : 0;
+	}
+	if (options.threads < 1 || options.rateHz < 1 || options.rateHz > 1000000 || options.durationSec < 1
+		|| options.points < 1 || options.registeredKeys < 1 || totalWeight == 0)
+	{
+		printUsage();
+		return 1;
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	// The in-process Player runs on its own thread, so the run needs nothing else and sanitizers see both ends.
+	bhaptics::MockOptions mockOptions;
+	mockOptions.reportSec = 0;
+	mockOptions.quiet = true;
+	bhaptics::MockPlayer mockPlayer(mockOptions);
+	std::thread mockThread;
+	if (options.mock)
+	{
+		if (!mockPlayer.start())
+		{
+			fprintf(stderr, "Could not start the Mock Player on ws://127.0.0.1:15881; is another Player running?\n");
+			return 1;
+		}
+		mockThread = std::thread([&mockPlayer]() { mockPlayer.run(); });
+	}
+
+	if (!options.tracePath.empty())
+	{
+		StartTrace(1 << 20, options.tracePath);
+	}
+
+	SetCompression(options.compress);
+	Initialise();
+	for (int i = 0; i < options.registeredKeys; i++)
+	{
+		std::string key = registeredKey(i);
+		std::string project = projectJson(500);
+		RegisterFeedback(key, project);
+	}
+
+	// Registrations go out with the connection, on the library's timer thread.
+	Clock::time_point connectDeadline = Clock::now() + std::chrono::seconds(3);
+	bhaptics::HapticStats stats;
+	do
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		GetHapticStats(stats);
+	} while (running && stats.MessagesReceived == 0 && Clock::now() < connectDeadline);
+	if (stats.MessagesReceived == 0)
+	{
+		fprintf(stderr, "No status from the Player on ws://127.0.0.1:15881; is the Mock Player running, or pass --mock?\n");
+	}
+
+	printf("%d producers at %d Hz for %d s\n", options.threads, options.rateHz, options.durationSec);
+
+	LoadCounters counters;
+	bhaptics::HapticStats before;
+	GetHapticStats(before);
+	ResetSubmitLatency();
+	double cpuBefore = cpuSeconds();
+	Clock::time_point start = Clock::now();
+
+	std::vector<std::thread> producers;
+	for (int i = 0; i < options.threads; i++)
+	{
+		producers.push_back(std::thread(produce, i, std::cref(options), std::ref(counters)));
+	}
+
+	// In stress mode the connection is also torn down and re-established under the producers' feet, and one thread
+	// feeds audio haptics like an audio mixer: 10 ms of stereo 48 kHz audio every 10 ms.
+	std::thread lifecycle;
+	std::thread audio;
+	if (options.stress)
+	{
+		bhaptics::AudioHapticsConfig config = audioConfig(true);
+		SetAudioHaptics(config);
+		audio = std::thread([&counters]()
+		{
+			std::vector<float> buffer(480 * 2);
+			for (uint64_t frame = 0; producing; )
+			{
+				for (size_t i = 0; i < buffer.size(); i += 2, frame++)
+				{
+					buffer[i] = buffer[i + 1] = 0.5f * (float)std::sin(frame * 0.0079);
+				}
+				FeedAudio(buffer.data(), 480, 2, 48000);
+				counters.audioBuffers.fetch_add(1, std::memory_order_relaxed);
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		});
+
+		lifecycle = std::thread([&counters]()
+		{
+			while (producing)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(250));
+				Destroy();
+				Initialise();
+				counters.lifecycles.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+	}
+
+	Clock::time_point end = start + std::chrono::seconds(options.durationSec);
+	Clock::time_point nextReport = start + std::chrono::seconds(options.reportSec);
+	uint64_t reportedCalls = 0;
+	uint64_t reportedMessages = before.MessagesSent;
+	while (running && Clock::now() < end)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if (options.reportSec > 0 && Clock::now() >= nextReport)
+		{
+			uint64_t calls = 0;
+			for (int op = 0; op < OpCount; op++)
+			{
+				calls += counters.operations[op].calls.load(std::memory_order_relaxed);
+			}
+			GetHapticStats(stats);
+			printf("%6.1f s: %8.0f calls/s %8.0f messages/s, %llu dropped\n",
+				std::chrono::duration<double>(Clock::now() - start).count(),
+				(double)(calls - reportedCalls) / options.reportSec,
+				(double)(stats.MessagesSent - reportedMessages) / options.reportSec,
+				(unsigned long long)(stats.DroppedFrames - before.DroppedFrames));
+			reportedCalls = calls;
+			reportedMessages = stats.MessagesSent;
+			nextReport += std::chrono::seconds(options.reportSec);
+		}
+	}
+	producing = false;
+	for (auto& producer : producers)
+	{
+		producer.join();
+	}
+	if (lifecycle.joinable())
+	{
+		lifecycle.join();
+	}
+	if (audio.joinable())
+	{
+		audio.join();
+	}
+
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	double cpu = cpuSeconds() - cpuBefore;
+	GetHapticStats(stats);
+	bhaptics::SubmitLatencyStats latency;
+	GetSubmitLatency(latency);
+
+	uint64_t totalCalls = 0;
+	printf("\n%-12s %10s %10s %10s %10s %10s\n", "call", "count", "per sec", "p50 us", "p99 us", "max us");
+	for (int op = 0; op < OpCount; op++)
+	{
+		bhaptics::LatencyPercentiles percentiles = counters.operations[op].callLatency.percentiles();
+		totalCalls += percentiles.Count;
+		printf("%-12s %10llu %10.0f %10llu %10llu %10llu\n", OperationNames[op], (unsigned long long)percentiles.Count,
+			percentiles.Count / seconds, (unsigned long long)percentiles.P50Micros,
+			(unsigned long long)percentiles.P99Micros, (unsigned long long)percentiles.MaxMicros);
+	}
+	printf("%-12s %10llu %10.0f (target %d, %llu late ticks)\n", "total", (unsigned long long)totalCalls,
+		totalCalls / seconds, options.threads * options.rateHz, (unsigned long long)counters.lateTicks.load());
+
+	printf("\n%-12s %10s %10s %10s\n", "submit stage", "p50 us", "p99 us", "max us");
+	const bhaptics::LatencyPercentiles* stages[] = { &latency.Serialize, &latency.Enqueue, &latency.Send, &latency.Total };
+	const char* stageNames[] = { "serialize", "enqueue", "send", "total" };
+	for (int i = 0; i < 4; i++)
+	{
+		printf("%-12s %10llu %10llu %10llu\n", stageNames[i], (unsigned long long)stages[i]->P50Micros,
+			(unsigned long long)stages[i]->P99Micros, (unsigned long long)stages[i]->MaxMicros);
+	}
+
+	printf("\nmessages sent %llu (%.0f/s), dropped frames %llu, tx buffer high water %llu bytes\n",
+		(unsigned long long)(stats.MessagesSent - before.MessagesSent), (stats.MessagesSent - before.MessagesSent) / seconds,
+		(unsigned long long)(stats.DroppedFrames - before.DroppedFrames), (unsigned long long)stats.TxBufferHighWater);
+	if (options.compress)
+	{
+		// Cumulative since Initialise, so the registrations sent on connect are included.
+		bhaptics::TrafficStats traffic;
+		GetTrafficStats(traffic);
+		printf("compressed %llu messages; %llu payload bytes sent as %llu on the wire\n",
+			(unsigned long long)traffic.CompressedMessagesSent, (unsigned long long)traffic.PayloadBytesSent,
+			(unsigned long long)traffic.WireBytesSent);
+	}
+	printf("cpu %.3f s in %.3f s: %.1f%% of one core\n", cpu, seconds, cpu / seconds * 100);
+	if (options.stress)
+	{
+		printf("stress: %llu status queries, %llu reconnects, %llu audio buffers (%llu windows played, %llu dropped)\n",
+			(unsigned long long)counters.queries.load(), (unsigned long long)counters.lifecycles.load(),
+			(unsigned long long)counters.audioBuffers.load(), (unsigned long long)(stats.AudioWindows - before.AudioWindows),
+			(unsigned long long)(stats.DroppedAudioWindows - before.DroppedAudioWindows));
+	}
+
+	double producerSeconds = seconds * options.threads;
+	printf("\nlock wait\n");
+	printLockWait("pollingMtx", stats.PollingLockWaitNanos - before.PollingLockWaitNanos, producerSeconds);
+	printLockWait("mtx", stats.StateLockWaitNanos - before.StateLockWaitNanos, producerSeconds);
+	printLockWait("registerMtx", stats.RegisterLockWaitNanos - before.RegisterLockWaitNanos, producerSeconds);
+	printLockWait("responseMtx", stats.ResponseLockWaitNanos - before.ResponseLockWaitNanos, producerSeconds);
+
+	Destroy();
+	if (mockThread.joinable())
+	{
+		mockPlayer.stop();
+		mockThread.join();
+	}
+	return 0;
+}
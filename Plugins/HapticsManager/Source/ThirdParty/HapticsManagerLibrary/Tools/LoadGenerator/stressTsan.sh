@@ -0,0 +1,19 @@
+#!/bin/sh
+# Builds the Load Generator with ThreadSanitizer and runs --stress against the in-process Mock Player.
+# Exits non-zero on the first data race, lock inversion or other TSan report. Run from Tools/ or anywhere else.
+set -e
+
+TOOLS=$(cd "$(dirname "$0")/.." && pwd)
+LIB="$TOOLS/.."
+OUT=${OUT:-/tmp/loadGeneratorTsan}
+DURATION=${DURATION:-10}
+
+${CXX:-g++} -std=c++14 -O1 -g -fsanitize=thread -I"$LIB" "$TOOLS/LoadGenerator/loadGenerator.cpp" \
+	"$TOOLS/MockPlayer/mockServer.cpp" "$LIB/HapticLibrary.cpp" "$LIB/hapticsManager.cpp" "$LIB/easywsclient.cpp" \
+	"$LIB/timer.cpp" "$LIB/util.cpp" "$LIB/latencyHistogram.cpp" "$LIB/hapticStats.cpp" "$LIB/requestRecorder.cpp" \
+	"$LIB/traceLog.cpp" "$LIB/feedbackTransform.cpp" "$LIB/pathRasterizer.cpp" "$LIB/timingWheel.cpp" \
+	"$LIB/latencyEstimator.cpp" "$LIB/waveformSynth.cpp" "$LIB/audioHaptics.cpp" -o "$OUT" -pthread
+
+TSAN_OPTIONS="halt_on_error=1 exitcode=66 second_deadlock_stack=1 $TSAN_OPTIONS" \
+	"$OUT" --mock --stress --threads 8 --rate 200 --duration "$DURATION" --report 0
+echo "stress: no ThreadSanitizer reports"
@@ -0,0 +1,89 @@
+//Copyright bHaptics Inc. 2017-2019
+// Headless stand-in for the bHaptics Player, listening on the Player's WebSocket endpoint.
+// Accepts register/submit requests, simulates playback and streams PlayerResponse status messages.
+// Latency, jitter and stall knobs emulate a slow or hanging Player. See Tools/README.md.
+#include "mockPlayer.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <sstream>
+#include <string>
+
+static bhaptics::MockPlayer* player = nullptr;
+
+static void onSignal(int)
+{
+	if (player)
+	{
+		player->stop();
+	}
+}
+
+static void printUsage()
+{
+	printf("Usage: mockPlayer [options]\n"
+		"  --host <addr>          listen address (127.0.0.1)\n"
+		"  --port <port>          listen port (15881)\n"
+		"  --path <path>          WebSocket path (v2/feedbacks)\n"
+		"  --no-deflate           refuse permessage-deflate\n"
+		"  --status-hz <n>        status messages per second, 0 disables (20)\n"
+		"  --latency <ms>         delay before a request takes effect (0)\n"
+		"  --jitter <ms>          uniform +/- jitter added to the latency (0)\n"
+		"  --stall-every <s>      stop reading and responding every s seconds (0, never)\n"
+		"  --stall <ms>           length of each stall (0)\n"
+		"  --devices <a,b,...>    ConnectedPositions to report (Vest,ForearmL,ForearmR,Head,HandL,HandR,FootL,FootR)\n"
+		"  --report <s>           seconds between counter reports, 0 disables (5)\n"
+		"  --verbose              print every request\n");
+}
+
+int main(int argc, char** argv)
+{
+	bhaptics::MockOptions options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--host" && hasValue) { options.host = argv[++i]; }
+		else if (arg == "--port" && hasValue) { options.port = atoi(argv[++i]); }
+		else if (arg == "--path" && hasValue) { options.path = argv[++i]; }
+		else if (arg == "--no-deflate") { options.allowDeflate = false; }
+		else if (arg == "--status-hz" && hasValue) { options.statusHz = atoi(argv[++i]); }
+		else if (arg == "--latency" && hasValue) { options.latencyMillis = atoi(argv[++i]); }
+		else if (arg == "--jitter" && hasValue) { options.jitterMillis = atoi(argv[++i]); }
+		else if (arg == "--stall-every" && hasValue) { options.stallEverySec = atoi(argv[++i]); }
+		else if (arg == "--stall" && hasValue) { options.stallMillis = atoi(argv[++i]); }
+		else if (arg == "--report" && hasValue) { options.reportSec = atoi(argv[++i]); }
+		else if (arg == "--verbose") { options.verbose = true; }
+		else if (arg == "--devices" && hasValue)
+		{
+			options.devices.clear();
+			std::stringstream list(argv[++i]);
+			std::string device;
+			while (std::getline(list, device, ','))
+			{
+				if (!device.empty())
+				{
+					options.devices.push_back(device);
+				}
+			}
+		}
+		else { printUsage(); return 1; }
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	bhaptics::MockPlayer mock(options);
+	if (!mock.start())
+	{
+		return 1;
+	}
+	player = &mock;
+	mock.run();
+	player = nullptr;
+	return 0;
+}
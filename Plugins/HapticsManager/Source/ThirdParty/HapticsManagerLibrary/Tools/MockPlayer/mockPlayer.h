@@ -0,0 +1,443 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_MOCK_PLAYER
+#define BHAPTICS_MOCK_PLAYER
+
+#include "mockServer.h"
+#include "json.hpp"
+#include "motorLayout.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bhaptics
+{
+	struct MockOptions
+	{
+		std::string host = "127.0.0.1";
+		int port = 15881;
+		std::string path = "v2/feedbacks";
+		bool allowDeflate = true;
+		bool verbose = false;
+
+		int statusHz = 20;
+		int latencyMillis = 0;
+		int jitterMillis = 0;
+		int stallEverySec = 0;
+		int stallMillis = 0;
+		int reportSec = 5;
+		std::vector<std::string> devices = { "Vest", "ForearmL", "ForearmR", "Head", "HandL", "HandR", "FootL", "FootR" };
+		bool quiet = false; // no connection, stall or report lines, for a Player running inside another tool
+	};
+
+	// Positions in every status message, matching what the Player reports.
+	static const char* const MockStatusPositions[] = { "Left", "Right", "ForearmL", "ForearmR", "Head", "VestFront", "VestBack", "HandL", "HandR", "FootL", "FootR" };
+
+	// Headless stand-in for the bHaptics Player: accepts register/submit requests, simulates playback and streams
+	// PlayerResponse status messages. The mockPlayer tool runs one; tools that need a Player of their own run one on
+	// a thread.
+	class MockPlayer
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		typedef nlohmann::json json;
+
+		explicit MockPlayer(const MockOptions& options) : options(options), random(12345)
+		{
+			server.onOpen = [this](int client) { onOpen(client); };
+			server.onClose = [this](int client) { onClose(client); };
+			server.onMessage = [this](int client, const std::string& message) { onMessage(client, message); };
+		}
+
+		bool start()
+		{
+			if (!server.listen(options.host, options.port, options.path, options.allowDeflate))
+			{
+				return false;
+			}
+			if (!options.quiet)
+			{
+				printf("Mock Player listening on ws://%s:%d/%s\n", options.host.c_str(), options.port, options.path.c_str());
+			}
+			Clock::time_point now = Clock::now();
+			nextStatus = now;
+			nextReport = now + std::chrono::seconds(options.reportSec);
+			nextStall = now + std::chrono::seconds(options.stallEverySec);
+			return true;
+		}
+
+		// Serves until stop is called, from any thread or a signal handler.
+		void run()
+		{
+			while (running.load(std::memory_order_relaxed))
+			{
+				server.poll(1);
+
+				Clock::time_point now = Clock::now();
+				updateStall(now);
+				if (stalled)
+				{
+					continue;
+				}
+
+				processPending(now);
+				expireActive(now);
+
+				if (options.statusHz > 0 && now >= nextStatus)
+				{
+					sendStatus();
+					nextStatus = now + std::chrono::microseconds(1000000 / options.statusHz);
+				}
+
+				if (options.reportSec > 0 && !options.quiet && now >= nextReport)
+				{
+					report();
+					nextReport = now + std::chrono::seconds(options.reportSec);
+				}
+			}
+			server.closeAll();
+		}
+
+		void stop()
+		{
+			running.store(false, std::memory_order_relaxed);
+		}
+
+	private:
+		struct PendingMessage
+		{
+			Clock::time_point due;
+			std::string message;
+		};
+
+		struct ActiveFeedback
+		{
+			Clock::time_point end;
+			std::map<std::string, std::vector<int>> motors;
+		};
+
+		MockOptions options;
+		MockServer server;
+		std::atomic<bool> running{ true };
+		std::mt19937 random;
+
+		std::deque<PendingMessage> pending;
+		std::map<std::string, int> registered; // key -> duration in milliseconds
+		std::map<std::string, ActiveFeedback> active;
+
+		Clock::time_point nextStatus;
+		Clock::time_point nextReport;
+		Clock::time_point nextStall;
+		Clock::time_point stallEnd;
+		bool stalled = false;
+
+		uint64_t messages = 0;
+		uint64_t submits = 0;
+		uint64_t registers = 0;
+		uint64_t statusSent = 0;
+		uint64_t parseErrors = 0;
+
+		void onOpen(int client)
+		{
+			if (options.quiet)
+			{
+				return;
+			}
+			bool deflate = server.connections().at(client).deflate;
+			printf("client %d connected%s\n", client, deflate ? " (permessage-deflate)" : "");
+		}
+
+		void onClose(int client)
+		{
+			if (options.quiet)
+			{
+				return;
+			}
+			const MockServer::Connection& connection = server.connections().at(client);
+			double saving = connection.payloadBytesReceived > 0
+				? 100.0 * (1.0 - (double)connection.wireBytesReceived / (double)connection.payloadBytesReceived) : 0.0;
+			printf("client %d closed: received %llu payload bytes in %llu wire bytes (%.1f%% saved)\n", client,
+				(unsigned long long)connection.payloadBytesReceived, (unsigned long long)connection.wireBytesReceived, saving);
+		}
+
+		void onMessage(int client, const std::string& message)
+		{
+			if (options.verbose)
+			{
+				printf("client %d: %zu bytes: %.120s\n", client, message.size(), message.c_str());
+			}
+
+			// Latency and jitter delay when a request takes effect, as a busy Player would.
+			int delay = options.latencyMillis;
+			if (options.jitterMillis > 0)
+			{
+				delay += std::uniform_int_distribution<int>(-options.jitterMillis, options.jitterMillis)(random);
+			}
+			PendingMessage entry;
+			entry.due = Clock::now() + std::chrono::milliseconds(std::max(0, delay));
+			entry.message = message;
+
+			// Keep the queue ordered by due time so jitter never reorders past the head.
+			std::deque<PendingMessage>::iterator it = pending.end();
+			while (it != pending.begin() && (it - 1)->due > entry.due)
+			{
+				--it;
+			}
+			pending.insert(it, entry);
+		}
+
+		void updateStall(Clock::time_point now)
+		{
+			if (options.stallEverySec <= 0 || options.stallMillis <= 0)
+			{
+				return;
+			}
+
+			if (!stalled && now >= nextStall)
+			{
+				stalled = true;
+				server.pauseReading = true;
+				stallEnd = now + std::chrono::milliseconds(options.stallMillis);
+				if (!options.quiet)
+				{
+					printf("stall for %d ms\n", options.stallMillis);
+				}
+			}
+			else if (stalled && now >= stallEnd)
+			{
+				stalled = false;
+				server.pauseReading = false;
+				nextStall = now + std::chrono::seconds(options.stallEverySec);
+			}
+		}
+
+		void processPending(Clock::time_point now)
+		{
+			while (!pending.empty() && pending.front().due <= now)
+			{
+				handleRequest(pending.front().message, now);
+				pending.pop_front();
+			}
+		}
+
+		void handleRequest(const std::string& message, Clock::time_point now)
+		{
+			messages++;
+
+			json request;
+			try
+			{
+				request = json::parse(message);
+			}
+			catch (const std::exception& e)
+			{
+				parseErrors++;
+				fprintf(stderr, "invalid request: %s\n", e.what());
+				return;
+			}
+
+			if (request.count("Register") && request["Register"].is_array())
+			{
+				for (auto& item : request["Register"])
+				{
+					registers++;
+					int duration = 1000;
+					const json& project = item["Project"];
+					if (project.is_object() && project.count("mediaFileDuration") && project["mediaFileDuration"].is_number())
+					{
+						duration = (int)(project["mediaFileDuration"].get<double>() * 1000);
+					}
+					registered[item.value("Key", "")] = duration;
+				}
+			}
+
+			if (request.count("Submit") && request["Submit"].is_array())
+			{
+				for (auto& item : request["Submit"])
+				{
+					submits++;
+					handleSubmit(item, now);
+				}
+			}
+		}
+
+		void handleSubmit(const json& item, Clock::time_point now)
+		{
+			std::string type = item.value("Type", "");
+			std::string key = item.value("Key", "");
+
+			if (type == "turnOffAll")
+			{
+				active.clear();
+			}
+			else if (type == "turnOff")
+			{
+				active.erase(key);
+			}
+			else if (type == "frame")
+			{
+				const json& frame = item["Frame"];
+				Position framePosition = (Position)frame.value("Position", 0);
+				std::string position = positionName(framePosition);
+				if (position.empty())
+				{
+					return;
+				}
+
+				const MotorLayout& layout = motorLayout(framePosition);
+				ActiveFeedback feedback;
+				feedback.end = now + std::chrono::milliseconds(frame.value("DurationMillis", 0));
+				std::vector<int>& motors = feedback.motors[position];
+				motors.assign(layout.MotorCount, 0);
+
+				if (frame.count("DotPoints"))
+				{
+					for (auto& dot : frame["DotPoints"])
+					{
+						int index = dot.value("Index", 0);
+						if (index >= 0 && index < layout.MotorCount)
+						{
+							motors[index] = std::max(motors[index], dot.value("Intensity", 0));
+						}
+					}
+				}
+				if (frame.count("PathPoints"))
+				{
+					// Nearest motor on the device's grid; close enough for a status preview.
+					for (auto& point : frame["PathPoints"])
+					{
+						int column = std::max(0, std::min(layout.Columns - 1, (int)(point.value("X", 0.0) * layout.Columns)));
+						int row = std::max(0, std::min(layout.Rows - 1, (int)(point.value("Y", 0.0) * layout.Rows)));
+						int index = row * layout.Columns + column;
+						motors[index] = std::max(motors[index], point.value("Intensity", 0));
+					}
+				}
+				active[key] = feedback;
+			}
+			else if (type == "key")
+			{
+				std::map<std::string, int>::iterator file = registered.find(key);
+				if (file == registered.end())
+				{
+					return;
+				}
+
+				double intensity = 1.0;
+				double duration = 1.0;
+				std::string playKey = key;
+				if (item.count("Parameters"))
+				{
+					const json& parameters = item["Parameters"];
+					if (parameters.count("scaleOption"))
+					{
+						intensity = parameters["scaleOption"].value("intensity", 1.0);
+						duration = parameters["scaleOption"].value("duration", 1.0);
+					}
+					if (parameters.count("altKey") && parameters["altKey"].is_string())
+					{
+						playKey = parameters["altKey"].get<std::string>();
+					}
+				}
+
+				// The mock does not interpret the project; it lights the centre of the vest instead.
+				ActiveFeedback feedback;
+				feedback.end = now + std::chrono::milliseconds((int)(file->second * duration));
+				const MotorLayout& layout = motorLayout(Position::VestFront);
+				std::vector<int>& motors = feedback.motors["VestFront"];
+				motors.assign(layout.MotorCount, 0);
+				int value = std::min(100, (int)(100 * intensity));
+				int centre = layout.Rows / 2 * layout.Columns + layout.Columns / 2;
+				motors[centre - 1] = motors[centre] = value;
+				active[playKey] = feedback;
+			}
+		}
+
+		void expireActive(Clock::time_point now)
+		{
+			for (std::map<std::string, ActiveFeedback>::iterator it = active.begin(); it != active.end();)
+			{
+				if (it->second.end <= now)
+				{
+					it = active.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		void sendStatus()
+		{
+			if (server.connections().empty())
+			{
+				return;
+			}
+
+			json status;
+			std::vector<std::string> registeredKeys;
+			for (auto& file : registered)
+			{
+				registeredKeys.push_back(file.first);
+			}
+			std::vector<std::string> activeKeys;
+			for (auto& feedback : active)
+			{
+				activeKeys.push_back(feedback.first);
+			}
+
+			status["RegisteredKeys"] = registeredKeys;
+			status["ActiveKeys"] = activeKeys;
+			status["ConnectedDeviceCount"] = (int)options.devices.size();
+			status["ConnectedPositions"] = options.devices;
+
+			json motorStatus = json::object();
+			for (const char* position : MockStatusPositions)
+			{
+				// Like the Player, report MaxMotors values for every device; those past its motors stay 0.
+				std::vector<int> motors(MaxMotors, 0);
+				for (auto& feedback : active)
+				{
+					std::map<std::string, std::vector<int>>::const_iterator values = feedback.second.motors.find(position);
+					if (values == feedback.second.motors.end())
+					{
+						continue;
+					}
+					for (size_t i = 0; i < values->second.size(); i++)
+					{
+						motors[i] = std::max(motors[i], values->second[i]);
+					}
+				}
+				motorStatus[position] = motors;
+			}
+			status["Status"] = motorStatus;
+
+			std::string message = status.dump();
+			for (auto& client : server.connections())
+			{
+				if (client.second.upgraded)
+				{
+					server.sendText(client.first, message);
+					statusSent++;
+				}
+			}
+		}
+
+		void report()
+		{
+			printf("messages %llu (submits %llu, registers %llu), status sent %llu, active %zu, pending %zu, parse errors %llu\n",
+				(unsigned long long)messages, (unsigned long long)submits, (unsigned long long)registers,
+				(unsigned long long)statusSent, active.size(), pending.size(), (unsigned long long)parseErrors);
+			fflush(stdout);
+		}
+	};
+}
+
+#endif
@@ -0,0 +1,576 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "mockServer.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace bhaptics
+{
+	static const size_t DEFLATE_MIN_SIZE = 256;
+
+	static uint32_t rotl(uint32_t value, int bits)
+	{
+		return (value << bits) | (value >> (32 - bits));
+	}
+
+	static std::string sha1(const std::string& input)
+	{
+		uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+		std::string data = input;
+		uint64_t bitLength = (uint64_t)input.size() * 8;
+		data.push_back((char)0x80);
+		while (data.size() % 64 != 56)
+		{
+			data.push_back(0);
+		}
+		for (int i = 7; i >= 0; i--)
+		{
+			data.push_back((char)((bitLength >> (i * 8)) & 0xff));
+		}
+
+		for (size_t chunk = 0; chunk < data.size(); chunk += 64)
+		{
+			uint32_t w[80];
+			for (int i = 0; i < 16; i++)
+			{
+				const uint8_t* p = (const uint8_t*)&data[chunk + i * 4];
+				w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+			}
+			for (int i = 16; i < 80; i++)
+			{
+				w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+			}
+
+			uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+			for (int i = 0; i < 80; i++)
+			{
+				uint32_t f, k;
+				if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+				else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+				else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+				else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+				uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+				e = d; d = c; c = rotl(b, 30); b = a; a = temp;
+			}
+			h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+		}
+
+		std::string digest;
+		for (int i = 0; i < 5; i++)
+		{
+			for (int j = 3; j >= 0; j--)
+			{
+				digest.push_back((char)((h[i] >> (j * 8)) & 0xff));
+			}
+		}
+		return digest;
+	}
+
+	static std::string base64(const std::string& input)
+	{
+		static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		std::string ret;
+		size_t i = 0;
+		for (; i + 2 < input.size(); i += 3)
+		{
+			uint32_t n = ((uint8_t)input[i] << 16) | ((uint8_t)input[i + 1] << 8) | (uint8_t)input[i + 2];
+			ret.push_back(table[(n >> 18) & 63]);
+			ret.push_back(table[(n >> 12) & 63]);
+			ret.push_back(table[(n >> 6) & 63]);
+			ret.push_back(table[n & 63]);
+		}
+		if (i < input.size())
+		{
+			uint32_t n = (uint8_t)input[i] << 16;
+			if (i + 1 < input.size())
+			{
+				n |= (uint8_t)input[i + 1] << 8;
+			}
+			ret.push_back(table[(n >> 18) & 63]);
+			ret.push_back(table[(n >> 12) & 63]);
+			ret.push_back(i + 1 < input.size() ? table[(n >> 6) & 63] : '=');
+			ret.push_back('=');
+		}
+		return ret;
+	}
+
+	std::string webSocketAccept(const std::string& key)
+	{
+		return base64(sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+	}
+
+	static std::string headerValue(const std::string& request, const std::string& name)
+	{
+		size_t pos = 0;
+		while ((pos = request.find("\r\n", pos)) != std::string::npos)
+		{
+			pos += 2;
+			if (strncasecmp(request.c_str() + pos, name.c_str(), name.size()) == 0 && request[pos + name.size()] == ':')
+			{
+				size_t start = request.find_first_not_of(' ', pos + name.size() + 1);
+				size_t end = request.find("\r\n", start);
+				return request.substr(start, end - start);
+			}
+		}
+		return "";
+	}
+
+	MockServer::MockServer()
+	{
+#ifdef BHAPTICS_WS_DEFLATE
+		memset(&deflater, 0, sizeof(deflater));
+		memset(&inflater, 0, sizeof(inflater));
+		deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+		inflateInit2(&inflater, -MAX_WBITS);
+#endif
+	}
+
+	MockServer::~MockServer()
+	{
+		closeAll();
+		if (listenFd >= 0)
+		{
+			::close(listenFd);
+		}
+#ifdef BHAPTICS_WS_DEFLATE
+		deflateEnd(&deflater);
+		inflateEnd(&inflater);
+#endif
+	}
+
+	bool MockServer::listen(const std::string& host, int port, const std::string& _path, bool _allowDeflate)
+	{
+		path = "/" + _path;
+#ifdef BHAPTICS_WS_DEFLATE
+		allowDeflate = _allowDeflate;
+#else
+		(void)_allowDeflate;
+		allowDeflate = false;
+#endif
+
+		listenFd = socket(AF_INET, SOCK_STREAM, 0);
+		if (listenFd < 0)
+		{
+			perror("socket");
+			return false;
+		}
+
+		int flag = 1;
+		setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)port);
+		inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+
+		if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listenFd, 16) < 0)
+		{
+			perror("bind");
+			::close(listenFd);
+			listenFd = -1;
+			return false;
+		}
+
+		fcntl(listenFd, F_SETFL, O_NONBLOCK);
+		return true;
+	}
+
+	void MockServer::poll(int timeoutMillis)
+	{
+		std::vector<pollfd> fds;
+		pollfd listener = { listenFd, POLLIN, 0 };
+		fds.push_back(listener);
+		for (auto& client : clients)
+		{
+			pollfd entry = { client.first, 0, 0 };
+			if (!pauseReading)
+			{
+				entry.events |= POLLIN;
+			}
+			if (!client.second.txbuf.empty())
+			{
+				entry.events |= POLLOUT;
+			}
+			fds.push_back(entry);
+		}
+
+		if (::poll(&fds[0], fds.size(), timeoutMillis) <= 0)
+		{
+			return;
+		}
+
+		if (fds[0].revents & POLLIN)
+		{
+			acceptClient();
+		}
+
+		for (size_t i = 1; i < fds.size(); i++)
+		{
+			int fd = fds[i].fd;
+			auto it = clients.find(fd);
+			if (it == clients.end())
+			{
+				continue;
+			}
+
+			Connection& connection = it->second;
+			bool alive = true;
+			if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+			{
+				// Frames that arrived just before the peer hung up are still handled.
+				alive = readClient(connection);
+				if (!connection.upgraded)
+				{
+					alive = alive && handshake(connection);
+				}
+				else
+				{
+					parseFrames(fd, connection);
+				}
+			}
+			if (alive && !connection.txbuf.empty())
+			{
+				alive = writeClient(connection);
+			}
+			if (!alive || (connection.closing && connection.txbuf.empty()))
+			{
+				dropClient(fd);
+			}
+		}
+	}
+
+	void MockServer::acceptClient()
+	{
+		int fd = accept(listenFd, nullptr, nullptr);
+		if (fd < 0)
+		{
+			return;
+		}
+
+		int flag = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+		fcntl(fd, F_SETFL, O_NONBLOCK);
+
+		Connection connection;
+		connection.fd = fd;
+		clients[fd] = connection;
+	}
+
+	bool MockServer::readClient(Connection& connection)
+	{
+		uint8_t buffer[16384];
+		while (true)
+		{
+			ssize_t ret = recv(connection.fd, buffer, sizeof(buffer), 0);
+			if (ret > 0)
+			{
+				connection.rxbuf.insert(connection.rxbuf.end(), buffer, buffer + ret);
+				if (connection.upgraded)
+				{
+					connection.wireBytesReceived += ret;
+				}
+				continue;
+			}
+			if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				return true;
+			}
+			return false;
+		}
+	}
+
+	bool MockServer::writeClient(Connection& connection)
+	{
+		while (!connection.txbuf.empty())
+		{
+			ssize_t ret = ::send(connection.fd, &connection.txbuf[0], connection.txbuf.size(), MSG_NOSIGNAL);
+			if (ret > 0)
+			{
+				connection.wireBytesSent += ret;
+				connection.txbuf.erase(connection.txbuf.begin(), connection.txbuf.begin() + ret);
+				continue;
+			}
+			if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				return true;
+			}
+			return false;
+		}
+		return true;
+	}
+
+	bool MockServer::handshake(Connection& connection)
+	{
+		std::string request(connection.rxbuf.begin(), connection.rxbuf.end());
+		size_t end = request.find("\r\n\r\n");
+		if (end == std::string::npos)
+		{
+			return true;
+		}
+		request.resize(end + 2);
+		connection.rxbuf.erase(connection.rxbuf.begin(), connection.rxbuf.begin() + end + 4);
+
+		size_t pathStart = request.find(' ');
+		size_t pathEnd = request.find(' ', pathStart + 1);
+		std::string requestPath = request.substr(pathStart + 1, pathEnd - pathStart - 1);
+		std::string key = headerValue(request, "Sec-WebSocket-Key");
+
+		if (request.compare(0, 4, "GET ") != 0 || requestPath != path || key.empty())
+		{
+			std::string response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+			connection.txbuf.insert(connection.txbuf.end(), response.begin(), response.end());
+			connection.closing = true;
+			return true;
+		}
+
+		std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n";
+		response += "Sec-WebSocket-Accept: " + webSocketAccept(key) + "\r\n";
+		if (allowDeflate && headerValue(request, "Sec-WebSocket-Extensions").find("permessage-deflate") != std::string::npos)
+		{
+			connection.deflate = true;
+			response += "Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover; server_no_context_takeover\r\n";
+		}
+		response += "\r\n";
+		connection.txbuf.insert(connection.txbuf.end(), response.begin(), response.end());
+		connection.upgraded = true;
+		connection.wireBytesReceived += connection.rxbuf.size();
+
+		if (onOpen)
+		{
+			onOpen(connection.fd);
+		}
+		return true;
+	}
+
+	void MockServer::parseFrames(int client, Connection& connection)
+	{
+		std::vector<uint8_t>& rxbuf = connection.rxbuf;
+		size_t offset = 0;
+
+		while (rxbuf.size() - offset >= 2)
+		{
+			const uint8_t* data = &rxbuf[offset];
+			bool fin = (data[0] & 0x80) != 0;
+			bool rsv1 = (data[0] & 0x40) != 0;
+			uint8_t opcode = data[0] & 0x0f;
+			bool masked = (data[1] & 0x80) != 0;
+			uint64_t length = data[1] & 0x7f;
+			size_t headerSize = 2 + (length == 126 ? 2 : 0) + (length == 127 ? 8 : 0) + (masked ? 4 : 0);
+			if (rxbuf.size() - offset < headerSize)
+			{
+				break;
+			}
+
+			size_t i = 2;
+			if (length == 126)
+			{
+				length = ((uint64_t)data[2] << 8) | data[3];
+				i = 4;
+			}
+			else if (length == 127)
+			{
+				length = 0;
+				for (int b = 0; b < 8; b++)
+				{
+					length = (length << 8) | data[2 + b];
+				}
+				i = 10;
+			}
+
+			if (rxbuf.size() - offset < headerSize + length)
+			{
+				break;
+			}
+
+			uint8_t mask[4] = { 0, 0, 0, 0 };
+			if (masked)
+			{
+				memcpy(mask, data + i, 4);
+			}
+
+			std::vector<uint8_t> payload(data + headerSize, data + headerSize + length);
+			for (size_t idx = 0; idx < payload.size(); idx++)
+			{
+				payload[idx] ^= mask[idx & 3];
+			}
+			offset += headerSize + (size_t)length;
+
+			if (opcode == 0x0 || opcode == 0x1 || opcode == 0x2)
+			{
+				if (opcode != 0x0)
+				{
+					connection.messageCompressed = connection.deflate && rsv1;
+				}
+				connection.message.insert(connection.message.end(), payload.begin(), payload.end());
+				if (fin)
+				{
+					if (connection.messageCompressed && !inflateMessage(connection.message))
+					{
+						fprintf(stderr, "Mock: could not inflate message\n");
+						connection.message.clear();
+					}
+					connection.payloadBytesReceived += connection.message.size();
+					std::string message(connection.message.begin(), connection.message.end());
+					connection.message.clear();
+					if (onMessage)
+					{
+						onMessage(client, message);
+					}
+				}
+			}
+			else if (opcode == 0x9)
+			{
+				sendFrame(connection, 0xa, payload.empty() ? nullptr : &payload[0], payload.size(), false);
+			}
+			else if (opcode == 0x8)
+			{
+				sendFrame(connection, 0x8, nullptr, 0, false);
+				connection.closing = true;
+				break;
+			}
+		}
+
+		rxbuf.erase(rxbuf.begin(), rxbuf.begin() + offset);
+	}
+
+	void MockServer::sendFrame(Connection& connection, uint8_t opcode, const uint8_t* data, size_t size, bool compressed)
+	{
+		uint8_t header[10];
+		size_t headerSize = 2;
+		header[0] = 0x80 | opcode | (compressed ? 0x40 : 0);
+		if (size < 126)
+		{
+			header[1] = (uint8_t)size;
+		}
+		else if (size < 65536)
+		{
+			header[1] = 126;
+			header[2] = (uint8_t)(size >> 8);
+			header[3] = (uint8_t)size;
+			headerSize = 4;
+		}
+		else
+		{
+			header[1] = 127;
+			for (int b = 0; b < 8; b++)
+			{
+				header[2 + b] = (uint8_t)((uint64_t)size >> (56 - b * 8));
+			}
+			headerSize = 10;
+		}
+		connection.txbuf.insert(connection.txbuf.end(), header, header + headerSize);
+		if (size > 0)
+		{
+			connection.txbuf.insert(connection.txbuf.end(), data, data + size);
+		}
+	}
+
+	void MockServer::sendText(int client, const std::string& message)
+	{
+		auto it = clients.find(client);
+		if (it == clients.end() || !it->second.upgraded || it->second.closing)
+		{
+			return;
+		}
+
+		Connection& connection = it->second;
+		connection.payloadBytesSent += message.size();
+
+		std::vector<uint8_t> compressed;
+		if (connection.deflate && message.size() >= DEFLATE_MIN_SIZE && deflateMessage(message, compressed))
+		{
+			sendFrame(connection, 0x1, &compressed[0], compressed.size(), true);
+			return;
+		}
+		sendFrame(connection, 0x1, (const uint8_t*)message.data(), message.size(), false);
+	}
+
+	void MockServer::closeAll()
+	{
+		while (!clients.empty())
+		{
+			dropClient(clients.begin()->first);
+		}
+	}
+
+	void MockServer::dropClient(int client)
+	{
+		auto it = clients.find(client);
+		if (it == clients.end())
+		{
+			return;
+		}
+
+		if (onClose && it->second.upgraded)
+		{
+			onClose(client);
+		}
+		::close(client);
+		clients.erase(it);
+	}
+
+	bool MockServer::deflateMessage(const std::string& message, std::vector<uint8_t>& out)
+	{
+#ifdef BHAPTICS_WS_DEFLATE
+		deflateReset(&deflater);
+		out.resize(deflateBound(&deflater, (uLong)message.size()) + 16);
+		deflater.next_in = (Bytef*)message.data();
+		deflater.avail_in = (uInt)message.size();
+		deflater.next_out = &out[0];
+		deflater.avail_out = (uInt)out.size();
+		if (deflate(&deflater, Z_SYNC_FLUSH) != Z_OK || deflater.avail_in != 0)
+		{
+			return false;
+		}
+		size_t produced = out.size() - deflater.avail_out;
+		if (produced < 4 || produced - 4 >= message.size())
+		{
+			return false;
+		}
+		out.resize(produced - 4);
+		return true;
+#else
+		(void)message;
+		(void)out;
+		return false;
+#endif
+	}
+
+	bool MockServer::inflateMessage(std::vector<uint8_t>& message)
+	{
+#ifdef BHAPTICS_WS_DEFLATE
+		static const uint8_t tail[4] = { 0x00, 0x00, 0xff, 0xff };
+		message.insert(message.end(), tail, tail + 4);
+		inflateReset(&inflater);
+		std::vector<uint8_t> out;
+		uint8_t chunk[16384];
+		inflater.next_in = &message[0];
+		inflater.avail_in = (uInt)message.size();
+		do
+		{
+			inflater.next_out = chunk;
+			inflater.avail_out = sizeof(chunk);
+			int ret = inflate(&inflater, Z_SYNC_FLUSH);
+			if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+			{
+				return false;
+			}
+			out.insert(out.end(), chunk, chunk + (sizeof(chunk) - inflater.avail_out));
+		} while (inflater.avail_out == 0);
+		message.swap(out);
+		return true;
+#else
+		(void)message;
+		return false;
+#endif
+	}
+}
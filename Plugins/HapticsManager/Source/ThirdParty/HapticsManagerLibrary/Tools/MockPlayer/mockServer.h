@@ -0,0 +1,91 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_MOCK_SERVER
+#define BHAPTICS_MOCK_SERVER
+
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef BHAPTICS_WS_DEFLATE
+#include <zlib.h>
+#endif
+
+namespace bhaptics
+{
+	// Minimal single-threaded WebSocket server (RFC 6455) for loopback testing of the library.
+	// Supports text/binary messages, ping/pong, close and permessage-deflate (RFC 7692, no context takeover).
+	// POSIX sockets only: it is meant for Linux/macOS soak and benchmark runs.
+	class MockServer
+	{
+	public:
+		struct Connection
+		{
+			int fd = -1;
+			bool upgraded = false;
+			bool deflate = false;
+			std::vector<uint8_t> rxbuf;
+			std::vector<uint8_t> txbuf;
+			std::vector<uint8_t> message;
+			bool messageCompressed = false;
+			bool closing = false;
+
+			uint64_t payloadBytesReceived = 0;
+			uint64_t wireBytesReceived = 0;
+			uint64_t payloadBytesSent = 0;
+			uint64_t wireBytesSent = 0;
+		};
+
+		typedef std::function<void(int client, const std::string& message)> MessageHandler;
+		typedef std::function<void(int client)> ConnectionHandler;
+
+		MockServer();
+		~MockServer();
+
+		bool listen(const std::string& host, int port, const std::string& path, bool allowDeflate);
+
+		// Accepts, reads and writes whatever is ready, waiting at most timeoutMillis.
+		void poll(int timeoutMillis);
+
+		void sendText(int client, const std::string& message);
+
+		void closeAll();
+
+		const std::map<int, Connection>& connections() const { return clients; }
+
+		MessageHandler onMessage;
+		ConnectionHandler onOpen;
+		ConnectionHandler onClose;
+
+		// When set, incoming data is left unread, emulating a stalled Player. Clients keep buffering.
+		bool pauseReading = false;
+
+	private:
+		int listenFd = -1;
+		std::string path;
+		bool allowDeflate = false;
+		std::map<int, Connection> clients;
+
+#ifdef BHAPTICS_WS_DEFLATE
+		z_stream deflater;
+		z_stream inflater;
+#endif
+
+		void acceptClient();
+		bool readClient(Connection& connection);
+		bool writeClient(Connection& connection);
+		bool handshake(Connection& connection);
+		void parseFrames(int client, Connection& connection);
+		void sendFrame(Connection& connection, uint8_t opcode, const uint8_t* data, size_t size, bool compressed);
+		void dropClient(int client);
+
+		bool deflateMessage(const std::string& message, std::vector<uint8_t>& out);
+		bool inflateMessage(std::vector<uint8_t>& message);
+	};
+
+	// SHA-1 and Base64, only used to compute Sec-WebSocket-Accept.
+	std::string webSocketAccept(const std::string& key);
+}
+
+#endif
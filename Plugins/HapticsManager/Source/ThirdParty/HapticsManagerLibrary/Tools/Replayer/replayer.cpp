@@ -0,0 +1,189 @@
+//Copyright bHaptics Inc. 2017-2019
+// Replays a session log recorded with StartRecording to the bHaptics Player or the Mock Player,
+// at the recorded pace (optionally scaled) or as fast as the socket accepts it. See Tools/README.md.
+#include "easywsclient.h"
+#include "requestRecorder.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+typedef std::chrono::steady_clock Clock;
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal(int)
+{
+	running = 0;
+}
+
+struct ReplayOptions
+{
+	std::string file;
+	std::string host = "127.0.0.1";
+	int port = 15881;
+	std::string path = "v2/feedbacks";
+	bool deflate = false;
+	double speed = 1.0;
+	bool asFastAsPossible = false;
+	int loops = 1;
+	bool verbose = false;
+};
+
+struct ReplayCounters
+{
+	uint64_t requests = 0;
+	uint64_t bytes = 0;
+	uint64_t statusReceived = 0;
+	uint64_t recordedStatus = 0;
+	int64_t maxLateMicros = 0;
+};
+
+static const size_t MaxBufferedBytes = 1024 * 1024;
+
+static void printUsage()
+{
+	printf("usage: replayer <session log> [--host 127.0.0.1] [--port 15881] [--path v2/feedbacks] [--deflate]\n"
+		"                [--speed 1.0 | --max] [--loop 1] [--verbose]\n");
+}
+
+static void drain(easywsclient::WebSocket* ws, ReplayCounters& counters, int timeoutMillis)
+{
+	ws->poll(timeoutMillis);
+	ws->dispatchChar([&counters](const char*) { counters.statusReceived++; });
+}
+
+static bool replay(const ReplayOptions& options, easywsclient::WebSocket* ws, ReplayCounters& counters)
+{
+	bhaptics::RecordingReader reader;
+	if (!reader.open(options.file))
+	{
+		return false;
+	}
+
+	Clock::time_point start = Clock::now();
+	bhaptics::RecordedMessage message;
+	while (running && reader.next(message) && ws->getReadyState() != easywsclient::WebSocket::CLOSED)
+	{
+		if (message.Type != bhaptics::RecordType::RequestSent)
+		{
+			counters.recordedStatus++;
+			continue;
+		}
+
+		if (!options.asFastAsPossible)
+		{
+			Clock::time_point due = start + std::chrono::microseconds((int64_t)(message.TimeMicros / options.speed));
+			Clock::time_point now = Clock::now();
+			while (running && now < due)
+			{
+				int waitMillis = (int)std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count();
+				if (waitMillis > 0)
+				{
+					drain(ws, counters, waitMillis);
+				}
+				else
+				{
+					std::this_thread::sleep_for(due - now);
+				}
+				now = Clock::now();
+			}
+
+			int64_t late = (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+			if (late > counters.maxLateMicros)
+			{
+				counters.maxLateMicros = late;
+			}
+		}
+
+		if (options.verbose)
+		{
+			printf("%10.3f ms %s\n", message.TimeMicros / 1000.0, message.Payload.c_str());
+		}
+
+		ws->send(message.Payload);
+		counters.requests++;
+		counters.bytes += message.Payload.size();
+		drain(ws, counters, 0);
+		while (running && ws->getBufferedAmount() > MaxBufferedBytes)
+		{
+			drain(ws, counters, 1);
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	ReplayOptions options;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--host" && hasValue) { options.host = argv[++i]; }
+		else if (arg == "--port" && hasValue) { options.port = atoi(argv[++i]); }
+		else if (arg == "--path" && hasValue) { options.path = argv[++i]; }
+		else if (arg == "--deflate") { options.deflate = true; }
+		else if (arg == "--speed" && hasValue) { options.speed = atof(argv[++i]); }
+		else if (arg == "--max") { options.asFastAsPossible = true; }
+		else if (arg == "--loop" && hasValue) { options.loops = atoi(argv[++i]); }
+		else if (arg == "--verbose") { options.verbose = true; }
+		else if (options.file.empty() && arg[0] != '-') { options.file = arg; }
+		else { printUsage(); return 1; }
+	}
+
+	if (options.file.empty() || options.speed <= 0 || options.loops < 1)
+	{
+		printUsage();
+		return 1;
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	easywsclient::WebSocket* ws = easywsclient::WebSocket::create(options.host, options.port, options.path, options.deflate);
+	if (ws == nullptr)
+	{
+		fprintf(stderr, "Could not connect to ws://%s:%d%s\n", options.host.c_str(), options.port, options.path.c_str());
+		return 1;
+	}
+
+	ReplayCounters counters;
+	Clock::time_point start = Clock::now();
+	for (int loop = 0; loop < options.loops && running && ws->getReadyState() != easywsclient::WebSocket::CLOSED; loop++)
+	{
+		if (!replay(options, ws, counters))
+		{
+			delete ws;
+			return 1;
+		}
+	}
+
+	while (ws->getBufferedAmount() > 0 && ws->getReadyState() != easywsclient::WebSocket::CLOSED)
+	{
+		drain(ws, counters, 1);
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	ws->close();
+	ws->poll();
+	easywsclient::TrafficStats traffic = ws->getTrafficStats();
+	delete ws;
+
+	printf("replayed %llu requests (%llu bytes, %llu on the wire) in %.3f s: %.0f requests/s\n",
+		(unsigned long long)counters.requests, (unsigned long long)counters.bytes,
+		(unsigned long long)traffic.wireBytesSent, seconds, seconds > 0 ? counters.requests / seconds : 0.0);
+	printf("received %llu status messages (%llu in the log)\n",
+		(unsigned long long)counters.statusReceived, (unsigned long long)(counters.recordedStatus / options.loops));
+	if (!options.asFastAsPossible)
+	{
+		printf("max lateness behind the recorded schedule: %.3f ms\n", counters.maxLateMicros / 1000.0);
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "audioHaptics.h"
+#include "motorLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bhaptics
+{
+	namespace
+	{
+		const float Pi = 3.14159265f;
+	}
+
+	void AudioHaptics::configure(const AudioHapticsConfig& newConfig)
+	{
+		{
+			std::lock_guard<std::mutex> lock(configMtx);
+			config = newConfig;
+			configVersion++;
+		}
+		enabled = !newConfig.Routes.empty();
+	}
+
+	void AudioHaptics::process(const float* samples, int frames, int channels, int sampleRate)
+	{
+		if (samples == nullptr || frames <= 0 || channels <= 0 || sampleRate <= 0)
+		{
+			return;
+		}
+
+		// Never wait for the game thread here: a configuration being written is picked up on a later buffer.
+		uint32_t version = configVersion.load(std::memory_order_acquire);
+		if (version != analysisVersion && configMtx.try_lock())
+		{
+			for (int i = 0; i < AudioBands - 1; i++)
+			{
+				crossoverHz[i] = config.CrossoverHz[i];
+			}
+			analysisVersion = version;
+			configMtx.unlock();
+			analysisRate = 0;
+		}
+		if (sampleRate != analysisRate)
+		{
+			updateCoefficients(sampleRate);
+		}
+
+		// The crossovers are recursive in time, so the per-sample work runs across the bands instead: fixed-size loops
+		// over AudioBands lanes, which compilers turn into single SIMD operations.
+		float gain = 1.0f / channels;
+		float bands[AudioBands];
+		for (int frame = 0; frame < frames; frame++)
+		{
+			const float* sample = samples + (size_t)frame * channels;
+			float mono = 0.0f;
+			for (int channel = 0; channel < channels; channel++)
+			{
+				mono += sample[channel];
+			}
+			mono *= gain;
+
+			for (int i = 0; i < AudioBands - 1; i++)
+			{
+				lowPass[i] += coefficients[i] * (mono - lowPass[i]);
+			}
+			bands[0] = lowPass[0];
+			for (int i = 1; i < AudioBands - 1; i++)
+			{
+				bands[i] = lowPass[i] - lowPass[i - 1];
+			}
+			bands[AudioBands - 1] = mono - lowPass[AudioBands - 2];
+
+			for (int i = 0; i < AudioBands; i++)
+			{
+				sumSquares[i] += bands[i] * bands[i];
+				peaks[i] = std::max(peaks[i], std::fabs(bands[i]));
+			}
+
+			if (++windowCount >= windowSamples)
+			{
+				flushWindow();
+			}
+		}
+	}
+
+	void AudioHaptics::render(TimePoint now, std::vector<SynthFrame>& frames, uint64_t& played, uint64_t& dropped)
+	{
+		frames.clear();
+		uint32_t version = configVersion.load(std::memory_order_acquire);
+		if (version != renderVersion)
+		{
+			std::lock_guard<std::mutex> lock(configMtx);
+			renderConfig = config;
+			renderVersion = version;
+		}
+		dropped += overflows.exchange(0, std::memory_order_relaxed);
+
+		// The loudest window since the last tick, so a transient shorter than a tick still plays.
+		float loudest[AudioBands] = {};
+		Window window;
+		while (windows.pop(window))
+		{
+			if (now - window.Captured > std::chrono::milliseconds(MaxLagMillis))
+			{
+				dropped++;
+				continue;
+			}
+			played++;
+			const float* measured = renderConfig.UsePeak ? window.Peak : window.Rms;
+			for (int i = 0; i < AudioBands; i++)
+			{
+				loudest[i] = std::max(loudest[i], measured[i]);
+			}
+		}
+
+		float elapsedMillis = lastRender == TimePoint() ? 0.0f
+			: std::chrono::duration_cast<std::chrono::microseconds>(now - lastRender).count() / 1000.0f;
+		lastRender = now;
+		float fall = renderConfig.ReleaseMillis > 0 ? elapsedMillis / renderConfig.ReleaseMillis : 1.0f;
+		float floorDb = std::min(renderConfig.FloorDb, -1.0f);
+		bool audible = false;
+		for (int i = 0; i < AudioBands; i++)
+		{
+			float target = 0.0f;
+			if (loudest[i] > 0.0f)
+			{
+				target = std::min(std::max((20.0f * std::log10(loudest[i]) - floorDb) / -floorDb, 0.0f), 1.0f);
+			}
+			levels[i] = std::max(target, levels[i] - fall);
+			audible = audible || levels[i] > 0.0f;
+		}
+		if (!audible)
+		{
+			return;
+		}
+
+		for (const AudioHapticsRoute& route : renderConfig.Routes)
+		{
+			const MotorLayout& layout = motorLayout(route.Position);
+			SynthFrame frame;
+			frame.Position = route.Position;
+			for (int i = 0; i < MaxMotors; i++)
+			{
+				frame.Dots[i] = 0;
+			}
+			for (int i = 0; i < layout.MotorCount; i++)
+			{
+				float level = 0.0f;
+				if (layout.Rows <= 1)
+				{
+					for (int band = 0; band < AudioBands; band++)
+					{
+						level = std::max(level, levels[band] * route.BandGains[band]);
+					}
+				}
+				else
+				{
+					// Row 0 is the top of the device; blend the two bands nearest to the row's height.
+					float height = (layout.Rows - 1 - layout.Y[i]) / (layout.Rows - 1) * (AudioBands - 1);
+					int lower = std::min((int)height, AudioBands - 2);
+					float blend = height - lower;
+					level = (1.0f - blend) * levels[lower] * route.BandGains[lower] + blend * levels[lower + 1] * route.BandGains[lower + 1];
+				}
+				frame.Dots[i] = std::min(100, std::max(0, (int)(100.0f * route.Gain * level + 0.5f)));
+			}
+			frames.push_back(frame);
+		}
+	}
+
+	void AudioHaptics::updateCoefficients(int sampleRate)
+	{
+		analysisRate = sampleRate;
+		for (int i = 0; i < AudioBands - 1; i++)
+		{
+			float cutoff = std::min(std::max(crossoverHz[i], 1.0f), sampleRate * 0.45f);
+			coefficients[i] = 1.0f - std::exp(-2.0f * Pi * cutoff / sampleRate);
+		}
+		windowSamples = std::max(1, sampleRate * WindowMillis / 1000);
+	}
+
+	void AudioHaptics::flushWindow()
+	{
+		Window window;
+		for (int i = 0; i < AudioBands; i++)
+		{
+			window.Rms[i] = std::sqrt(sumSquares[i] / windowCount);
+			window.Peak[i] = peaks[i];
+			sumSquares[i] = 0.0f;
+			peaks[i] = 0.0f;
+		}
+		window.Captured = std::chrono::steady_clock::now();
+		windowCount = 0;
+		if (!windows.push(window))
+		{
+			overflows.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+}
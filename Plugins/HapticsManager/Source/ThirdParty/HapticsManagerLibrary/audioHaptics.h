@@ -0,0 +1,118 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_AUDIO_HAPTICS
+#define BHAPTICS_AUDIO_HAPTICS
+
+#include "model.h"
+#include "waveformSynth.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+namespace bhaptics
+{
+	// Bounded queue between exactly one producer thread and one consumer thread. Neither side locks or allocates;
+	// push fails when the queue is full.
+	template<typename T, size_t Capacity>
+	class SpscRing
+	{
+	public:
+		bool push(const T& item)
+		{
+			size_t tail = writeIndex.load(std::memory_order_relaxed);
+			if (tail - readIndex.load(std::memory_order_acquire) == Capacity)
+			{
+				return false;
+			}
+			items[tail % Capacity] = item;
+			writeIndex.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool pop(T& item)
+		{
+			size_t head = readIndex.load(std::memory_order_relaxed);
+			if (head == writeIndex.load(std::memory_order_acquire))
+			{
+				return false;
+			}
+			item = items[head % Capacity];
+			readIndex.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+	private:
+		T items[Capacity];
+		std::atomic<size_t> writeIndex{ 0 };
+		std::atomic<size_t> readIndex{ 0 };
+	};
+
+	// Turns audio into motor frames. The audio thread splits the downmixed signal into AudioBands bands with one-pole
+	// crossovers and measures each band's RMS and peak over 20 ms windows, which it queues without locking. The timer
+	// thread takes the windows queued since its last tick, converts the band levels to intensities on a dB scale and
+	// spreads them over the layout of every routed device.
+	//
+	// Windows older than MaxLagMillis when taken are dropped, so a stalled timer thread never plays stale audio: audio
+	// reaches the socket at most about WindowMillis + MaxLagMillis after it was mixed.
+	class AudioHaptics
+	{
+	public:
+		typedef std::chrono::steady_clock::time_point TimePoint;
+
+		static const int WindowMillis = 20;
+		static const int MaxLagMillis = 40;
+		static const size_t QueueCapacity = 16;
+
+		// Any thread. The audio thread picks up new crossovers on its next buffer, the timer thread the rest on its next tick.
+		void configure(const AudioHapticsConfig& config);
+
+		bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+		// Audio thread only: analyses interleaved samples. Lock-free and allocation-free.
+		void process(const float* samples, int frames, int channels, int sampleRate);
+
+		// Timer thread only: replaces frames with one frame per route, or none while every band is silent. Adds the
+		// windows played and dropped since the last call to played and dropped.
+		void render(TimePoint now, std::vector<SynthFrame>& frames, uint64_t& played, uint64_t& dropped);
+
+	private:
+		struct Window
+		{
+			float Rms[AudioBands];
+			float Peak[AudioBands];
+			TimePoint Captured;
+		};
+
+		std::mutex configMtx;
+		AudioHapticsConfig config; // guarded by configMtx
+		std::atomic<uint32_t> configVersion{ 0 };
+		std::atomic<bool> enabled{ false };
+
+		SpscRing<Window, QueueCapacity> windows;
+		std::atomic<uint64_t> overflows{ 0 };
+
+		// Audio thread.
+		uint32_t analysisVersion = 0;
+		int analysisRate = 0;
+		float crossoverHz[AudioBands - 1] = {};
+		float coefficients[AudioBands - 1] = {};
+		float lowPass[AudioBands - 1] = {};
+		float sumSquares[AudioBands] = {};
+		float peaks[AudioBands] = {};
+		int windowSamples = 0;
+		int windowCount = 0;
+
+		// Timer thread.
+		uint32_t renderVersion = 0;
+		AudioHapticsConfig renderConfig;
+		float levels[AudioBands] = {};
+		TimePoint lastRender;
+
+		void updateCoefficients(int sampleRate);
+		void flushWindow();
+	};
+}
+
+#endif
@@ -50,6 +50,7 @@ typedef unsigned __int64 uint64_t;
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <stdint.h>
 #ifndef _SOCKET_T_DEFINED
 typedef int socket_t;
@@ -67,7 +68,11 @@ typedef int socket_t;
 #define SOCKET_EAGAIN_EINPROGRESS EAGAIN
 #define SOCKET_EWOULDBLOCK EWOULDBLOCK
 #endif
+#include <ctype.h>
 
+#ifdef BHAPTICS_WS_DEFLATE
+#include <zlib.h>
+#endif
 
 //#include <vld.h>
 
@@ -108,6 +113,16 @@ namespace easywsclient {
 		return sockfd;
 	}
 
+	// Case-insensitive check that an HTTP header line starts with the given header name.
+	inline bool header_is(const char* line, const char* name) {
+		for (; *name; ++line, ++name) {
+			if (tolower((unsigned char)*line) != tolower((unsigned char)*name)) {
+				return false;
+			}
+		}
+		return *line == ':';
+	}
+
 
 	class _RealWebSocket : public WebSocket
 	{
@@ -151,21 +166,110 @@ namespace easywsclient {
 
 		//		std::mutex mtx;
 
+		// Compressible messages shorter than this are still sent uncompressed; the deflate block overhead outweighs the gain.
+		static const size_t DEFLATE_MIN_SIZE = 256;
+
 		std::vector<uint8_t> rxbuf;
 		std::vector<uint8_t> txbuf;
 		std::vector<uint8_t> receivedData;
+		bool receivedCompressed = false;
+		std::string lastPong;
+		bool hasPong = false;
 
 		socket_t sockfd;
 		readyStateValues readyState;
 		bool useMask;
+		bool useDeflate;
+		TrafficStats traffic;
+
+#ifdef BHAPTICS_WS_DEFLATE
+		// Both directions negotiate no_context_takeover, so every message is a fresh raw deflate stream.
+		z_stream deflater;
+		z_stream inflater;
+		std::vector<uint8_t> deflated;
+#endif
 
-		_RealWebSocket(socket_t sockfd, bool useMask) : sockfd(sockfd), readyState(OPEN), useMask(useMask) {
+		_RealWebSocket(socket_t sockfd, bool useMask, bool useDeflate = false) : sockfd(sockfd), readyState(OPEN), useMask(useMask), useDeflate(useDeflate) {
+#ifdef BHAPTICS_WS_DEFLATE
+			if (useDeflate) {
+				memset(&deflater, 0, sizeof(deflater));
+				memset(&inflater, 0, sizeof(inflater));
+				deflateInit2(&deflater, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+				inflateInit2(&inflater, -MAX_WBITS);
+			}
+#else
+			this->useDeflate = false;
+#endif
+		}
+
+		~_RealWebSocket() {
+#ifdef BHAPTICS_WS_DEFLATE
+			if (useDeflate) {
+				deflateEnd(&deflater);
+				inflateEnd(&inflater);
+			}
+#endif
 		}
 
 		readyStateValues getReadyState() const {
 			return readyState;
 		}
 
+		bool isDeflateEnabled() const {
+			return useDeflate;
+		}
+
+		TrafficStats getTrafficStats() const {
+			return traffic;
+		}
+
+		size_t getBufferedAmount() const {
+			return txbuf.size();
+		}
+
+#ifdef BHAPTICS_WS_DEFLATE
+		// Compresses one message into 'deflated' (RFC 7692 7.2.1). Returns false if it did not shrink.
+		bool deflateMessage(const uint8_t* data, size_t size) {
+			deflateReset(&deflater);
+			deflated.resize(deflateBound(&deflater, (uLong)size) + 16);
+			deflater.next_in = (Bytef*)data;
+			deflater.avail_in = (uInt)size;
+			deflater.next_out = &deflated[0];
+			deflater.avail_out = (uInt)deflated.size();
+			if (deflate(&deflater, Z_SYNC_FLUSH) != Z_OK || deflater.avail_in != 0) {
+				return false;
+			}
+			size_t produced = deflated.size() - deflater.avail_out;
+			// Drop the 0x00 0x00 0xff 0xff tail of the sync flush, the receiver appends it back.
+			if (produced < 4 || produced - 4 >= size) {
+				return false;
+			}
+			deflated.resize(produced - 4);
+			return true;
+		}
+
+		bool inflateMessage(std::vector<uint8_t>& message) {
+			static const uint8_t tail[4] = { 0x00, 0x00, 0xff, 0xff };
+			message.insert(message.end(), tail, tail + 4);
+			inflateReset(&inflater);
+			std::vector<uint8_t> out;
+			uint8_t chunk[4096];
+			inflater.next_in = &message[0];
+			inflater.avail_in = (uInt)message.size();
+			do {
+				inflater.next_out = chunk;
+				inflater.avail_out = sizeof(chunk);
+				int ret = inflate(&inflater, Z_SYNC_FLUSH);
+				if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+					return false;
+				}
+				out.insert(out.end(), chunk, chunk + (sizeof(chunk) - inflater.avail_out));
+			} while (inflater.avail_out == 0);
+			message.swap(out);
+			return true;
+		}
+#endif
+
 		void poll(int timeout = 0) { // timeout in milliseconds
 			if (readyState == CLOSED) {
 				if (timeout > 0) {
@@ -204,6 +308,7 @@ namespace easywsclient {
 				}
 				else {
 					rxbuf.resize(N + ret);
+					traffic.wireBytesReceived += ret;
 				}
 			}
 			while (txbuf.size()) {
@@ -220,8 +325,12 @@ namespace easywsclient {
 					break;
 				}
 				else {
+					traffic.wireBytesSent += ret;
 					txbuf.erase(txbuf.begin(), txbuf.begin() + ret);
-					std::vector<uint8_t>().swap(txbuf);
+					if (txbuf.empty()) {
+						// Only release the buffer once drained: a partial send must keep the rest of the frame.
+						std::vector<uint8_t>().swap(txbuf);
+					}
 				}
 			}
 			if (!txbuf.size() && readyState == CLOSING) {
@@ -346,8 +455,19 @@ namespace easywsclient {
 							rxbuf[idx + ws.header_size] ^= ws.masking_key[idx & 0x3];
 						}
 					}
+					if (ws.opcode != wsheader_type::CONTINUATION) {
+						// RSV1 on the first frame marks a permessage-deflate message.
+						receivedCompressed = useDeflate && (data[0] & 0x40) == 0x40;
+					}
 					receivedData.insert(receivedData.end(), rxbuf.begin() + ws.header_size, rxbuf.begin() + ws.header_size + (size_t)ws.N);// just feed
 					if (ws.fin) {
+#ifdef BHAPTICS_WS_DEFLATE
+						if (receivedCompressed && !inflateMessage(receivedData)) {
+							fprintf(stderr, "ERROR: Could not inflate WebSocket message.\n");
+							receivedData.clear();
+						}
+#endif
+						traffic.payloadBytesReceived += receivedData.size();
 						callable((const std::vector<uint8_t>) receivedData);
 						receivedData.erase(receivedData.begin(), receivedData.end());
 						std::vector<uint8_t>().swap(receivedData);// free memory
@@ -363,7 +483,16 @@ namespace easywsclient {
 					std::string dataStr(rxbuf.begin() + ws.header_size, rxbuf.begin() + ws.header_size + (size_t)ws.N);
 					sendData(wsheader_type::PONG, dataStr.size(), dataStr.begin(), dataStr.end());
 				}
-				else if (ws.opcode == wsheader_type::PONG) {}
+				else if (ws.opcode == wsheader_type::PONG) {
+					if (ws.mask) {
+						for (size_t idx = 0; idx != ws.N; ++idx)
+						{
+							rxbuf[idx + ws.header_size] ^= ws.masking_key[idx & 0x3];
+						}
+					}
+					lastPong.assign(rxbuf.begin() + ws.header_size, rxbuf.begin() + ws.header_size + (size_t)ws.N);
+					hasPong = true;
+				}
 				else if (ws.opcode == wsheader_type::CLOSE) { close(); }
 				else { fprintf(stderr, "ERROR: Got unexpected WebSocket message.\n"); close(); }
 
@@ -377,10 +506,27 @@ namespace easywsclient {
 			sendData(wsheader_type::PING, empty.size(), empty.begin(), empty.end());
 		}
 
+		void sendPing(const std::string& payload) {
+			sendData(wsheader_type::PING, payload.size(), payload.begin(), payload.end());
+		}
+
+		bool takePong(std::string& payload) {
+			if (!hasPong) {
+				return false;
+			}
+			payload.swap(lastPong);
+			hasPong = false;
+			return true;
+		}
+
 		void send(const std::string& message) {
 			sendData(wsheader_type::TEXT_FRAME, message.size(), message.begin(), message.end());
 		}
 
+		void sendCompressed(const std::string& message) {
+			sendData(wsheader_type::TEXT_FRAME, message.size(), message.begin(), message.end(), true);
+		}
+
 		void sendBinary(const std::string& message) {
 			sendData(wsheader_type::BINARY_FRAME, message.size(), message.begin(), message.end());
 		}
@@ -390,7 +536,26 @@ namespace easywsclient {
 		}
 
 		template<class Iterator>
-		void sendData(wsheader_type::opcode_type type, uint64_t message_size, Iterator message_begin, Iterator message_end) {
+		void sendData(wsheader_type::opcode_type type, uint64_t message_size, Iterator message_begin, Iterator message_end, bool compress = false) {
+#ifdef BHAPTICS_WS_DEFLATE
+			if (compress && useDeflate && message_size >= DEFLATE_MIN_SIZE && readyState == OPEN
+				&& deflateMessage((const uint8_t*)&*message_begin, (size_t)message_size)) {
+				traffic.payloadBytesSent += message_size;
+				traffic.compressedMessagesSent++;
+				sendFrame(type, true, deflated.size(), deflated.begin(), deflated.end());
+				return;
+			}
+#else
+			(void)compress;
+#endif
+			if (type == wsheader_type::TEXT_FRAME || type == wsheader_type::BINARY_FRAME) {
+				traffic.payloadBytesSent += message_size;
+			}
+			sendFrame(type, false, message_size, message_begin, message_end);
+		}
+
+		template<class Iterator>
+		void sendFrame(wsheader_type::opcode_type type, bool compressed, uint64_t message_size, Iterator message_begin, Iterator message_end) {
 			// TODO:
 			// Masking key should (must) be derived from a high quality random
 			// number generator, to mitigate attacks on non-WebSocket friendly
@@ -403,7 +568,7 @@ namespace easywsclient {
 			}
 			std::vector<uint8_t> header;
 			header.assign(2 + (message_size >= 126 ? 2 : 0) + (message_size >= 65536 ? 6 : 0) + (useMask ? 4 : 0), 0);
-			header[0] = 0x80 | type;
+			header[0] = 0x80 | type | (compressed ? 0x40 : 0);
 			if (false) {}
 			else if (message_size < 126) {
 				header[1] = (message_size & 0xff) | (useMask ? 0x80 : 0);
@@ -472,21 +637,31 @@ namespace easywsclient {
 	public:
 		void poll(int timeout) { }
 		void send(const std::string& message) { }
+		void sendCompressed(const std::string&) { }
 		void sendBinary(const std::string& message) { }
 		void sendBinary(const std::vector<uint8_t>& message) { }
 		void sendPing() { }
+		void sendPing(const std::string&) { }
+		bool takePong(std::string&) { return false; }
 		void close() { }
 		readyStateValues getReadyState() const { return CLOSED; }
+		bool isDeflateEnabled() const { return false; }
+		TrafficStats getTrafficStats() const { return TrafficStats(); }
+		size_t getBufferedAmount() const { return 0; }
 		void _dispatch(CallbackImp & callable) { }
 		void _dispatchBinary(BytesCallbackImp& callable) { }
 		void _dispatchChar(CharCallbackImp & callable) { }
 	};
 
-	WebSocket::pointer  WebSocket::create(const std::string &hosts, int port, const std::string &_path) {
+	WebSocket::pointer  WebSocket::create(const std::string &hosts, int port, const std::string &_path, bool useDeflate) {
 
 		const char *host = hosts.c_str();
 		const char *path = _path.c_str();
 		std::string origin = "";
+		bool deflateAccepted = false;
+#ifndef BHAPTICS_WS_DEFLATE
+		useDeflate = false;
+#endif
 
 		socket_t sockfd = hostname_connect(host, port);
 		if (sockfd == INVALID_SOCKET) {
@@ -511,6 +686,9 @@ namespace easywsclient {
 			}
 			snprintf(line, 256, "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"); ::send(sockfd, line,(int) strlen(line), 0);
 			snprintf(line, 256, "Sec-WebSocket-Version: 13\r\n"); ::send(sockfd, line,(int) strlen(line), 0);
+			if (useDeflate) {
+				snprintf(line, 256, "Sec-WebSocket-Extensions: permessage-deflate; client_no_context_takeover; server_no_context_takeover\r\n"); ::send(sockfd, line, (int)strlen(line), 0);
+			}
 			snprintf(line, 256, "\r\n"); ::send(sockfd, line, (int)strlen(line), 0);
 			for (i = 0; i < 2 || (i < 255 && line[i - 2] != '\r' && line[i - 1] != '\n'); ++i)
 			{
@@ -543,6 +721,11 @@ namespace easywsclient {
 				{
 					break;
 				}
+				line[i] = 0;
+				if (useDeflate && header_is(line, "Sec-WebSocket-Extensions") && strstr(line, "permessage-deflate") != nullptr)
+				{
+					deflateAccepted = true;
+				}
 			}
 		}
 		int flag = 1;
@@ -553,7 +736,7 @@ namespace easywsclient {
 #else
 		fcntl(sockfd, F_SETFL, O_NONBLOCK);
 #endif
-		fprintf(stderr, "Connected to: ws://%s:%d/%s\n", host, port, path);
-		return pointer(new _RealWebSocket(sockfd, true));
+		fprintf(stderr, "Connected to: ws://%s:%d/%s%s\n", host, port, path, deflateAccepted ? " (permessage-deflate)" : "");
+		return pointer(new _RealWebSocket(sockfd, true, deflateAccepted));
 	}
 } // namespace easywsclient
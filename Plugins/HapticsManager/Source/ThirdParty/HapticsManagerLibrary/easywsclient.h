@@ -10,9 +10,21 @@
 
 #include <string>
 #include <vector>
+#include <stdint.h>
 
 namespace easywsclient {
 
+	// Cumulative traffic of one connection. Payload bytes are the application messages,
+	// wire bytes include frame headers and reflect permessage-deflate compression.
+	struct TrafficStats
+	{
+		uint64_t payloadBytesSent = 0;
+		uint64_t wireBytesSent = 0;
+		uint64_t payloadBytesReceived = 0;
+		uint64_t wireBytesReceived = 0;
+		uint64_t compressedMessagesSent = 0;
+	};
+
 	struct CallbackImp
 	{
 		virtual void operator()(const std::string& message) = 0;
@@ -33,16 +45,27 @@ namespace easywsclient {
 		typedef enum readyStateValues { CLOSING, CLOSED, CONNECTING, OPEN } readyStateValues;
 
 		// Factories:
-		static pointer create(const std::string &host, int port, const std::string &path);
+		// useDeflate offers permessage-deflate (RFC 7692) to the server. It only takes effect when the
+		// library is built with BHAPTICS_WS_DEFLATE (and zlib) and the server accepts the extension.
+		static pointer create(const std::string &host, int port, const std::string &path, bool useDeflate = false);
 		// Interfaces:
 		virtual ~WebSocket() { }
 		virtual void poll(int timeout = 0) = 0; // timeout in milliseconds
 		virtual void send(const std::string& message) = 0;
+		// Like send, but compressed with permessage-deflate when it was negotiated and the message is large enough.
+		virtual void sendCompressed(const std::string& message) = 0;
 		virtual void sendBinary(const std::string& message) = 0;
 		virtual void sendBinary(const std::vector<uint8_t>& message) = 0;
 		virtual void sendPing() = 0;
+		virtual void sendPing(const std::string& payload) = 0;
+		// Payload of the last PONG dispatched since the previous call; false if none arrived.
+		virtual bool takePong(std::string& payload) = 0;
 		virtual void close() = 0;
 		virtual readyStateValues getReadyState() const = 0;
+		virtual bool isDeflateEnabled() const = 0;
+		virtual TrafficStats getTrafficStats() const = 0;
+		// Bytes framed but not yet accepted by ::send.
+		virtual size_t getBufferedAmount() const = 0;
 
 		template<class Callable>
 		void dispatch(Callable callable)
@@ -0,0 +1,486 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "feedbackTransform.h"
+#include "json.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <exception>
+#include <tuple>
+
+namespace bhaptics
+{
+	// The Designer writes most numbers as strings ("0.500").
+	static float jsonNumber(const nlohmann::json& object, const char* name, float fallback)
+	{
+		nlohmann::json::const_iterator value = object.find(name);
+		if (value == object.end())
+		{
+			return fallback;
+		}
+		if (value->is_number())
+		{
+			return value->get<float>();
+		}
+		if (value->is_string())
+		{
+			return (float)atof(value->get<std::string>().c_str());
+		}
+		return fallback;
+	}
+
+	static const nlohmann::json* jsonArray(const nlohmann::json& object, const char* name)
+	{
+		nlohmann::json::const_iterator value = object.find(name);
+		return value != object.end() && value->is_array() ? &*value : nullptr;
+	}
+
+	static float fade(const nlohmann::json& feedback, float progress)
+	{
+		nlohmann::json::const_iterator type = feedback.find("playbackType");
+		if (type == feedback.end() || !type->is_string())
+		{
+			return 1;
+		}
+		const std::string& playbackType = type->get_ref<const std::string&>();
+		if (playbackType == "FADE_IN")
+		{
+			return progress;
+		}
+		if (playbackType == "FADE_OUT")
+		{
+			return 1 - progress;
+		}
+		if (playbackType == "FADE_IN_OUT")
+		{
+			return 1 - fabsf(2 * progress - 1);
+		}
+		return 1;
+	}
+
+	static int toIntensity(float value)
+	{
+		return std::max(0, std::min(100, (int)lroundf(value * 100)));
+	}
+
+	static CompiledTrack& trackFor(CompiledFeedback& feedback, Position position)
+	{
+		for (size_t i = 0; i < feedback.Tracks.size(); i++)
+		{
+			if (feedback.Tracks[i].Position == position)
+			{
+				return feedback.Tracks[i];
+			}
+		}
+
+		CompiledTrack track;
+		track.Position = position;
+		track.MotorCount = motorCount(position);
+		track.Dots.assign(feedback.FrameCount * track.MotorCount, 0);
+		track.Paths.resize(feedback.FrameCount);
+		feedback.Tracks.push_back(track);
+		return feedback.Tracks.back();
+	}
+
+	static void compileDots(const nlohmann::json& dotMode, float effectStart, float effectLength, int intervalMillis, CompiledTrack& track)
+	{
+		const nlohmann::json* feedbacks = jsonArray(dotMode, "feedback");
+		if (feedbacks == nullptr)
+		{
+			return;
+		}
+
+		for (const nlohmann::json& feedback : *feedbacks)
+		{
+			const nlohmann::json* points = jsonArray(feedback, "pointList");
+			if (points == nullptr || points->empty())
+			{
+				continue;
+			}
+
+			float start = jsonNumber(feedback, "startTime", 0);
+			float end = std::min(jsonNumber(feedback, "endTime", effectLength), effectLength);
+			float length = std::max(end - start, (float)intervalMillis);
+			int first = std::max(0, (int)ceilf((effectStart + start) / intervalMillis));
+			int last = std::min((int)track.Paths.size(), (int)ceilf((effectStart + start + length) / intervalMillis));
+			for (int frame = first; frame < last; frame++)
+			{
+				float factor = fade(feedback, (frame * intervalMillis - effectStart - start) / length);
+				for (const nlohmann::json& point : *points)
+				{
+					int index = (int)jsonNumber(point, "index", -1);
+					if (index < 0 || index >= track.MotorCount)
+					{
+						continue;
+					}
+					uint8_t& motor = track.dotsAt(frame)[index];
+					motor = (uint8_t)std::max((int)motor, toIntensity(jsonNumber(point, "intensity", 0) * factor));
+				}
+			}
+		}
+	}
+
+	static void compilePaths(const nlohmann::json& pathMode, float effectStart, float effectLength, int intervalMillis, CompiledTrack& track)
+	{
+		const nlohmann::json* feedbacks = jsonArray(pathMode, "feedback");
+		if (feedbacks == nullptr)
+		{
+			return;
+		}
+
+		for (const nlohmann::json& feedback : *feedbacks)
+		{
+			const nlohmann::json* points = jsonArray(feedback, "pointList");
+			if (points == nullptr || points->empty())
+			{
+				continue;
+			}
+
+			// A single point holds for the whole effect; otherwise the path runs from its first to its last point.
+			float start = points->size() == 1 ? 0 : jsonNumber(points->front(), "time", 0);
+			float end = points->size() == 1 ? effectLength : std::min(jsonNumber(points->back(), "time", 0), effectLength);
+			float length = std::max(end - start, 1.0f);
+			int first = std::max(0, (int)ceilf((effectStart + start) / intervalMillis));
+			int last = std::min((int)track.Paths.size(), (int)ceilf((effectStart + std::max(end, start + intervalMillis)) / intervalMillis));
+			size_t segment = 0;
+			for (int frame = first; frame < last; frame++)
+			{
+				float time = frame * intervalMillis - effectStart;
+				while (segment + 2 < points->size() && jsonNumber((*points)[segment + 1], "time", 0) <= time)
+				{
+					segment++;
+				}
+
+				const nlohmann::json& from = (*points)[segment];
+				const nlohmann::json& to = (*points)[std::min(segment + 1, points->size() - 1)];
+				float fromTime = jsonNumber(from, "time", 0);
+				float toTime = jsonNumber(to, "time", 0);
+				float t = toTime > fromTime ? std::max(0.0f, std::min(1.0f, (time - fromTime) / (toTime - fromTime))) : 0;
+				float x = jsonNumber(from, "x", 0) + (jsonNumber(to, "x", 0) - jsonNumber(from, "x", 0)) * t;
+				float y = jsonNumber(from, "y", 0) + (jsonNumber(to, "y", 0) - jsonNumber(from, "y", 0)) * t;
+				float intensity = jsonNumber(from, "intensity", 0) + (jsonNumber(to, "intensity", 0) - jsonNumber(from, "intensity", 0)) * t;
+				intensity *= fade(feedback, std::max(0.0f, std::min(1.0f, (time - start) / length)));
+
+				track.Paths[frame].push_back(PathPoint((int)lroundf(x * 1000), (int)lroundf(y * 1000), toIntensity(intensity)));
+			}
+		}
+	}
+
+	bool compileFeedback(const std::string& projectJson, int intervalMillis, CompiledFeedback& feedback)
+	{
+		if (projectJson.empty())
+		{
+			return false;
+		}
+
+		// The bundled json.hpp (2.0.7) has no non-throwing parse. A malformed project must not throw out of the library
+		// into the engine, which is built without exceptions, so the throw stops here.
+		nlohmann::json project;
+		try
+		{
+			project = nlohmann::json::parse(projectJson);
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+		const nlohmann::json* tracks = project.is_object() ? jsonArray(project, "tracks") : nullptr;
+		if (tracks == nullptr)
+		{
+			return false;
+		}
+
+		float duration = 0;
+		for (const nlohmann::json& track : *tracks)
+		{
+			const nlohmann::json* effects = jsonArray(track, "effects");
+			for (size_t i = 0; effects != nullptr && i < effects->size(); i++)
+			{
+				duration = std::max(duration, jsonNumber((*effects)[i], "startTime", 0) + jsonNumber((*effects)[i], "offsetTime", 0));
+			}
+		}
+
+		feedback.IntervalMillis = intervalMillis;
+		feedback.FrameCount = (int)ceilf(duration / intervalMillis);
+		feedback.Tracks.clear();
+		if (feedback.FrameCount == 0)
+		{
+			return false;
+		}
+
+		for (const nlohmann::json& track : *tracks)
+		{
+			nlohmann::json::const_iterator enable = track.find("enable");
+			const nlohmann::json* effects = jsonArray(track, "effects");
+			if (effects == nullptr || (enable != track.end() && enable->is_boolean() && !enable->get<bool>()))
+			{
+				continue;
+			}
+
+			for (const nlohmann::json& effect : *effects)
+			{
+				nlohmann::json::const_iterator modes = effect.find("modes");
+				if (modes == effect.end() || !modes->is_object())
+				{
+					continue;
+				}
+
+				float effectStart = jsonNumber(effect, "startTime", 0);
+				float effectLength = jsonNumber(effect, "offsetTime", 0);
+				for (nlohmann::json::const_iterator mode = modes->begin(); mode != modes->end(); ++mode)
+				{
+					Position position;
+					if (!positionFromName(mode.key(), position) || !mode.value().is_object())
+					{
+						continue;
+					}
+
+					nlohmann::json::const_iterator modeName = mode.value().find("mode");
+					bool isPath = modeName != mode.value().end() && modeName->is_string() && modeName->get<std::string>() == "PATH_MODE";
+					nlohmann::json::const_iterator data = mode.value().find(isPath ? "pathMode" : "dotMode");
+					if (data == mode.value().end() || !data->is_object())
+					{
+						continue;
+					}
+
+					CompiledTrack& compiled = trackFor(feedback, position);
+					if (isPath)
+					{
+						compilePaths(*data, effectStart, effectLength, intervalMillis, compiled);
+					}
+					else
+					{
+						compileDots(*data, effectStart, effectLength, intervalMillis, compiled);
+					}
+				}
+			}
+		}
+
+		return !feedback.Tracks.empty();
+	}
+
+	bool FeedbackTransformer::TransformKey::operator<(const TransformKey& other) const
+	{
+		return std::tie(Key, AngleStep, OffsetStep, IntensityStep, DurationStep)
+			< std::tie(other.Key, other.AngleStep, other.OffsetStep, other.IntensityStep, other.DurationStep);
+	}
+
+	FeedbackTransformer::FeedbackTransformer()
+	{
+		// Motor columns sit every 360 / RingColumns degrees around the vest, 45 for the Tactot, so rotating by a degrees
+		// moves each column a / 45 columns along the ring, between two neighbours.
+		for (int angle = 0; angle < AngleSteps; angle++)
+		{
+			for (int column = 0; column < RingColumns; column++)
+			{
+				float target = column + angle * RingColumns / 360.0f;
+				int first = (int)floorf(target);
+				float weight = target - first;
+				Spread& spread = columnTable[angle][column];
+				spread.First = (int8_t)(first % RingColumns);
+				spread.Second = (int8_t)((first + 1) % RingColumns);
+				spread.FirstWeight = 1 - weight;
+				spread.SecondWeight = weight;
+			}
+		}
+
+		// Rows are 0.25 apart from the top (y = 0); rows moved off the vest are dropped.
+		for (int offset = 0; offset < OffsetSteps; offset++)
+		{
+			float shift = -(offset - OffsetSteps / 2) / 100.0f * (Rows - 1);
+			for (int row = 0; row < Rows; row++)
+			{
+				float target = row + shift;
+				int first = (int)floorf(target);
+				float weight = target - first;
+				Spread& spread = rowTable[offset][row];
+				spread.First = (int8_t)(first >= 0 && first < Rows ? first : -1);
+				spread.Second = (int8_t)(first + 1 >= 0 && first + 1 < Rows ? first + 1 : -1);
+				spread.FirstWeight = 1 - weight;
+				spread.SecondWeight = weight;
+			}
+		}
+	}
+
+	void FeedbackTransformer::invalidate(const std::string& key)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		compiled.erase(key);
+		for (std::map<TransformKey, std::shared_ptr<const CompiledFeedback>>::iterator it = transforms.begin(); it != transforms.end();)
+		{
+			if (it->first.Key == key)
+			{
+				it = transforms.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	FeedbackTransformer::TransformKey FeedbackTransformer::makeKey(const std::string& key, const ScaleOption& scale, const RotationOption& rotation)
+	{
+		TransformKey transformKey;
+		transformKey.Key = key;
+		transformKey.AngleStep = ((int)lroundf(rotation.OffsetAngleX) % AngleSteps + AngleSteps) % AngleSteps;
+		transformKey.OffsetStep = std::max(-50, std::min(50, (int)lroundf(rotation.OffsetY * 100)));
+		transformKey.IntensityStep = std::max(0, (int)lroundf(scale.Intensity * 100));
+		transformKey.DurationStep = std::max(1, (int)lroundf(scale.Duration * 100));
+		return transformKey;
+	}
+
+	// Moves a path point around the vest cylinder; points rotated into the gap at either side snap to the nearer edge.
+	static bool rotatePathPoint(bool back, float x, float y, float angle, float offsetY, bool& toBack, float& rotatedX, float& rotatedY)
+	{
+		rotatedY = y - offsetY;
+		if (rotatedY < 0 || rotatedY > 1)
+		{
+			return false;
+		}
+
+		float degrees = (back ? 112.5f : -67.5f) + x * 135 + angle;
+		degrees = fmodf(degrees + 90, 360);
+		if (degrees < 0)
+		{
+			degrees += 360;
+		}
+		degrees -= 90; // -90 to 270, front centred on 0 and back on 180
+
+		toBack = degrees > 90;
+		float edge = toBack ? 112.5f : -67.5f;
+		rotatedX = std::max(0.0f, std::min(1.0f, (degrees - edge) / 135));
+		return true;
+	}
+
+	std::shared_ptr<const CompiledFeedback> FeedbackTransformer::apply(const CompiledFeedback& source, const TransformKey& key) const
+	{
+		std::shared_ptr<CompiledFeedback> result = std::make_shared<CompiledFeedback>();
+		float intensity = key.IntensityStep / 100.0f;
+		float duration = key.DurationStep / 100.0f;
+		float offsetY = key.OffsetStep / 100.0f;
+		result->IntervalMillis = source.IntervalMillis;
+		result->FrameCount = std::max(1, (int)ceilf(source.FrameCount * duration));
+
+		const CompiledTrack* vest[2] = { nullptr, nullptr };
+		for (const CompiledTrack& track : source.Tracks)
+		{
+			if (track.Position == Position::VestFront || track.Position == Position::VestBack)
+			{
+				vest[track.Position == Position::VestBack ? 1 : 0] = &track;
+			}
+			else
+			{
+				trackFor(*result, track.Position);
+			}
+		}
+		bool rotates = key.AngleStep != 0 || key.OffsetStep != 0;
+		CompiledTrack* rotated[2] = { nullptr, nullptr };
+		if (vest[0] != nullptr || vest[1] != nullptr)
+		{
+			rotated[0] = rotates || vest[0] != nullptr ? &trackFor(*result, Position::VestFront) : nullptr;
+			rotated[1] = rotates || vest[1] != nullptr ? &trackFor(*result, Position::VestBack) : nullptr;
+			// trackFor may have reallocated the vector: look both up again.
+			for (CompiledTrack& track : result->Tracks)
+			{
+				if (track.Position == Position::VestFront)
+				{
+					rotated[0] = &track;
+				}
+				else if (track.Position == Position::VestBack)
+				{
+					rotated[1] = &track;
+				}
+			}
+		}
+
+		const std::array<Spread, RingColumns>& columns = columnTable[key.AngleStep];
+		const std::array<Spread, Rows>& rows = rowTable[key.OffsetStep + OffsetSteps / 2];
+		for (int frame = 0; frame < result->FrameCount; frame++)
+		{
+			int sourceFrame = std::min(source.FrameCount - 1, (int)(frame / duration));
+
+			for (CompiledTrack& track : result->Tracks)
+			{
+				if (track.Position == Position::VestFront || track.Position == Position::VestBack)
+				{
+					continue;
+				}
+				const CompiledTrack* from = nullptr;
+				for (const CompiledTrack& candidate : source.Tracks)
+				{
+					from = candidate.Position == track.Position ? &candidate : from;
+				}
+				for (int i = 0; i < track.MotorCount; i++)
+				{
+					track.dotsAt(frame)[i] = (uint8_t)std::min(100, (int)lroundf(from->dotsAt(sourceFrame)[i] * intensity));
+				}
+				for (const PathPoint& point : from->Paths[sourceFrame])
+				{
+					track.Paths[frame].push_back(PathPoint((int)lroundf(point.x * 1000), (int)lroundf(point.y * 1000),
+						std::min(100, (int)lroundf(point.intensity * intensity)), point.MotorCount));
+				}
+			}
+
+			if (rotated[0] == nullptr && rotated[1] == nullptr)
+			{
+				continue;
+			}
+
+			float motors[2][VestMotors] = {};
+			for (int side = 0; side < 2; side++)
+			{
+				if (vest[side] == nullptr)
+				{
+					continue;
+				}
+
+				const uint8_t* dots = vest[side]->dotsAt(sourceFrame);
+				for (int i = 0; i < VestMotors; i++)
+				{
+					if (dots[i] == 0)
+					{
+						continue;
+					}
+					const Spread& column = columns[side * VestColumns + i % VestColumns];
+					const Spread& row = rows[i / VestColumns];
+					const int8_t targetColumns[2] = { column.First, column.Second };
+					const float columnWeights[2] = { column.FirstWeight, column.SecondWeight };
+					const int8_t targetRows[2] = { row.First, row.Second };
+					const float rowWeights[2] = { row.FirstWeight, row.SecondWeight };
+					for (int c = 0; c < 2; c++)
+					{
+						for (int r = 0; r < 2; r++)
+						{
+							if (targetRows[r] >= 0)
+							{
+								motors[targetColumns[c] / VestColumns][targetRows[r] * VestColumns + targetColumns[c] % VestColumns] += dots[i] * columnWeights[c] * rowWeights[r];
+							}
+						}
+					}
+				}
+
+				for (const PathPoint& point : vest[side]->Paths[sourceFrame])
+				{
+					bool toBack;
+					float x, y;
+					if (rotatePathPoint(side == 1, point.x, point.y, (float)key.AngleStep, offsetY, toBack, x, y))
+					{
+						rotated[toBack ? 1 : 0]->Paths[frame].push_back(PathPoint((int)lroundf(x * 1000), (int)lroundf(y * 1000),
+							std::min(100, (int)lroundf(point.intensity * intensity)), point.MotorCount));
+					}
+				}
+			}
+
+			for (int side = 0; side < 2; side++)
+			{
+				for (int i = 0; rotated[side] != nullptr && i < VestMotors; i++)
+				{
+					rotated[side]->dotsAt(frame)[i] = (uint8_t)std::min(100, (int)lroundf(motors[side][i] * intensity));
+				}
+			}
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,142 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_FEEDBACK_TRANSFORM
+#define BHAPTICS_FEEDBACK_TRANSFORM
+
+#include "motorLayout.h"
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace bhaptics
+{
+	// A registered feedback rendered into fixed-interval frames, one track per position it plays on.
+	struct CompiledTrack
+	{
+		bhaptics::Position Position;
+		int MotorCount; // of the device at Position
+		std::vector<uint8_t> Dots; // motor intensities 0-100, MotorCount per frame
+		std::vector<std::vector<PathPoint>> Paths; // path points per frame
+
+		uint8_t* dotsAt(int frame) { return &Dots[frame * MotorCount]; }
+		const uint8_t* dotsAt(int frame) const { return &Dots[frame * MotorCount]; }
+	};
+
+	struct CompiledFeedback
+	{
+		int IntervalMillis = 20;
+		int FrameCount = 0;
+		std::vector<CompiledTrack> Tracks;
+	};
+
+	// Renders the "project" of a .tact file into frames of intervalMillis. Handles dot and path modes with their
+	// fade playback types; returns false if the project has nothing to play.
+	bool compileFeedback(const std::string& projectJson, int intervalMillis, CompiledFeedback& feedback);
+
+	// Applies RotationOption and ScaleOption to compiled feedbacks on the client, so rotated hits can be sent as
+	// plain frames instead of asking the Player to transform a registered key.
+	//
+	// The vest is treated as a cylinder with its 8 motor columns 45 degrees apart: VestFront columns 0-3 at -67.5
+	// to 67.5 degrees and VestBack columns 0-3 continuing from 112.5 to 247.5. OffsetAngleX moves feedback towards
+	// increasing column angles, and a positive OffsetY moves it up (towards row 0), as computed by ProjectToVest.
+	// Dots are spread over the two nearest columns and rows through lookup tables quantized to 1 degree and 0.01
+	// OffsetY; path points are moved exactly. Other positions are only scaled.
+	//
+	// Results are cached per key and quantized options, so repeated angles cost a map lookup.
+	class FeedbackTransformer
+	{
+	public:
+		FeedbackTransformer();
+
+		// Returns the transformed feedback, compiling projectJson() on the first use of key.
+		// Returns null if the feedback cannot be compiled. Thread-safe.
+		template<class ProjectSource>
+		std::shared_ptr<const CompiledFeedback> transform(const std::string& key, ScaleOption scale, RotationOption rotation,
+			ProjectSource projectJson, bool& cacheHit)
+		{
+			TransformKey transformKey = makeKey(key, scale, rotation);
+			std::lock_guard<std::mutex> lock(mtx);
+			std::map<TransformKey, std::shared_ptr<const CompiledFeedback>>::const_iterator cached = transforms.find(transformKey);
+			cacheHit = cached != transforms.end();
+			if (cacheHit)
+			{
+				return cached->second;
+			}
+
+			std::map<std::string, std::shared_ptr<const CompiledFeedback>>::iterator source = compiled.find(key);
+			if (source == compiled.end())
+			{
+				std::shared_ptr<CompiledFeedback> feedback = std::make_shared<CompiledFeedback>();
+				if (!compileFeedback(projectJson(), IntervalMillis, *feedback))
+				{
+					feedback.reset();
+				}
+				source = compiled.insert(std::make_pair(key, std::shared_ptr<const CompiledFeedback>(feedback))).first;
+			}
+			if (!source->second)
+			{
+				return source->second;
+			}
+
+			if (transforms.size() >= MaxCachedTransforms)
+			{
+				transforms.clear();
+			}
+			std::shared_ptr<const CompiledFeedback> result = apply(*source->second, transformKey);
+			transforms[transformKey] = result;
+			return result;
+		}
+
+		// Drops the compiled and transformed copies of key, e.g. after it is registered again.
+		void invalidate(const std::string& key);
+
+		static const int IntervalMillis = 20;
+		static const size_t MaxCachedTransforms = 512;
+
+	private:
+		struct TransformKey
+		{
+			std::string Key;
+			int AngleStep;      // degrees, 0-359
+			int OffsetStep;     // hundredths of OffsetY, -50 to 50
+			int IntensityStep;  // hundredths
+			int DurationStep;   // hundredths
+
+			bool operator<(const TransformKey& other) const;
+		};
+
+		// Where one source column or row lands: two neighbours and their weights.
+		struct Spread
+		{
+			int8_t First;  // -1 if it falls outside the device
+			int8_t Second;
+			float FirstWeight;
+			float SecondWeight;
+		};
+
+		static const int AngleSteps = 360;
+		static const int OffsetSteps = 101;
+		// The columns of the two vest halves form one ring around the wearer, front then back.
+		static const int VestColumns = motorGrid(VestFront).Columns;
+		static const int VestMotors = VestColumns * motorGrid(VestFront).Rows;
+		static const int RingColumns = 2 * VestColumns;
+		static const int Rows = motorGrid(VestFront).Rows;
+		static_assert(motorGrid(VestBack).Columns == VestColumns && motorGrid(VestBack).Rows == Rows, "Both vest halves need the same grid");
+
+		std::array<std::array<Spread, RingColumns>, AngleSteps> columnTable;
+		std::array<std::array<Spread, Rows>, OffsetSteps> rowTable;
+
+		std::mutex mtx;
+		std::map<std::string, std::shared_ptr<const CompiledFeedback>> compiled; // null when the key cannot be compiled
+		std::map<TransformKey, std::shared_ptr<const CompiledFeedback>> transforms;
+
+		static TransformKey makeKey(const std::string& key, const ScaleOption& scale, const RotationOption& rotation);
+
+		std::shared_ptr<const CompiledFeedback> apply(const CompiledFeedback& source, const TransformKey& key) const;
+	};
+}
+
+#endif
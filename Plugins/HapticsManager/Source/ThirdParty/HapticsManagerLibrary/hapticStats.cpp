@@ -0,0 +1,60 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "hapticStats.h"
+
+#include <chrono>
+
+namespace bhaptics
+{
+	void StatsCounters::lock(std::mutex& mutex, std::atomic<uint64_t>& waitNanos)
+	{
+		if (mutex.try_lock())
+		{
+			return;
+		}
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		mutex.lock();
+		add(waitNanos, (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	HapticStats StatsCounters::snapshot() const
+	{
+		HapticStats stats;
+		stats.BytesSubmits = BytesSubmits.load(std::memory_order_relaxed);
+		stats.DotSubmits = DotSubmits.load(std::memory_order_relaxed);
+		stats.PathSubmits = PathSubmits.load(std::memory_order_relaxed);
+		stats.RegisteredSubmits = RegisteredSubmits.load(std::memory_order_relaxed);
+		stats.TurnOffs = TurnOffs.load(std::memory_order_relaxed);
+		stats.Registrations = Registrations.load(std::memory_order_relaxed);
+		stats.DroppedFrames = DroppedFrames.load(std::memory_order_relaxed);
+		stats.CoalescedFrames = CoalescedFrames.load(std::memory_order_relaxed);
+		stats.CulledSubmits = CulledSubmits.load(std::memory_order_relaxed);
+		stats.TransformCacheHits = TransformCacheHits.load(std::memory_order_relaxed);
+		stats.TransformCacheMisses = TransformCacheMisses.load(std::memory_order_relaxed);
+		stats.RasterizedPathPoints = RasterizedPathPoints.load(std::memory_order_relaxed);
+		stats.DroppedPathPoints = DroppedPathPoints.load(std::memory_order_relaxed);
+		stats.ScheduledSubmits = ScheduledSubmits.load(std::memory_order_relaxed);
+		stats.CancelledScheduledSubmits = CancelledScheduledSubmits.load(std::memory_order_relaxed);
+		stats.AudioWindows = AudioWindows.load(std::memory_order_relaxed);
+		stats.DroppedAudioWindows = DroppedAudioWindows.load(std::memory_order_relaxed);
+
+		stats.MessagesSent = MessagesSent.load(std::memory_order_relaxed);
+		stats.MessagesReceived = MessagesReceived.load(std::memory_order_relaxed);
+		stats.Traffic.PayloadBytesSent = PayloadBytesSent.load(std::memory_order_relaxed);
+		stats.Traffic.WireBytesSent = WireBytesSent.load(std::memory_order_relaxed);
+		stats.Traffic.PayloadBytesReceived = PayloadBytesReceived.load(std::memory_order_relaxed);
+		stats.Traffic.WireBytesReceived = WireBytesReceived.load(std::memory_order_relaxed);
+		stats.Traffic.CompressedMessagesSent = CompressedMessagesSent.load(std::memory_order_relaxed);
+
+		stats.SerializationNanos = SerializationNanos.load(std::memory_order_relaxed);
+		stats.StatusParseNanos = StatusParseNanos.load(std::memory_order_relaxed);
+		stats.ReconnectAttempts = ReconnectAttempts.load(std::memory_order_relaxed);
+		stats.TxBufferHighWater = TxBufferHighWater.load(std::memory_order_relaxed);
+
+		stats.PollingLockWaitNanos = PollingLockWaitNanos.load(std::memory_order_relaxed);
+		stats.StateLockWaitNanos = StateLockWaitNanos.load(std::memory_order_relaxed);
+		stats.RegisterLockWaitNanos = RegisterLockWaitNanos.load(std::memory_order_relaxed);
+		stats.ResponseLockWaitNanos = ResponseLockWaitNanos.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
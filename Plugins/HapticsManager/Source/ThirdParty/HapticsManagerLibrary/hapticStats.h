@@ -0,0 +1,73 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_HAPTIC_STATS
+#define BHAPTICS_HAPTIC_STATS
+
+#include "model.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+
+namespace bhaptics
+{
+	// Counters behind HapticStats. Written by the library's threads with relaxed atomics,
+	// so any thread can take a snapshot without taking a lock.
+	struct StatsCounters
+	{
+		std::atomic<uint64_t> BytesSubmits{ 0 };
+		std::atomic<uint64_t> DotSubmits{ 0 };
+		std::atomic<uint64_t> PathSubmits{ 0 };
+		std::atomic<uint64_t> RegisteredSubmits{ 0 };
+		std::atomic<uint64_t> TurnOffs{ 0 };
+		std::atomic<uint64_t> Registrations{ 0 };
+		std::atomic<uint64_t> DroppedFrames{ 0 };
+		std::atomic<uint64_t> CoalescedFrames{ 0 };
+		std::atomic<uint64_t> CulledSubmits{ 0 };
+		std::atomic<uint64_t> TransformCacheHits{ 0 };
+		std::atomic<uint64_t> TransformCacheMisses{ 0 };
+		std::atomic<uint64_t> RasterizedPathPoints{ 0 };
+		std::atomic<uint64_t> DroppedPathPoints{ 0 };
+		std::atomic<uint64_t> ScheduledSubmits{ 0 };
+		std::atomic<uint64_t> CancelledScheduledSubmits{ 0 };
+		std::atomic<uint64_t> AudioWindows{ 0 };
+		std::atomic<uint64_t> DroppedAudioWindows{ 0 };
+
+		std::atomic<uint64_t> MessagesSent{ 0 };
+		std::atomic<uint64_t> MessagesReceived{ 0 };
+		std::atomic<uint64_t> PayloadBytesSent{ 0 };
+		std::atomic<uint64_t> WireBytesSent{ 0 };
+		std::atomic<uint64_t> PayloadBytesReceived{ 0 };
+		std::atomic<uint64_t> WireBytesReceived{ 0 };
+		std::atomic<uint64_t> CompressedMessagesSent{ 0 };
+
+		std::atomic<uint64_t> SerializationNanos{ 0 };
+		std::atomic<uint64_t> StatusParseNanos{ 0 };
+		std::atomic<uint64_t> ReconnectAttempts{ 0 };
+		std::atomic<uint64_t> TxBufferHighWater{ 0 };
+
+		std::atomic<uint64_t> PollingLockWaitNanos{ 0 };
+		std::atomic<uint64_t> StateLockWaitNanos{ 0 };
+		std::atomic<uint64_t> RegisterLockWaitNanos{ 0 };
+		std::atomic<uint64_t> ResponseLockWaitNanos{ 0 };
+
+		void add(std::atomic<uint64_t>& counter, uint64_t value = 1)
+		{
+			counter.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		void raise(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			uint64_t current = counter.load(std::memory_order_relaxed);
+			while (value > current && !counter.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		// Locks the mutex, adding the time spent blocked on it to waitNanos. Uncontended locks are not timed.
+		void lock(std::mutex& mutex, std::atomic<uint64_t>& waitNanos);
+
+		HapticStats snapshot() const;
+	};
+}
+
+#endif
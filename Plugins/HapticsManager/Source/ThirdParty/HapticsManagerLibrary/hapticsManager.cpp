@@ -5,12 +5,15 @@
 
 #include "hapticsManager.h"
 #include "util.h"
+#include "traceLog.h"
 
 #ifdef _WIN32
 #pragma comment( lib, "ws2_32" )
 #include <WinSock2.h>
 #endif
+#include <algorithm>
 #include <assert.h>
+#include <string.h>
 
 namespace bhaptics
 {
@@ -18,6 +21,16 @@ namespace bhaptics
 #define MAX(X,Y) ((X) > (Y) ? (X) : (Y))  
 	using easywsclient::WebSocket;
 
+	static uint64_t elapsedMicros(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+	}
+
+	static uint64_t elapsedNanos(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+	}
+
 	void HapticPlayer::reconnect()
 	{
 
@@ -33,12 +46,16 @@ namespace bhaptics
 
 		std::chrono::steady_clock::time_point current = std::chrono::steady_clock::now();
 
-		int values = (int) std::chrono::duration_cast<std::chrono::seconds>(current - prevReconnect).count();
 		bool IsPassedInterval = (current > (prevReconnect + std::chrono::seconds(reconnectSec)));
 		if (IsPassedInterval &&_enable)
 		{
 
-			ws.reset(WebSocket::create(host, port, path));
+			stats.add(stats.ReconnectAttempts);
+			TraceLog::instance()->instant("reconnect", host, reconnectSec);
+			WebSocket* socket = WebSocket::create(host, port, path, compress);
+			stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+			replaceSocket(socket);
+			releasePolling();
 
 			isRegisterSent = false;
 
@@ -46,89 +63,327 @@ namespace bhaptics
 		}
 	}
 
+	void HapticPlayer::replaceSocket(WebSocket* socket)
+	{
+		if (ws)
+		{
+			easywsclient::TrafficStats traffic = ws->getTrafficStats();
+			retiredTraffic.PayloadBytesSent += traffic.payloadBytesSent;
+			retiredTraffic.WireBytesSent += traffic.wireBytesSent;
+			retiredTraffic.PayloadBytesReceived += traffic.payloadBytesReceived;
+			retiredTraffic.WireBytesReceived += traffic.wireBytesReceived;
+			retiredTraffic.CompressedMessagesSent += traffic.compressedMessagesSent;
+		}
+
+		// Frames still buffered on the old socket are never sent.
+		pendingSubmits.clear();
+		ws.reset(socket);
+		latency.reset();
+		connected = ws && ws->getReadyState() != WebSocket::CLOSED;
+		syncTraffic();
+	}
+
+	void HapticPlayer::syncTraffic()
+	{
+		TrafficStats total = retiredTraffic;
+		if (ws)
+		{
+			easywsclient::TrafficStats traffic = ws->getTrafficStats();
+			total.PayloadBytesSent += traffic.payloadBytesSent;
+			total.WireBytesSent += traffic.wireBytesSent;
+			total.PayloadBytesReceived += traffic.payloadBytesReceived;
+			total.WireBytesReceived += traffic.wireBytesReceived;
+			total.CompressedMessagesSent += traffic.compressedMessagesSent;
+			stats.raise(stats.TxBufferHighWater, ws->getBufferedAmount());
+		}
+
+		stats.PayloadBytesSent.store(total.PayloadBytesSent, std::memory_order_relaxed);
+		stats.WireBytesSent.store(total.WireBytesSent, std::memory_order_relaxed);
+		stats.PayloadBytesReceived.store(total.PayloadBytesReceived, std::memory_order_relaxed);
+		stats.WireBytesReceived.store(total.WireBytesReceived, std::memory_order_relaxed);
+		stats.CompressedMessagesSent.store(total.CompressedMessagesSent, std::memory_order_relaxed);
+	}
+
 	void HapticPlayer::resendRegistered()
 	{
-		if (connectionCheck() && _registered.size()>0)
+		if (!isConnected())
 		{
-			PlayerRequest req;
-			registerMtx.lock();
-			std::vector<RegisterRequest> tempRegister = _registered;
-			registerMtx.unlock();
+			return;
+		}
 
-			for (size_t i = 0; i < tempRegister.size(); i++)
-			{
-				req.Register.push_back(tempRegister[i]);
-			}
+		PlayerRequest req;
+		stats.lock(registerMtx, stats.RegisterLockWaitNanos);
+		req.Register = _registered;
+		registerMtx.unlock();
+
+		if (req.Register.size() > 0)
+		{
 			send(req);
+		}
+		isRegisterSent = true;
+	}
 
-			isRegisterSent = true;
+	void HapticPlayer::upsertRegistered(const RegisterRequest &request)
+	{
+		// Re-registering a key (e.g. a hot-reloaded .tact file) replaces the stored project,
+		// so a reconnect only resends the latest version of each key.
+		for (size_t i = 0; i < _registered.size(); i++)
+		{
+			if (_registered[i].Key == request.Key)
+			{
+				_registered[i].ProjectJson = request.ProjectJson;
+				return;
+			}
 		}
+
+		_registered.push_back(request);
 	}
 
 	bool HapticPlayer::connectionCheck()
 	{
-		if (!ws)
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+		if (ws && ws->getReadyState() == WebSocket::CLOSED)
 		{
-			return false;
+			replaceSocket(nullptr);
 		}
-		pollingMtx.lock();
-		WebSocket::readyStateValues isClosed = ws->getReadyState();
-		pollingMtx.unlock();
-		if (isClosed == WebSocket::CLOSED)
+		bool isOpen = ws != nullptr;
+		releasePolling();
+		return isOpen;
+	}
+
+	void HapticPlayer::send(const PlayerRequest& request, std::chrono::steady_clock::time_point submitted)
+	{
+		bool isSubmit = submitted != std::chrono::steady_clock::time_point();
+		if (!isConnected())
 		{
-			ws.reset(nullptr);
-			return false;
+			if (isSubmit)
+			{
+				stats.add(stats.DroppedFrames);
+			}
+			return;
 		}
 
-		return true;
+		std::chrono::steady_clock::time_point serializeStart = std::chrono::steady_clock::now();
+		OutgoingMessage* message = takeMessage();
+		request.appendTo(message->payload);
+		message->serialized = std::chrono::steady_clock::now();
+		stats.add(stats.SerializationNanos, elapsedNanos(serializeStart, message->serialized));
+		if (isSubmit)
+		{
+			serializeLatency.record(elapsedMicros(submitted, message->serialized));
+		}
+		message->isSubmit = isSubmit;
+		message->compress = !request.Register.empty();
+		message->submitted = submitted;
+		if (isSubmit && latency.wantsProbe())
+		{
+			message->probeKey = probeKey(request);
+		}
+
+		TraceLog* trace = TraceLog::instance();
+		if (trace->isEnabled())
+		{
+			message->key = request.Submit.empty() ? std::string() : request.Submit[0].Key;
+			trace->complete("serialize", serializeStart, message->serialized, message->key, (int64_t)message->payload.size());
+		}
+
+		pushOutgoing(message);
+		if (pollingMtx.try_lock())
+		{
+			releasePolling();
+		}
 	}
 
-	void HapticPlayer::send(PlayerRequest request)
+	HapticPlayer::OutgoingMessage* HapticPlayer::takeMessage()
 	{
-		if (!connectionCheck())
 		{
-			return;
+			std::lock_guard<std::mutex> lock(spareMtx);
+			if (!spareMessages.empty())
+			{
+				OutgoingMessage* message = spareMessages.back();
+				spareMessages.pop_back();
+				return message;
+			}
+		}
+		OutgoingMessage* message = new OutgoingMessage();
+		message->payload.reserve(1024);
+		return message;
+	}
+
+	void HapticPlayer::recycleMessage(OutgoingMessage* message)
+	{
+		if (message->payload.capacity() <= MaxSparePayload)
+		{
+			message->payload.clear();
+			message->key.clear();
+			message->probeKey.clear();
+			std::lock_guard<std::mutex> lock(spareMtx);
+			if (spareMessages.size() < MaxSpareMessages)
+			{
+				if (spareMessages.capacity() < MaxSpareMessages)
+				{
+					spareMessages.reserve(MaxSpareMessages);
+				}
+				spareMessages.push_back(message);
+				return;
+			}
+		}
+		delete message;
+	}
+
+	void HapticPlayer::pushOutgoing(OutgoingMessage* message)
+	{
+		message->next = outgoing.load(std::memory_order_relaxed);
+		while (!outgoing.compare_exchange_weak(message->next, message, std::memory_order_release, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void HapticPlayer::drainOutgoing()
+	{
+		OutgoingMessage* taken = outgoing.exchange(nullptr, std::memory_order_acquire);
+		OutgoingMessage* messages = nullptr;
+		while (taken != nullptr)
+		{
+			OutgoingMessage* next = taken->next;
+			taken->next = messages;
+			messages = taken;
+			taken = next;
+		}
+
+		bool isOpen = ws && ws->getReadyState() != WebSocket::CLOSED;
+		while (messages != nullptr)
+		{
+			OutgoingMessage* message = messages;
+			messages = message->next;
+
+			if (!isOpen)
+			{
+				if (message->isSubmit)
+				{
+					stats.add(stats.DroppedFrames);
+				}
+				recycleMessage(message);
+				continue;
+			}
+
+			if (message->compress)
+			{
+				ws->sendCompressed(message->payload);
+			}
+			else
+			{
+				ws->send(message->payload);
+			}
+			recorder.recordSent(message->payload);
+			stats.add(stats.MessagesSent);
+			if (message->isSubmit)
+			{
+				PendingSubmit pending;
+				pending.submitted = message->submitted;
+				pending.enqueued = std::chrono::steady_clock::now();
+				pending.sentOffset = ws->getTrafficStats().wireBytesSent + ws->getBufferedAmount();
+				enqueueLatency.record(elapsedMicros(message->serialized, pending.enqueued));
+				pendingSubmits.push_back(pending);
+				if (!message->probeKey.empty())
+				{
+					// A key the Player already reports active would be timed from an earlier submit.
+					stats.lock(mtx, stats.StateLockWaitNanos);
+					bool isActive = std::find(_activeKeys.begin(), _activeKeys.end(), message->probeKey) != _activeKeys.end();
+					mtx.unlock();
+					if (!isActive)
+					{
+						latency.startProbe(message->probeKey, pending.enqueued);
+					}
+				}
+				TraceLog::instance()->complete("submit", message->submitted, pending.enqueued, message->key, (int64_t)message->payload.size());
+			}
+			recycleMessage(message);
 		}
+	}
 
-		std::string jStr = request.to_string();
+	void HapticPlayer::releasePolling()
+	{
+		// A producer that finds pollingMtx held leaves its message on the queue for the holder, which checks the
+		// queue again after unlocking. A few passes bound the time one caller spends sending for others; anything
+		// left over goes with the next send or timer tick.
+		for (int pass = 1; ; pass++)
+		{
+			drainOutgoing();
+			if (ws)
+			{
+				pollSocket();
+				recordSentSubmits();
+				connected = ws->getReadyState() != WebSocket::CLOSED;
+			}
+			syncTraffic();
+			pollingMtx.unlock();
 
-		pollingMtx.lock();
-		ws->send(jStr);
+			if (pass == 4 || outgoing.load() == nullptr || !pollingMtx.try_lock())
+			{
+				return;
+			}
+		}
+	}
+
+	void HapticPlayer::pollSocket()
+	{
+		if (!TraceLog::instance()->isEnabled())
+		{
+			ws->poll();
+			return;
+		}
+
+		std::chrono::steady_clock::time_point pollStart = std::chrono::steady_clock::now();
+		uint64_t wireBytesSent = ws->getTrafficStats().wireBytesSent;
 		ws->poll();
-		pollingMtx.unlock();
+		uint64_t written = ws->getTrafficStats().wireBytesSent - wireBytesSent;
+		if (written > 0)
+		{
+			TraceLog::instance()->complete("socket write", pollStart, std::chrono::steady_clock::now(), std::string(), (int64_t)written);
+		}
 	}
 
-	void HapticPlayer::updateActive(const std::string &key, const Frame& signal)
+	void HapticPlayer::recordSentSubmits()
 	{
-		if (!_enable || !connectionCheck())
+		if (!ws || pendingSubmits.empty())
 		{
 			return;
 		}
 
-		SubmitRequest req;
-		PlayerRequest playerReq;
-		req.Frame = signal;
-		req.Key = key;
-		req.Type = "frame";
+		uint64_t wireBytesSent = ws->getTrafficStats().wireBytesSent;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		while (!pendingSubmits.empty() && pendingSubmits.front().sentOffset <= wireBytesSent)
+		{
+			sendLatency.record(elapsedMicros(pendingSubmits.front().enqueued, now));
+			totalLatency.record(elapsedMicros(pendingSubmits.front().submitted, now));
+			pendingSubmits.pop_front();
+		}
+	}
+
+	void HapticPlayer::updateActive(const std::string &key, const Frame& signal, std::chrono::steady_clock::time_point submitted)
+	{
+		if (!_enable || !isConnected())
+		{
+			stats.add(stats.DroppedFrames);
+			return;
+		}
 
-		playerReq.Submit.push_back(req);
+		PlayerRequest playerReq;
+		playerReq.Submit.push_back(SubmitRequest::AsFrame(key, signal));
 
-		send(playerReq);
+		send(playerReq, submitted);
 	}
 
 	void HapticPlayer::remove(const std::string &key)
 	{
-		if (!_enable || !connectionCheck())
+		if (!_enable || !isConnected())
 		{
 			return;
 		}
 
-		SubmitRequest req;
 		PlayerRequest playerReq;
-		req.Key = key;
-		req.Type = "turnOff";
-
-		playerReq.Submit.push_back(req);
+		playerReq.Submit.push_back(SubmitRequest::AsTurnOff(key));
 
 		send(playerReq);
 	}
@@ -140,79 +395,340 @@ namespace bhaptics
 			return;
 		}
 
-		SubmitRequest req;
 		PlayerRequest playerReq;
-		req.Type = "turnOffAll";
-
-		playerReq.Submit.push_back(req);
+		playerReq.Submit.push_back(SubmitRequest::AsTurnOffAll());
 
 		send(playerReq);
 	}
 
 	void HapticPlayer::callbackFunc()
 	{
+		static thread_local bool isThreadNamed = false;
+		if (!isThreadNamed && TraceLog::instance()->isEnabled())
+		{
+			TraceLog::instance()->nameThread("HapticTimer");
+			isThreadNamed = true;
+		}
+
 		reconnect();
 		doRepeat();
+		measureLatency();
+		sendLocalFrames();
 		_currentTime += _interval;
 	}
 
-	Position HapticPlayer::stringToPosition(const std::string deviceName)
+	void HapticPlayer::fitToDevice(Frame& frame)
 	{
-		if (deviceName == "Left")
+		int motors = motorCount(frame.Position);
+		frame.DotPoints.erase(std::remove_if(frame.DotPoints.begin(), frame.DotPoints.end(),
+			[motors](const DotPoint& dot) { return dot.index >= motors; }), frame.DotPoints.end());
+	}
+
+	bool HapticPlayer::rasterize(Frame& frame)
+	{
+		return rasterize(frame, frame.PathPoints.data(), frame.PathPoints.size());
+	}
+
+	bool HapticPlayer::rasterize(Frame& frame, const PathPoint* points, size_t count)
+	{
+		if (count == 0 || !rasterizePaths.load(std::memory_order_relaxed))
+		{
+			return false;
+		}
+		const MotorLayout& layout = motorLayout(frame.Position);
+		if (!layout.Mapped)
 		{
-			return Position::Left;
+			return false;
 		}
-		else if (deviceName == "Right")
+
+		uint8_t motors[MaxMotors] = {};
+		for (const DotPoint& dot : frame.DotPoints)
 		{
-			return Position::Right;
+			if (dot.index < layout.MotorCount)
+			{
+				motors[dot.index] = (uint8_t)MAX(motors[dot.index], MIN(100, MAX(0, dot.intensity)));
+			}
 		}
-		if (deviceName == "ForearmL")
+		rasterizePath(layout, points, count, motors);
+		stats.add(stats.RasterizedPathPoints, count);
+
+		frame.PathPoints.clear();
+		frame.DotPoints.clear();
+		for (int i = 0; i < layout.MotorCount; i++)
 		{
-			return Position::ForearmL;
+			if (motors[i] > 0)
+			{
+				frame.DotPoints.push_back(DotPoint(i, motors[i]));
+			}
 		}
-		else if (deviceName == "ForearmR")
+		return true;
+	}
+
+	bool HapticPlayer::playLocally(const std::string &key, const std::string &altKey, ScaleOption option, RotationOption rotOption)
+	{
+		if (!localTransforms.load(std::memory_order_relaxed))
 		{
-			return Position::ForearmR;
+			return false;
 		}
-		else if (deviceName == "Vest")
+
+		bool cacheHit = false;
+		std::shared_ptr<const CompiledFeedback> feedback = transformer.transform(key, option, rotOption, [this, &key]()
 		{
-			return Position::Vest;
+			std::string project;
+			stats.lock(registerMtx, stats.RegisterLockWaitNanos);
+			for (size_t i = 0; i < _registered.size(); i++)
+			{
+				if (_registered[i].Key == key)
+				{
+					project = _registered[i].ProjectJson;
+				}
+			}
+			registerMtx.unlock();
+			return project;
+		}, cacheHit);
+		if (!feedback)
+		{
+			return false;
 		}
-		else if (deviceName == "Head")
+		stats.add(cacheHit ? stats.TransformCacheHits : stats.TransformCacheMisses);
+
+		// Like the Player, a new submit under the same identity restarts it.
+		LocalPlayback playback;
+		playback.Identity = altKey.empty() ? key : altKey;
+		playback.Feedback = feedback;
+		playback.Started = std::chrono::steady_clock::now();
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		std::vector<LocalPlayback>::iterator previous = std::find_if(localPlaybacks.begin(), localPlaybacks.end(),
+			[&playback](const LocalPlayback& playing) { return playing.Identity == playback.Identity; });
+		if (previous != localPlaybacks.end())
 		{
-			return Position::Head;
+			*previous = playback;
 		}
-		else if (deviceName == "Racket")
+		else
+		{
+			localPlaybacks.push_back(playback);
+		}
+		localPlaybackCount.store(localPlaybacks.size(), std::memory_order_relaxed);
+		localMtx.unlock();
+		return true;
+	}
+
+	void HapticPlayer::stopLocal(const std::string &identity)
+	{
+		if (localPlaybackCount.load(std::memory_order_relaxed) == 0)
+		{
+			return;
+		}
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		localPlaybacks.erase(std::remove_if(localPlaybacks.begin(), localPlaybacks.end(),
+			[&identity](const LocalPlayback& playing) { return identity.empty() || playing.Identity == identity; }), localPlaybacks.end());
+		localPlaybackCount.store(localPlaybacks.size(), std::memory_order_relaxed);
+		localMtx.unlock();
+	}
+
+	void HapticPlayer::stopSynth(const std::string &key)
+	{
+		if (synthVoiceCount.load(std::memory_order_relaxed) == 0)
+		{
+			return;
+		}
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		synth.stop(key);
+		synthVoiceCount.store(synth.size(), std::memory_order_relaxed);
+		localMtx.unlock();
+	}
+
+	void HapticPlayer::playSynth(const std::string &key, const SynthEffect &effect)
+	{
+		if (!_enable)
+		{
+			return;
+		}
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		synth.play(key, effect, std::chrono::steady_clock::now());
+		synthVoiceCount.store(synth.size(), std::memory_order_relaxed);
+		updateTimerInterval();
+		localMtx.unlock();
+		timer.wake();
+	}
+
+	void HapticPlayer::setAudioHaptics(const AudioHapticsConfig &config)
+	{
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		audio.configure(config);
+		updateTimerInterval();
+		localMtx.unlock();
+	}
+
+	void HapticPlayer::feedAudio(const float* samples, int frames, int channels, int sampleRate)
+	{
+		if (!audio.isEnabled())
+		{
+			return;
+		}
+		audio.process(samples, frames, channels, sampleRate);
+	}
+
+	void HapticPlayer::updateTimerInterval()
+	{
+		// Local playbacks, procedural effects and audio send a frame per interval, at the Player's frame cadence; otherwise
+		// the timer only needs to poll for status.
+		bool sendsFrames = localTransforms.load(std::memory_order_relaxed) || synth.size() > 0 || audio.isEnabled();
+		timer.setInterval(sendsFrames ? _interval : 100);
+	}
+
+	bool HapticPlayer::updateSynth(const std::string &key, const SynthEffect &effect)
+	{
+		if (synthVoiceCount.load(std::memory_order_relaxed) == 0)
+		{
+			return false;
+		}
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		bool updated = synth.update(key, effect);
+		localMtx.unlock();
+		return updated;
+	}
+
+	void HapticPlayer::releaseSynth(const std::string &key)
+	{
+		if (synthVoiceCount.load(std::memory_order_relaxed) == 0)
+		{
+			return;
+		}
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		synth.release(key, std::chrono::steady_clock::now());
+		localMtx.unlock();
+	}
+
+	void HapticPlayer::sendLocalFrames()
+	{
+		if (localPlaybackCount.load(std::memory_order_relaxed) == 0 && synthVoiceCount.load(std::memory_order_relaxed) == 0
+			&& !audio.isEnabled())
+		{
+			return;
+		}
+
+		struct MixedFrame
+		{
+			int Dots[MaxMotors];
+			std::vector<PathPoint> Paths;
+		};
+		std::map<Position, MixedFrame> mixed;
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		auto mixFrames = [&mixed](const std::vector<SynthFrame>& frames)
+		{
+			for (const SynthFrame& source : frames)
+			{
+				bool isNew = mixed.find(source.Position) == mixed.end();
+				MixedFrame& frame = mixed[source.Position];
+				if (isNew)
+				{
+					memset(frame.Dots, 0, sizeof(frame.Dots));
+				}
+				for (int i = 0; i < MaxMotors; i++)
+				{
+					frame.Dots[i] += source.Dots[i];
+				}
+			}
+		};
+
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		localPlaybacks.erase(std::remove_if(localPlaybacks.begin(), localPlaybacks.end(), [now](const LocalPlayback& playing)
+		{
+			return elapsedMicros(playing.Started, now) / 1000 >= (uint64_t)(playing.Feedback->FrameCount * playing.Feedback->IntervalMillis);
+		}), localPlaybacks.end());
+		localPlaybackCount.store(localPlaybacks.size(), std::memory_order_relaxed);
+		for (const LocalPlayback& playback : localPlaybacks)
 		{
-			return Position::Racket;
+			int frameIndex = (int)(elapsedMicros(playback.Started, now) / 1000 / playback.Feedback->IntervalMillis);
+			for (const CompiledTrack& track : playback.Feedback->Tracks)
+			{
+				bool isNew = mixed.find(track.Position) == mixed.end();
+				MixedFrame& frame = mixed[track.Position];
+				if (isNew)
+				{
+					memset(frame.Dots, 0, sizeof(frame.Dots));
+				}
+				const uint8_t* dots = track.dotsAt(frameIndex);
+				for (int i = 0; i < track.MotorCount; i++)
+				{
+					frame.Dots[i] += dots[i];
+				}
+				frame.Paths.insert(frame.Paths.end(), track.Paths[frameIndex].begin(), track.Paths[frameIndex].end());
+			}
 		}
-		else if (deviceName == "HandL")
+
+		if (synth.size() > 0)
 		{
-			return Position::HandL;
+			synth.render(now, synthFrames);
+			synthVoiceCount.store(synth.size(), std::memory_order_relaxed);
+			if (synth.size() == 0)
+			{
+				updateTimerInterval();
+			}
+			mixFrames(synthFrames);
 		}
-		else if (deviceName == "HandR")
+		localMtx.unlock();
+
+		if (audio.isEnabled())
 		{
-			return Position::HandR;
+			uint64_t played = 0;
+			uint64_t dropped = 0;
+			audio.render(now, audioFrames, played, dropped);
+			stats.add(stats.AudioWindows, played);
+			stats.add(stats.DroppedAudioWindows, dropped);
+			mixFrames(audioFrames);
 		}
-		else if (deviceName == "FootL")
+
+		if (mixed.empty() || !_enable || !isConnected())
 		{
-			return Position::FootL;
+			return;
 		}
-		else if (deviceName == "FootR")
+
+		// Each frame outlives the timer interval, so the Player never gaps between two of them.
+		PlayerRequest playerReq;
+		for (std::map<Position, MixedFrame>::const_iterator it = mixed.begin(); it != mixed.end(); ++it)
 		{
-			return Position::FootR;
+			Frame frame;
+			frame.Position = it->first;
+			frame.DurationMillis = _interval * 2;
+			for (int i = 0; i < motorCount(it->first); i++)
+			{
+				if (it->second.Dots[i] > 0)
+				{
+					frame.DotPoints.push_back(DotPoint(i, MIN(100, it->second.Dots[i])));
+				}
+			}
+
+			const std::vector<PathPoint>& paths = it->second.Paths;
+			if (!rasterize(frame, paths.data(), paths.size()))
+			{
+				size_t dropped = frame.PathPoints.assign(paths.begin(), paths.end());
+				stats.add(stats.DroppedPathPoints, dropped);
+			}
+			playerReq.Submit.push_back(SubmitRequest::AsFrame("_local" + std::to_string((int)it->first), frame));
 		}
 
-		return Position::All;
+		send(playerReq);
+	}
+
+	Position HapticPlayer::stringToPosition(const std::string deviceName)
+	{
+		return positionFromName(deviceName);
 	}
 
 	void HapticPlayer::doRepeat()
 	{
-		if (isRunning)
+		if (isRunning.exchange(true))
 		{
 			return;
 		}
-		isRunning = true;
 
 		if (!isRegisterSent)
 		{
@@ -235,9 +751,10 @@ namespace bhaptics
 		RegisterRequest req;
 		req.Key = key;
 		req.ProjectJson = file.ProjectJson;
+		stats.add(stats.Registrations);
 
-		registerMtx.lock();
-		_registered.push_back(req);
+		stats.lock(registerMtx, stats.RegisterLockWaitNanos);
+		upsertRegistered(req);
 
 		PlayerRequest playerReq;
 
@@ -245,6 +762,7 @@ namespace bhaptics
 
 		send(playerReq);
 		registerMtx.unlock();
+		transformer.invalidate(key);
 		return 1;
 	}
 
@@ -253,9 +771,10 @@ namespace bhaptics
 		RegisterRequest req;
 		req.Key = key;
 		req.ProjectJson = jsonString;
+		stats.add(stats.Registrations);
 
-		registerMtx.lock();
-		_registered.push_back(req);
+		stats.lock(registerMtx, stats.RegisterLockWaitNanos);
+		upsertRegistered(req);
 
 		PlayerRequest playerReq;
 
@@ -263,16 +782,25 @@ namespace bhaptics
 
 		send(playerReq);
 		registerMtx.unlock();
+		transformer.invalidate(key);
 		return 0;
 	}
 
 	void HapticPlayer::init()
 	{
-
-		if (_enable || ws)
+		std::lock_guard<std::recursive_mutex> lock(connectionMtx);
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+		bool hasSocket = ws != nullptr;
+		pollingMtx.unlock();
+		if (_enable || hasSocket)
 			return;
+
+		// The timer may still be running after the socket closed; it must not run while its handler is replaced.
+		timer.stop();
 		std::function<void()> callback = std::bind(&HapticPlayer::callbackFunc, this);
 		timer.addTimerHandler(callback);
+		std::function<int()> poll = std::bind(&HapticPlayer::pollTimer, this);
+		timer.addPollHandler(poll);
 #ifdef _WIN32
 		INT rc;
 		WSADATA wsaData;
@@ -283,7 +811,11 @@ namespace bhaptics
 			return;
 		}
 #endif
-		ws = std::unique_ptr<WebSocket>(WebSocket::create(host, port, path));
+		WebSocket* socket = WebSocket::create(host, port, path, compress);
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+		drainOutgoing(); // drops anything queued after the last destroy
+		replaceSocket(socket);
+		releasePolling();
 
 		connectionCheck();
 		timer.start();
@@ -293,143 +825,439 @@ namespace bhaptics
 
 	void HapticPlayer::submit(const std::string &key, Position position, const std::vector<uint8_t> &motorBytes, int durationMillis)
 	{
-		if (!_enable || !connectionCheck())
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		stats.add(stats.BytesSubmits);
+		if (isCulled(position))
+		{
+			stats.add(stats.CulledSubmits);
+			return;
+		}
+		if (!_enable || !isConnected())
 		{
+			stats.add(stats.DroppedFrames);
 			return;
 		}
 
-		std::vector<DotPoint> points;
-		for (size_t i = 0; i < motorBytes.size(); i++)
+		// Bytes past the device's motors would not play; they are not sent.
+		Frame submitFrame;
+		submitFrame.Position = position;
+		submitFrame.DurationMillis = durationMillis;
+		size_t motors = MIN(motorBytes.size(), (size_t)motorCount(position));
+		for (size_t i = 0; i < motors; i++)
 		{
 			if (motorBytes[i] > 0)
 			{
-				points.push_back(DotPoint((int)i, motorBytes[i]));
+				submitFrame.DotPoints.push_back(DotPoint((int)i, motorBytes[i]));
 			}
 		}
 
-		Frame submitFrame = Frame::AsDotPointFrame(points, position, durationMillis);
-		updateActive(key, submitFrame);
+		updateActive(key, submitFrame, submitted);
 	}
 
 	void HapticPlayer::submit(const std::string &key, Position position, const std::vector<DotPoint> &points, int durationMillis)
 	{
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		stats.add(stats.DotSubmits);
+		if (isCulled(position))
+		{
+			stats.add(stats.CulledSubmits);
+			return;
+		}
 		Frame req = Frame::AsDotPointFrame(points, position, durationMillis);
-		updateActive(key, req);
+		fitToDevice(req);
+		updateActive(key, req, submitted);
 	}
 
 	void HapticPlayer::submit(const std::string &key, Position position, const std::vector<PathPoint> &points, int durationMillis)
 	{
-		Frame req = Frame::AsPathPointFrame(points, position, durationMillis);
-		updateActive(key, req);
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		stats.add(stats.PathSubmits);
+		if (isCulled(position))
+		{
+			stats.add(stats.CulledSubmits);
+			return;
+		}
+		// Rasterizing reads every point; otherwise the frame keeps the first MaxPathPoints.
+		Frame req;
+		req.Position = position;
+		req.DurationMillis = durationMillis;
+		if (!rasterize(req, points.data(), points.size()))
+		{
+			size_t dropped = req.PathPoints.assign(points.begin(), points.end());
+			stats.add(stats.DroppedPathPoints, dropped);
+		}
+		updateActive(key, req, submitted);
 	}
 
 	void HapticPlayer::submitRegistered(const std::string &key, const std::string &altKey, ScaleOption option, RotationOption rotOption)
 	{
-		if (!_enable || !connectionCheck())
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		stats.add(stats.RegisteredSubmits);
+		if (!_enable || !isConnected())
 		{
+			stats.add(stats.DroppedFrames);
 			return;
 		}
 
-		SubmitRequest req;
-		PlayerRequest playerReq;
-		req.Key = key;
-		req.Type = "key";
-		req.Parameters["scaleOption"] = option.to_string();
-		req.Parameters["rotationOption"] = rotOption.to_string();
-		if (!altKey.empty())
+		if (playLocally(key, altKey, option, rotOption))
 		{
-			req.Parameters["altKey"] = "\""+altKey+"\"";
+			return;
 		}
-		playerReq.Submit.push_back(req);
 
-		send(playerReq);
+		PlayerRequest playerReq;
+		playerReq.Submit.push_back(SubmitRequest::AsRegistered(key, altKey, option, rotOption));
+
+		send(playerReq, submitted);
 	}
 
 	void HapticPlayer::submitRegistered(const std::string &key)
 	{
-		if (!_enable || !connectionCheck())
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		stats.add(stats.RegisteredSubmits);
+		if (!_enable || !isConnected())
 		{
+			stats.add(stats.DroppedFrames);
 			return;
 		}
 
-		SubmitRequest req;
 		PlayerRequest playerReq;
-		req.Key = key;
-		req.Type = "key";
+		playerReq.Submit.push_back(SubmitRequest::AsRegistered(key));
 
-		playerReq.Submit.push_back(req);
+		send(playerReq, submitted);
+	}
 
-		send(playerReq);
+	void HapticPlayer::submitBatch(const std::vector<SubmitRequest>& requests)
+	{
+		std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::now();
+		uint64_t submitCount = 0;
+		for (const SubmitRequest& req : requests)
+		{
+			if (req.Type == SubmitType::Frame)
+			{
+				stats.add(req.Frame.PathPoints.empty() && req.AllPathPoints.empty() ? stats.DotSubmits : stats.PathSubmits);
+				if (isCulled(req.Frame.Position))
+				{
+					stats.add(stats.CulledSubmits);
+					continue;
+				}
+				submitCount++;
+			}
+			else if (req.Type == SubmitType::Key)
+			{
+				stats.add(stats.RegisteredSubmits);
+				submitCount++;
+			}
+			else
+			{
+				stats.add(stats.TurnOffs);
+				// Procedural voices are rendered here rather than by the Player, so like turnOff they stop whether or not
+				// it is connected. A turnOff without a key stops nothing locally.
+				if (req.Type == SubmitType::TurnOffAll || !req.Key.empty())
+				{
+					stopSynth(req.Type == SubmitType::TurnOffAll ? std::string() : req.Key);
+				}
+			}
+		}
+
+		if (!_enable || !isConnected())
+		{
+			stats.add(stats.DroppedFrames, submitCount);
+			return;
+		}
+
+		// Only the last request per key reaches the Player; a turnOffAll supersedes everything before it.
+		PlayerRequest playerReq;
+		playerReq.Submit.reserve(requests.size());
+		for (const SubmitRequest& req : requests)
+		{
+			if (req.Type == SubmitType::Frame && isCulled(req.Frame.Position))
+			{
+				continue;
+			}
+
+			// Local playbacks start and stop in batch order, so a later turnOff still stops them.
+			const SubmitParameters& parameters = req.Parameters;
+			if (req.Type == SubmitType::Key && parameters.HasOptions
+				&& playLocally(req.Key, parameters.AltKey, parameters.Scale, parameters.Rotation))
+			{
+				continue;
+			}
+			if (req.Type == SubmitType::TurnOff || req.Type == SubmitType::TurnOffAll)
+			{
+				stopLocal(req.Key);
+			}
+
+			if (req.Type == SubmitType::TurnOffAll)
+			{
+				stats.add(stats.CoalescedFrames, playerReq.Submit.size());
+				playerReq.Submit.clear();
+			}
+			else
+			{
+				// The Player plays one feedback per key, or per altKey when a registered feedback is submitted under one.
+				const std::string& identity = req.identity();
+				std::vector<SubmitRequest>::iterator previous = std::find_if(playerReq.Submit.begin(), playerReq.Submit.end(),
+					[&identity](const SubmitRequest& queued) { return queued.Type != SubmitType::TurnOffAll && queued.identity() == identity; });
+				if (previous != playerReq.Submit.end())
+				{
+					playerReq.Submit.erase(previous);
+					stats.add(stats.CoalescedFrames);
+				}
+			}
+			playerReq.Submit.push_back(req);
+			SubmitRequest& queued = playerReq.Submit.back();
+			std::vector<PathPoint>& allPaths = queued.AllPathPoints;
+			bool rasterized = allPaths.empty() ? rasterize(queued.Frame) : rasterize(queued.Frame, allPaths.data(), allPaths.size());
+			if (!rasterized)
+			{
+				if (!allPaths.empty())
+				{
+					size_t dropped = queued.Frame.PathPoints.assign(allPaths.begin(), allPaths.end());
+					stats.add(stats.DroppedPathPoints, dropped);
+				}
+				fitToDevice(queued.Frame);
+			}
+			allPaths.clear();
+		}
+
+		if (playerReq.Submit.empty())
+		{
+			return;
+		}
+
+		send(playerReq, submitted);
+	}
+
+	void HapticPlayer::schedule(int delayMillis, const SubmitRequest& request)
+	{
+		scheduleBatch(std::vector<ScheduledSubmit>(1, ScheduledSubmit::After(delayMillis, request)));
+	}
+
+	void HapticPlayer::scheduleBatch(const std::vector<ScheduledSubmit>& requests)
+	{
+		if (requests.empty())
+		{
+			return;
+		}
+		uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - scheduleEpoch).count();
+		int leadMillis = (int)((latency.leadMicros() + 500) / 1000);
+		stats.add(stats.ScheduledSubmits, requests.size());
+
+		std::vector<SubmitRequest> dueNow;
+		size_t added = 0;
+		{
+			std::lock_guard<std::mutex> lock(scheduleMtx);
+			for (const ScheduledSubmit& request : requests)
+			{
+				int delayMillis = request.CompensateLatency ? request.DelayMillis - leadMillis : request.DelayMillis;
+				if (delayMillis <= 0)
+				{
+					dueNow.push_back(request.Request);
+					continue;
+				}
+				scheduled.schedule(now + (uint64_t)delayMillis, request.Request);
+				added++;
+			}
+			scheduledCount = scheduled.size();
+		}
+
+		if (!dueNow.empty())
+		{
+			// Waiting for the timer thread would only add to a delay the lead could not cover.
+			submitBatch(dueNow);
+		}
+		if (added > 0)
+		{
+			// The timer thread may be sleeping past the earliest new due time.
+			timer.wake();
+		}
+	}
+
+	size_t HapticPlayer::cancelScheduled(const std::string& key)
+	{
+		size_t cancelled;
+		{
+			std::lock_guard<std::mutex> lock(scheduleMtx);
+			cancelled = scheduled.cancel(key);
+			scheduledCount = scheduled.size();
+		}
+		stats.add(stats.CancelledScheduledSubmits, cancelled);
+		return cancelled;
+	}
+
+	int HapticPlayer::pollScheduled()
+	{
+		// Longer than the timer ever sleeps, so an empty wheel does not shorten its sleep.
+		const int idleMillis = 1000;
+		if (scheduledCount.load(std::memory_order_relaxed) == 0)
+		{
+			return idleMillis;
+		}
+
+		uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - scheduleEpoch).count();
+		uint64_t wait;
+		{
+			std::lock_guard<std::mutex> lock(scheduleMtx);
+			scheduled.advance(now, dueRequests);
+			scheduledCount = scheduled.size();
+			wait = scheduled.ticksUntilDue(idleMillis);
+		}
+
+		if (!dueRequests.empty())
+		{
+			submitBatch(dueRequests);
+			dueRequests.clear();
+		}
+		return (int)wait;
+	}
+
+	void HapticPlayer::measureLatency()
+	{
+		if (!isConnected())
+		{
+			return;
+		}
+
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+		if (ws && latency.startPing(std::chrono::steady_clock::now(), pingPayload))
+		{
+			ws->sendPing(pingPayload);
+		}
+		releasePolling();
+	}
+
+	int HapticPlayer::pollTimer()
+	{
+		int wait = pollScheduled();
+		if (!latency.isMeasuring())
+		{
+			return wait;
+		}
+		checkMessage();
+		return 1;
+	}
+
+	std::string HapticPlayer::probeKey(const PlayerRequest& request)
+	{
+		// Turning off plays nothing, so the Player never reports it active.
+		for (const SubmitRequest& submit : request.Submit)
+		{
+			if (submit.Type == SubmitType::Frame || submit.Type == SubmitType::Key)
+			{
+				return submit.identity();
+			}
+		}
+		return std::string();
 	}
 
 	bool HapticPlayer::isPlaying()
 	{
-		return _activeKeys.size() > 0;
+		return activeKeyCount.load(std::memory_order_relaxed) > 0 || localPlaybackCount.load(std::memory_order_relaxed) > 0
+			|| synthVoiceCount.load(std::memory_order_relaxed) > 0;
 	}
 
 	bool HapticPlayer::isPlaying(const std::string &key)
 	{
-		mtx.lock();
-		std::vector<std::string> temp = _activeKeys;
+		stats.lock(mtx, stats.StateLockWaitNanos);
+		bool ret = std::find(_activeKeys.begin(), _activeKeys.end(), key) != _activeKeys.end();
 		mtx.unlock();
+		if (ret || (localPlaybackCount.load(std::memory_order_relaxed) == 0 && synthVoiceCount.load(std::memory_order_relaxed) == 0))
+		{
+			return ret;
+		}
 
-		bool ret = std::find(temp.begin(), temp.end(), key) != temp.end();
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		ret = std::find_if(localPlaybacks.begin(), localPlaybacks.end(),
+			[&key](const LocalPlayback& playing) { return playing.Identity == key; }) != localPlaybacks.end()
+			|| synth.isPlaying(key);
+		localMtx.unlock();
 		return ret;
 	}
 
 	void HapticPlayer::turnOff()
 	{
+		stats.add(stats.TurnOffs);
+		stopLocal("");
+		stopSynth("");
 		removeAll();
 	}
 
 	void HapticPlayer::turnOff(const std::string &key)
 	{
+		stats.add(stats.TurnOffs);
+		if (!key.empty())
+		{
+			stopLocal(key);
+			stopSynth(key);
+		}
 		remove(key);
 	}
 
 	void HapticPlayer::parseReceivedMessage(const char * message)
 	{
-
+		recorder.recordReceived(message, strlen(message));
+		std::chrono::steady_clock::time_point parseStart = std::chrono::steady_clock::now();
 		nlohmann::json JsonObject = nlohmann::json::parse(message);
 		PlayerResponse Response;
 
 		PlayerResponse::from_json(JsonObject, Response);
-		CurrentResponse = Response;
+		stats.add(stats.StatusParseNanos, elapsedNanos(parseStart, std::chrono::steady_clock::now()));
+		stats.add(stats.MessagesReceived);
+		latency.onStatus(Response.ActiveKeys, parseStart);
 		parseResponse(Response);
+		TraceLog::instance()->complete("status", parseStart, std::chrono::steady_clock::now(), std::string(), (int64_t)strlen(message));
 
 	}
 
 	void HapticPlayer::checkMessage()
 	{
-		if (!ws)
-		{
-			return;
-		}
-
 		if (pollingMtx.try_lock())
 		{
-			ws->dispatchChar([this](const char* s) { this->parseReceivedMessage(s); });
-			ws->poll();
-			pollingMtx.unlock();
+			if (ws)
+			{
+				// Read first, so statuses and pongs are timed when they arrive rather than one poll later.
+				pollSocket();
+				ws->dispatchChar([this](const char* s) { this->parseReceivedMessage(s); });
+				if (ws->takePong(pongPayload))
+				{
+					latency.onPong(pongPayload, std::chrono::steady_clock::now());
+				}
+			}
+			releasePolling();
 		}
 	}
 
 	void HapticPlayer::destroy()
 	{
+		std::lock_guard<std::recursive_mutex> lock(connectionMtx);
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
 		if (!ws)
 		{
+			pollingMtx.unlock();
 			return;
 		}
 		_enable = false; //ensures no more sends when destroying
+		pollingMtx.unlock();
+
 		timer.stop();
-		pollingMtx.lock();
+		cancelScheduled("");
+		stats.lock(pollingMtx, stats.PollingLockWaitNanos);
+		drainOutgoing();
 		ws->close();
 		ws->poll();
-		ws.reset();
+		replaceSocket(nullptr);
+		drainOutgoing();
 		pollingMtx.unlock();
+		TraceLog::instance()->dumpOnShutdown();
+		recorder.stop();
 
-		_activeDevices.erase(_activeDevices.begin(), _activeDevices.end());
-		_activeKeys.erase(_activeKeys.begin(), _activeKeys.end());
+		stats.lock(mtx, stats.StateLockWaitNanos);
+		_activeDevices.clear();
+		_activeKeys.clear();
+		activeKeyCount = 0;
+		mtx.unlock();
 	}
 
 	void HapticPlayer::enableFeedback()
@@ -444,51 +1272,75 @@ namespace bhaptics
 
 	void HapticPlayer::toggleFeedback()
 	{
-		if (!ws)
+		if (!isConnected())
 		{
 			return;
 		}
 
-		_enable = !_enable;
+		// Atomic flip, so concurrent toggles never cancel out into a lost update.
+		bool enabled = _enable.load();
+		while (!_enable.compare_exchange_weak(enabled, !enabled))
+		{
+		}
 	}
 
-	void HapticPlayer::parseResponse(PlayerResponse response)
+	void HapticPlayer::parseResponse(const PlayerResponse& response)
 	{
-		mtx.lock();
+		stats.lock(mtx, stats.StateLockWaitNanos);
 		_activeKeys = response.ActiveKeys;
 		_activeDevices = response.ConnectedPositions;
+		activeKeyCount = _activeKeys.size();
 		mtx.unlock();
 
-		responseMtx.lock();
-		_activeFeedback = response.Status;
+		uint32_t mask = 0;
+		for (size_t i = 0; i < response.ConnectedPositions.size(); i++)
+		{
+			mask |= positionMask(response.ConnectedPositions[i]);
+		}
+		connectedMask.store(mask, std::memory_order_relaxed);
+		statusReceived.store(true, std::memory_order_release);
+
+		stats.lock(responseMtx, stats.ResponseLockWaitNanos);
+		if (_activeFeedback != response.Status)
+		{
+			_activeFeedback = response.Status;
+			statusVersion.fetch_add(1, std::memory_order_release);
+		}
+		_registeredKeys = response.RegisteredKeys;
 		responseMtx.unlock();
 	}
 
 	bool HapticPlayer::isDevicePlaying(Position device)
 	{
-		mtx.lock();
-		std::vector<bhaptics::Position> temp = _activeDevices;
+		stats.lock(mtx, stats.StateLockWaitNanos);
+		// The Player reports devices by any of their positions, e.g. Vest or ForearmL, so match on the device.
+		Position target = positionDevice(device);
+		bool ret = std::find_if(_activeDevices.begin(), _activeDevices.end(),
+			[target](Position active) { return positionDevice(active) == target; }) != _activeDevices.end();
 		mtx.unlock();
-		bool ret = std::find(temp.begin(), temp.end(), device) != temp.end();
 		return ret;
 	}
 
 	bool HapticPlayer::isFeedbackRegistered(std::string key)
 	{
-		std::vector<std::string> tempReg = CurrentResponse.RegisteredKeys;
-		bool ret = std::find(tempReg.begin(), tempReg.end(), key) != tempReg.end();
+		stats.lock(responseMtx, stats.ResponseLockWaitNanos);
+		bool ret = std::find(_registeredKeys.begin(), _registeredKeys.end(), key) != _registeredKeys.end();
+		responseMtx.unlock();
 		return ret;
 	}
 
 	bool HapticPlayer::anyFilesLoaded()
 	{
-		return  _registered.size() > 0;
+		stats.lock(registerMtx, stats.RegisterLockWaitNanos);
+		bool ret = _registered.size() > 0;
+		registerMtx.unlock();
+		return ret;
 	}
 
 	std::vector<std::string> HapticPlayer::fileNames()
 	{
 		std::vector<std::string> keys;
-		registerMtx.lock();
+		stats.lock(registerMtx, stats.RegisterLockWaitNanos);
 		std::vector<RegisterRequest> tempRegister = _registered;
 		registerMtx.unlock();
 
@@ -501,17 +1353,16 @@ namespace bhaptics
 
 	void HapticPlayer::registerConnection(std::string Id)
 	{
+		std::lock_guard<std::recursive_mutex> lock(connectionMtx);
 		componentIds.push_back(Id);
 		connectionCount = (int)componentIds.size();
-		if (!ws)
-		{
-			init();
-		}
+		init();
 	}
 
 	void HapticPlayer::unregisterConnection(std::string Id)
 	{
-		std::_Vector_iterator<std::_Vector_val<std::_Simple_types<std::string>>> component = std::find(componentIds.begin(), componentIds.end(), Id);
+		std::lock_guard<std::recursive_mutex> lock(connectionMtx);
+		std::vector<std::string>::iterator component = std::find(componentIds.begin(), componentIds.end(), Id);
 		if (component != componentIds.end())
 		{
 			componentIds.erase(component);
@@ -528,13 +1379,93 @@ namespace bhaptics
 		}
 	}
 
-	std::map<std::string, std::vector<int>> HapticPlayer::getResponseStatus()
+	void HapticPlayer::setCullDisconnected(bool enable)
 	{
-		responseMtx.lock();
-		std::map<std::string, std::vector<int>> ret = _activeFeedback;
+		cullDisconnected.store(enable, std::memory_order_relaxed);
+	}
+
+	void HapticPlayer::setRasterizePaths(bool enable)
+	{
+		rasterizePaths.store(enable, std::memory_order_relaxed);
+	}
+
+	void HapticPlayer::setLocalTransforms(bool enable)
+	{
+		stats.lock(localMtx, stats.StateLockWaitNanos);
+		localTransforms.store(enable, std::memory_order_relaxed);
+		updateTimerInterval();
+		localMtx.unlock();
+		if (!enable)
+		{
+			stopLocal("");
+		}
+	}
+
+	void HapticPlayer::setCompression(bool enable)
+	{
+		std::lock_guard<std::recursive_mutex> lock(connectionMtx);
+		compress = enable;
+	}
+
+	TrafficStats HapticPlayer::getTrafficStats()
+	{
+		return stats.snapshot().Traffic;
+	}
+
+	HapticStats HapticPlayer::getStats()
+	{
+		return stats.snapshot();
+	}
+
+	DeviceStatus HapticPlayer::getResponseStatus()
+	{
+		stats.lock(responseMtx, stats.ResponseLockWaitNanos);
+		DeviceStatus ret = _activeFeedback;
 		responseMtx.unlock();
 		return ret;
 	}
+
+	bool HapticPlayer::getResponseStatusSince(uint64_t &version, DeviceStatus &status)
+	{
+		if (getStatusVersion() == version)
+		{
+			return false;
+		}
+
+		stats.lock(responseMtx, stats.ResponseLockWaitNanos);
+		status = _activeFeedback;
+		version = statusVersion.load(std::memory_order_relaxed);
+		responseMtx.unlock();
+		return true;
+	}
+
+	SubmitLatencyStats HapticPlayer::getSubmitLatency()
+	{
+		SubmitLatencyStats stats;
+		stats.Serialize = serializeLatency.percentiles();
+		stats.Enqueue = enqueueLatency.percentiles();
+		stats.Send = sendLatency.percentiles();
+		stats.Total = totalLatency.percentiles();
+		return stats;
+	}
+
+	void HapticPlayer::resetSubmitLatency()
+	{
+		serializeLatency.reset();
+		enqueueLatency.reset();
+		sendLatency.reset();
+		totalLatency.reset();
+	}
+
+	bool HapticPlayer::startRecording(const std::string& path, bool includeStatus)
+	{
+		return recorder.start(path, includeStatus);
+	}
+
+	void HapticPlayer::stopRecording()
+	{
+		recorder.stop();
+	}
 }
 
 bhaptics::HapticPlayer *bhaptics::HapticPlayer::hapticManager = 0;
@@ -6,12 +6,25 @@
 #include "json.hpp"
 #include "timer.h"
 #include "model.h"
+#include "latencyHistogram.h"
+#include "hapticStats.h"
+#include "requestRecorder.h"
+#include "feedbackTransform.h"
+#include "pathRasterizer.h"
+#include "motorLayout.h"
+#include "positionSchema.h"
+#include "timingWheel.h"
+#include "latencyEstimator.h"
+#include "waveformSynth.h"
+#include "audioHaptics.h"
 //#include "common/util.hpp"
 
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <map>
+#include <deque>
 
 namespace bhaptics
 {
@@ -24,7 +37,7 @@ namespace bhaptics
 		std::vector<std::string> ActiveKeys;
 		int ConnectedDeviceCount;
 		std::vector<Position> ConnectedPositions;
-		std::map<std::string, std::vector<int>> Status;
+		DeviceStatus Status;
 
 		static void from_json(const nlohmann::json& j, PlayerResponse& p)
 		{
@@ -36,92 +49,105 @@ namespace bhaptics
 
 			for (size_t i = 0; i < positionStr.size(); i++)
 			{
-				std::string DeviceValue = positionStr[i];
-
-				if (DeviceValue == "Left")
-				{
-					p.ConnectedPositions.push_back(Position::Left);
-				}
-				else if (DeviceValue == "Right")
-				{
-					p.ConnectedPositions.push_back(Position::Right);
-				}
-				if (DeviceValue == "ForearmL")
-				{
-					p.ConnectedPositions.push_back(Position::Left);
-				}
-				else if (DeviceValue == "ForearmR")
-				{
-					p.ConnectedPositions.push_back(Position::Right);
-				}
-				else if (DeviceValue == "Vest")
+				Position position;
+				if (positionFromName(positionStr[i], position))
 				{
-					p.ConnectedPositions.push_back(Position::Vest);
-				}
-				else if (DeviceValue == "Head")
-				{
-					p.ConnectedPositions.push_back(Position::Head);
-				}
-				else if (DeviceValue == "Racket")
-				{
-					p.ConnectedPositions.push_back(Position::Racket);
-				}
-				else if (DeviceValue == "HandL")
-				{
-					p.ConnectedPositions.push_back(Position::HandL);
-				}
-				else if (DeviceValue == "HandR")
-				{
-					p.ConnectedPositions.push_back(Position::HandR);
-				}
-				else if (DeviceValue == "FootL")
-				{
-					p.ConnectedPositions.push_back(Position::FootL);
-				}
-				else if (DeviceValue == "FootR")
-				{
-					p.ConnectedPositions.push_back(Position::FootR);
+					p.ConnectedPositions.push_back(position);
 				}
 			}
 
 			const nlohmann::json& rh = j["Status"];
 
+			// The Player reports MaxMotors values for every device; keep the ones its motors use.
 			for (auto& element : nlohmann::json::iterator_wrapper(rh)) {
-				std::string key = element.key();
-				std::vector<int> motors = element.value().get<std::vector<int>>();
-				p.Status[key] = motors;
+				Position position;
+				if (!positionFromName(element.key(), position))
+				{
+					continue;
+				}
+				uint8_t* values = p.Status.report(position);
+				const nlohmann::json& motors = element.value();
+				size_t count = MIN(motors.size(), (size_t)motorCount(position));
+				for (size_t i = 0; i < count; i++)
+				{
+					values[i] = (uint8_t)MAX(0, MIN(255, motors[i].get<int>()));
+				}
 			}
 		}
 	};
 
+	// Concurrency contract:
+	// - init, destroy, registerConnection, unregisterConnection and setCompression are serialised by connectionMtx
+	//   and may be called from any thread, but are meant for the game thread.
+	// - Every other public function may be called from any number of threads at once.
+	//   Submits and turnOffs serialize on the calling thread and push the message onto a lock-free queue. The thread that
+	//   holds pollingMtx, another producer or the timer thread, sends everything queued before releasing it, so a producer
+	//   never waits for the socket while another thread is writing to it.
+	// - Status queries copy state under their own short locks (mtx, responseMtx, registerMtx) or read atomics.
 	class HapticPlayer
 	{
 	private:
 		static HapticPlayer *hapticManager;
 
-		std::unique_ptr<easywsclient::WebSocket> ws;
+		std::unique_ptr<easywsclient::WebSocket> ws; // guarded by pollingMtx
 		std::vector<RegisterRequest> _registered;
 
 		std::vector<std::string> _activeKeys;
 		std::vector<Position> _activeDevices;
+		std::atomic<size_t> activeKeyCount{ 0 };
+
+		std::vector<std::string> componentIds; // guarded by connectionMtx
 
-		std::vector<std::string> componentIds;
+		DeviceStatus _activeFeedback;
+		std::vector<std::string> _registeredKeys; // keys the Player reports as registered, guarded by responseMtx
+		std::atomic<uint64_t> statusVersion{ 0 }; // bumped whenever _activeFeedback changes
 
-		std::map<std::string, std::vector<int>> _activeFeedback;
+		// positionMask bits of the devices in the Player's last status; every bit until the first status arrives, so
+		// nothing is culled before the Player has reported its devices.
+		std::atomic<uint32_t> connectedMask{ AllPositionsMask };
+		std::atomic<bool> statusReceived{ false };
+		std::atomic<bool> cullDisconnected{ false };
+		std::atomic<bool> rasterizePaths{ false };
 
 		std::mutex mtx;// mutex for _activeKeys and _activeDevices variable
 		std::mutex registerMtx; //mutex for _registered variable
-		std::mutex pollingMtx; //mutex for _registered variable
-		std::mutex responseMtx;
+		std::mutex pollingMtx; // mutex for ws, the socket state and pendingSubmits
+		std::mutex responseMtx; // mutex for _activeFeedback and _registeredKeys
+		std::recursive_mutex connectionMtx; // mutex for componentIds and the init/destroy lifecycle
 
 		int _currentTime = 0;
 		int _interval = 20;
-		int _motorSize = 20;
 		HapticTimer timer;
 
-		bool isRunning = false;
+		std::atomic<bool> isRunning{ false };
 
-		bool _enable = false;
+		std::atomic<bool> _enable{ false };
+
+		// Whether ws is open, as of the last time a thread holding pollingMtx looked. Lets producers drop frames
+		// without taking the lock while the Player is not connected.
+		std::atomic<bool> connected{ false };
+
+		// Serialized requests waiting for the holder of pollingMtx to send them: a lock-free LIFO of
+		// messages, taken whole and reversed, so each producer's messages keep their order.
+		struct OutgoingMessage
+		{
+			std::string payload;
+			std::string key; // only kept while tracing
+			std::string probeKey; // set when the latency estimator times this submit
+			bool isSubmit;
+			bool compress; // registrations only: deflating each small submit under pollingMtx costs more than it saves
+			std::chrono::steady_clock::time_point submitted;
+			std::chrono::steady_clock::time_point serialized;
+			OutgoingMessage* next;
+		};
+		std::atomic<OutgoingMessage*> outgoing{ nullptr };
+
+		// Sent messages are kept for reuse along with their payload's capacity, so steady submits serialize without
+		// allocating. spareMtx is held only to pop or push one pointer; messages grown past MaxSparePayload are freed.
+		static const size_t MaxSpareMessages = 64;
+		static const size_t MaxSparePayload = 4096;
+		std::mutex spareMtx;
+		std::vector<OutgoingMessage*> spareMessages;
 
 		std::string host = "127.0.0.1";
 		int port = 15881;
@@ -130,34 +156,166 @@ namespace bhaptics
 		int reconnectSec = 5;
 		std::chrono::steady_clock::time_point prevReconnect;
 
-		bool isRegisterSent = true;
+		std::atomic<bool> isRegisterSent{ true };
+
+		// Offer permessage-deflate on the next connection, shrinking large register payloads on the wire.
+		std::atomic<bool> compress{ false };
+
+		// Traffic of connections that have since been closed.
+		TrafficStats retiredTraffic;
+
+		StatsCounters stats;
+
+		int connectionCount = 0; // guarded by connectionMtx
+
+		// Submits framed into the socket's send buffer, waiting for their last byte to be sent. Guarded by pollingMtx.
+		struct PendingSubmit
+		{
+			uint64_t sentOffset;
+			std::chrono::steady_clock::time_point submitted;
+			std::chrono::steady_clock::time_point enqueued;
+		};
+		std::deque<PendingSubmit> pendingSubmits;
 
-		int connectionCount = 0;
+		LatencyHistogram serializeLatency;
+		LatencyHistogram enqueueLatency;
+		LatencyHistogram sendLatency;
+		LatencyHistogram totalLatency;
+
+		RequestRecorder recorder;
+
+		// Registered feedbacks with options, transformed by the library and sent as frames by the timer thread.
+		struct LocalPlayback
+		{
+			std::string Identity; // altKey, or key without one
+			std::shared_ptr<const CompiledFeedback> Feedback;
+			std::chrono::steady_clock::time_point Started;
+		};
+		FeedbackTransformer transformer;
+		std::atomic<bool> localTransforms{ false };
+		std::vector<LocalPlayback> localPlaybacks; // guarded by localMtx
+		std::atomic<size_t> localPlaybackCount{ 0 };
+		std::mutex localMtx;
+
+		// Procedural effects, rendered by the timer thread and mixed with the local playbacks.
+		WaveformSynth synth; // guarded by localMtx
+		std::atomic<size_t> synthVoiceCount{ 0 };
+		std::vector<SynthFrame> synthFrames; // timer thread only
+
+		// Band levels of the audio fed by the game, mixed with the local playbacks.
+		AudioHaptics audio;
+		std::vector<SynthFrame> audioFrames; // timer thread only
+
+		// Requests waiting for their due time, in milliseconds since scheduleEpoch. Fired by the timer thread.
+		TimingWheel scheduled; // guarded by scheduleMtx
+		std::mutex scheduleMtx;
+		std::atomic<size_t> scheduledCount{ 0 };
+		const std::chrono::steady_clock::time_point scheduleEpoch = std::chrono::steady_clock::now();
+		std::vector<SubmitRequest> dueRequests; // timer thread only
+
+		// Round trip and Player processing delay; onset-tagged scheduled requests are sent early by their sum.
+		LatencyEstimator latency;
+		std::string pingPayload; // guarded by pollingMtx
+		std::string pongPayload; // guarded by pollingMtx
 
 		//functions
 
 		void reconnect();
 
+		void replaceSocket(easywsclient::WebSocket* socket);
+
+		// Publishes the socket's traffic counters to stats. Call with pollingMtx held.
+		void syncTraffic();
+
 		void resendRegistered();
 
+		void upsertRegistered(const RegisterRequest &request);
+
+		// Takes pollingMtx and replaces a closed socket. For the timer thread; producers use isConnected.
 		bool connectionCheck();
 
-		void send(PlayerRequest request);
+		bool isConnected() const { return connected.load(std::memory_order_relaxed); }
+
+		bool isCulled(Position position) const
+		{
+			return cullDisconnected.load(std::memory_order_relaxed)
+				&& (connectedMask.load(std::memory_order_relaxed) & positionMask(position)) == 0;
+		}
+
+		// A non-default submitted time marks the request as a submit and records its latency.
+		// Serializes on the calling thread, queues the message and sends the queue if pollingMtx is free.
+		void send(const PlayerRequest& request, std::chrono::steady_clock::time_point submitted = std::chrono::steady_clock::time_point());
+
+		OutgoingMessage* takeMessage();
 
-		void updateActive(const std::string &key, const Frame& signal);
+		void recycleMessage(OutgoingMessage* message);
+
+		void pushOutgoing(OutgoingMessage* message);
+
+		// Sends, or drops if there is no open socket, every queued message. Call with pollingMtx held.
+		void drainOutgoing();
+
+		// Drains the queue, polls the socket and releases pollingMtx, then takes it again if more messages
+		// were queued meanwhile by producers that found it held.
+		void releasePolling();
+
+		void recordSentSubmits();
+
+		// Polls the socket, tracing the bytes written when tracing is enabled. Call with pollingMtx held.
+		void pollSocket();
+
+		void updateActive(const std::string &key, const Frame& signal, std::chrono::steady_clock::time_point submitted);
 
 		void remove(const std::string &key);
 
 		void removeAll();
 
+		// Drops dot points beyond the motors of the frame's device.
+		void fitToDevice(Frame& frame);
+
+		// Replaces the path points of frame with the motor intensities they produce, merged with its dot points, when path
+		// rasterization is enabled and the device's motor layout is known.
+		bool rasterize(Frame& frame);
+
+		// Rasterizes points, which need not fit in a frame, into frame's dot points.
+		bool rasterize(Frame& frame, const PathPoint* points, size_t count);
+
+		// Starts key as a local playback when local transforms are enabled and its project compiles.
+		bool playLocally(const std::string &key, const std::string &altKey, ScaleOption option, RotationOption rotOption);
+
+		// Stops the local playback of identity, or every local playback if identity is empty.
+		void stopLocal(const std::string &identity);
+
+		// Stops the procedural effect of key, or every one if key is empty, without its release.
+		void stopSynth(const std::string &key);
+
+		// Ticks the timer at _interval while anything sends local frames, every 100 ms otherwise. Call with localMtx held.
+		void updateTimerInterval();
+
+		// Mixes the current frame of every local playback into one frame per position and sends them. Frames are picked
+		// by elapsed time, so a late timer tick skips frames rather than stretching the feedback.
+		void sendLocalFrames();
+
 		void callbackFunc();
 
+		// Sends the scheduled requests that fell due as one batch; returns the milliseconds until the next may.
+		int pollScheduled();
+
+		// Pings the Player when the latency estimator asks for a sample. Called by the timer thread.
+		void measureLatency();
+
+		// The timer's poll handler: fires scheduled requests, and reads replies every millisecond while a latency
+		// sample is outstanding so they are timed closely.
+		int pollTimer();
+
+		// Key of the first request of request the latency estimator can time, or "" if none; see LatencyEstimator.
+		static std::string probeKey(const PlayerRequest& request);
+
 	public:
 
 		static	Position stringToPosition(const std::string deviceName);
 
-		bool retryConnection = true;
-		PlayerResponse CurrentResponse;
+		std::atomic<bool> retryConnection{ true };
 
 		void doRepeat();
 
@@ -179,6 +337,38 @@ namespace bhaptics
 
 		void submitRegistered(const std::string &key);
 
+		// Sends every request in one message, keeping only the last request per key. Counted in stats like the
+		// individual calls; requests superseded within the batch are counted as CoalescedFrames.
+		void submitBatch(const std::vector<SubmitRequest> &requests);
+
+		// Sends each request DelayMillis from now, within about a millisecond, from the timer thread. Requests that
+		// fall due together are sent through submitBatch, so a sequence such as hits running along a limb is one call.
+		// Requests with CompensateLatency are sent the measured lead earlier; those already due are sent right away.
+		void scheduleBatch(const std::vector<ScheduledSubmit> &requests);
+
+		void schedule(int delayMillis, const SubmitRequest &request);
+
+		// Plays a procedural effect under key with no registration: the timer thread renders it into a frame every
+		// interval while it plays. Playing key again restarts it.
+		void playSynth(const std::string &key, const SynthEffect &effect);
+
+		// Replaces the parameters of key's effect without restarting its envelope or oscillator. Returns false if key
+		// is not playing.
+		bool updateSynth(const std::string &key, const SynthEffect &effect);
+
+		// Fades key's effect, or every effect if key is empty, out over its release.
+		void releaseSynth(const std::string &key);
+
+		// Plays haptics derived from the audio passed to feedAudio, as config routes it; no routes disables it.
+		void setAudioHaptics(const AudioHapticsConfig &config);
+
+		// Analyses interleaved samples for audio haptics. For one audio thread at a time; never locks or allocates.
+		void feedAudio(const float* samples, int frames, int channels, int sampleRate);
+
+		// Drops the scheduled requests whose key, or altKey when they have one, is key; every scheduled request if key
+		// is empty. Requests already sent keep playing. Returns how many were dropped.
+		size_t cancelScheduled(const std::string &key);
+
 		bool isPlaying();
 
 		bool isPlaying(const std::string &key);
@@ -199,7 +389,7 @@ namespace bhaptics
 
 		void toggleFeedback();
 
-		void parseResponse(PlayerResponse response);
+		void parseResponse(const PlayerResponse& response);
 
 		bool isDevicePlaying(Position device);
 
@@ -213,18 +403,57 @@ namespace bhaptics
 
 		void unregisterConnection(std::string Id);
 
-		std::map<std::string, std::vector<int>> getResponseStatus();
+		DeviceStatus getResponseStatus();
+
+		// Increases whenever the motor values reported by the Player change. Lock-free.
+		uint64_t getStatusVersion() const { return statusVersion.load(std::memory_order_acquire); }
+
+		// Copies the motor values and sets version to the matching status version, unless version is already current.
+		bool getResponseStatusSince(uint64_t &version, DeviceStatus &status);
+
+		void setCompression(bool enable);
+
+		// Sends path point frames as the dot frames they rasterize to, instead of leaving the Player to pick motors.
+		// Frames for devices without a known motor layout keep their path points.
+		void setRasterizePaths(bool enable);
+
+		// Applies the ScaleOption and RotationOption of registered submits in the library and plays the result as
+		// frames, mixed with other local playbacks, instead of asking the Player to transform the key.
+		// Feedbacks that cannot be compiled are still sent to the Player.
+		void setLocalTransforms(bool enable);
+
+		// Rejects frame submits for devices missing from the Player's last status, before they are converted or
+		// serialized. Registered feedbacks, which may span several devices, are always sent.
+		void setCullDisconnected(bool enable);
+
+		// positionMask bits of the connected devices; none until the first status arrives. Lock-free.
+		uint32_t getConnectedMask() const
+		{
+			return statusReceived.load(std::memory_order_acquire) ? connectedMask.load(std::memory_order_relaxed) : 0;
+		}
+
+		TrafficStats getTrafficStats();
+
+		HapticStats getStats();
+
+		SubmitLatencyStats getSubmitLatency();
+
+		void resetSubmitLatency();
+
+		LinkLatency getLinkLatency() const { return latency.snapshot(); }
+
+		// Logs every request sent to the Player, and optionally every status received, until stopRecording or destroy.
+		bool startRecording(const std::string& path, bool includeStatus);
+
+		void stopRecording();
 
 		HapticPlayer(HapticPlayer const&) = delete;
 		void operator= (HapticPlayer const&) = delete;
 
 		static HapticPlayer *instance()
 		{
-			if (!hapticManager)
-			{
-				hapticManager = new HapticPlayer();
-			}
-
+			static std::once_flag created;
+			std::call_once(created, []() { hapticManager = new HapticPlayer(); });
 			return hapticManager;
 		}
 
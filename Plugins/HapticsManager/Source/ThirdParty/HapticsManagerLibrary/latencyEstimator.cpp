@@ -0,0 +1,174 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "latencyEstimator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bhaptics
+{
+	namespace
+	{
+		const int PayloadBytes = 8;
+
+		int64_t elapsedMicros(LatencyEstimator::TimePoint from, LatencyEstimator::TimePoint to)
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+		}
+	}
+
+	void LatencyEstimator::reset()
+	{
+		pingOutstanding = false;
+		probeKey.clear();
+		smoothedRtt = 0;
+		rttVariance = 0;
+		processingCount = 0;
+		roundTripSampleCount = 0;
+		processingSampleCount = 0;
+		minRoundTrip = 0;
+		probeWanted = true;
+		publish();
+	}
+
+	bool LatencyEstimator::startPing(TimePoint now, std::string& payload)
+	{
+		if (!probeKey.empty() && elapsedMicros(probeSent, now) > TimeoutMillis * 1000)
+		{
+			// The probe may have ended before a status saw it; time another one.
+			probeKey.clear();
+		}
+		if (probeKey.empty() && elapsedMicros(lastProbe, now) >= ProbeIntervalMillis * 1000)
+		{
+			probeWanted = true;
+		}
+
+		if (pingOutstanding)
+		{
+			if (elapsedMicros(pingSent, now) < TimeoutMillis * 1000)
+			{
+				measuring = true;
+				return false;
+			}
+			pingOutstanding = false;
+		}
+		else if (roundTripSampleCount > 0 && elapsedMicros(pingSent, now) < PingIntervalMillis * 1000)
+		{
+			measuring = !probeKey.empty();
+			return false;
+		}
+
+		pingSequence++;
+		payload.resize(PayloadBytes);
+		for (int i = 0; i < PayloadBytes; i++)
+		{
+			payload[i] = (char)((pingSequence >> (8 * i)) & 0xFF);
+		}
+		pingOutstanding = true;
+		pingSent = now;
+		measuring = true;
+		return true;
+	}
+
+	void LatencyEstimator::onPong(const std::string& payload, TimePoint now)
+	{
+		if (!pingOutstanding || payload.size() != PayloadBytes)
+		{
+			return;
+		}
+		uint64_t sequence = 0;
+		for (int i = 0; i < PayloadBytes; i++)
+		{
+			sequence |= (uint64_t)(uint8_t)payload[i] << (8 * i);
+		}
+		if (sequence != pingSequence)
+		{
+			return;
+		}
+		pingOutstanding = false;
+		measuring = !probeKey.empty();
+
+		double sample = (double)std::max<int64_t>(elapsedMicros(pingSent, now), 0);
+		if (roundTripSampleCount == 0)
+		{
+			smoothedRtt = sample;
+			rttVariance = sample / 2;
+			minRoundTrip = (uint64_t)sample;
+		}
+		else
+		{
+			rttVariance = 0.75 * rttVariance + 0.25 * std::fabs(smoothedRtt - sample);
+			smoothedRtt = 0.875 * smoothedRtt + 0.125 * sample;
+			if ((uint64_t)sample < minRoundTrip)
+			{
+				minRoundTrip = (uint64_t)sample;
+			}
+		}
+		roundTripSampleCount++;
+		publish();
+	}
+
+	void LatencyEstimator::startProbe(const std::string& key, TimePoint sent)
+	{
+		if (!probeKey.empty() || key.empty())
+		{
+			return;
+		}
+		probeKey = key;
+		probeSent = sent;
+		lastProbe = sent;
+		probeWanted = false;
+		measuring = true;
+	}
+
+	void LatencyEstimator::onStatus(const std::vector<std::string>& activeKeys, TimePoint now)
+	{
+		if (probeKey.empty() || std::find(activeKeys.begin(), activeKeys.end(), probeKey) == activeKeys.end())
+		{
+			return;
+		}
+		probeKey.clear();
+		measuring = pingOutstanding;
+
+		// Without a round trip the one-way share of the sample is unknown.
+		if (roundTripSampleCount == 0)
+		{
+			return;
+		}
+		int64_t sample = elapsedMicros(probeSent, now) - (int64_t)smoothedRtt;
+		processingSamples[processingCount % ProcessingWindow] = (uint64_t)std::max<int64_t>(sample, 0);
+		processingCount++;
+		processingSampleCount++;
+		publish();
+	}
+
+	LinkLatency LatencyEstimator::snapshot() const
+	{
+		LinkLatency latency;
+		latency.RoundTripMicros = roundTrip;
+		latency.RoundTripVarianceMicros = roundTripVariance;
+		latency.MinRoundTripMicros = minRoundTrip;
+		latency.ProcessingMicros = processing;
+		latency.LeadMicros = (uint64_t)std::max<int64_t>(lead, 0);
+		latency.RoundTripSamples = roundTripSampleCount;
+		latency.ProcessingSamples = processingSampleCount;
+		return latency;
+	}
+
+	void LatencyEstimator::publish()
+	{
+		uint64_t minProcessing = 0;
+		int samples = std::min(processingCount, ProcessingWindow);
+		for (int i = 0; i < samples; i++)
+		{
+			if (i == 0 || processingSamples[i] < minProcessing)
+			{
+				minProcessing = processingSamples[i];
+			}
+		}
+
+		roundTrip = (uint64_t)smoothedRtt;
+		roundTripVariance = (uint64_t)rttVariance;
+		processing = minProcessing;
+		lead = (int64_t)(smoothedRtt / 2) + (int64_t)minProcessing;
+	}
+}
@@ -0,0 +1,83 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_LATENCY_ESTIMATOR
+#define BHAPTICS_LATENCY_ESTIMATOR
+
+#include "model.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bhaptics
+{
+	// Estimates how long a submit takes to be felt: half the round trip to the Player, measured with WebSocket pings,
+	// plus the Player's processing delay, measured by timing one submit ("probe") until a status lists its key as
+	// active. The round trip is smoothed as TCP does (RFC 6298); processing is the minimum of the last samples, which
+	// filters out the wait for the Player's next status.
+	//
+	// Measurements are fed by the thread holding HapticPlayer's pollingMtx. The estimates and wantsProbe are atomics
+	// and may be read from any thread.
+	class LatencyEstimator
+	{
+	public:
+		typedef std::chrono::steady_clock::time_point TimePoint;
+
+		static const int PingIntervalMillis = 1000;
+		static const int ProbeIntervalMillis = 1000;
+		static const int TimeoutMillis = 2000;
+		static const int ProcessingWindow = 8;
+
+		// Forgets every sample, e.g. when the connection is replaced.
+		void reset();
+
+		// Returns true and the payload of the next ping once PingIntervalMillis passed since the last one, and the last
+		// one was answered or timed out. Also expires a probe that was never reported active.
+		bool startPing(TimePoint now, std::string& payload);
+
+		void onPong(const std::string& payload, TimePoint now);
+
+		// Whether the next submit sent should be timed as a probe.
+		bool wantsProbe() const { return probeWanted.load(std::memory_order_relaxed); }
+
+		void startProbe(const std::string& key, TimePoint sent);
+
+		void onStatus(const std::vector<std::string>& activeKeys, TimePoint now);
+
+		// Whether a ping or probe is waiting for its answer; replies are then best read within a millisecond.
+		bool isMeasuring() const { return measuring.load(std::memory_order_relaxed); }
+
+		// Microseconds an onset-tagged submit is sent ahead of its onset.
+		int64_t leadMicros() const { return lead.load(std::memory_order_relaxed); }
+
+		LinkLatency snapshot() const;
+
+	private:
+		// Guarded by pollingMtx.
+		uint64_t pingSequence = 0;
+		bool pingOutstanding = false;
+		TimePoint pingSent;
+		std::string probeKey; // empty when no probe is outstanding
+		TimePoint probeSent;
+		TimePoint lastProbe;
+		double smoothedRtt = 0;
+		double rttVariance = 0;
+		uint64_t processingSamples[ProcessingWindow] = {};
+		int processingCount = 0;
+
+		std::atomic<bool> probeWanted{ true };
+		std::atomic<bool> measuring{ false };
+		std::atomic<int64_t> lead{ 0 };
+		std::atomic<uint64_t> roundTrip{ 0 };
+		std::atomic<uint64_t> roundTripVariance{ 0 };
+		std::atomic<uint64_t> minRoundTrip{ 0 };
+		std::atomic<uint64_t> processing{ 0 };
+		std::atomic<uint64_t> roundTripSampleCount{ 0 };
+		std::atomic<uint64_t> processingSampleCount{ 0 };
+
+		void publish();
+	};
+}
+
+#endif
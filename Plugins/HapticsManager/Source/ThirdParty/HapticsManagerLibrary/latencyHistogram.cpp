@@ -0,0 +1,103 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "latencyHistogram.h"
+
+namespace bhaptics
+{
+	LatencyHistogram::LatencyHistogram()
+	{
+		reset();
+	}
+
+	int LatencyHistogram::bucketIndex(uint64_t micros)
+	{
+		if (micros < SubBuckets)
+		{
+			return (int)micros;
+		}
+
+		int exponent = 0;
+		while ((micros >> exponent) > 1)
+		{
+			exponent++;
+		}
+
+		int sub = (int)((micros >> (exponent - 2)) & (SubBuckets - 1));
+		int index = SubBuckets * (exponent - 1) + sub;
+		return index < BucketCount ? index : BucketCount - 1;
+	}
+
+	uint64_t LatencyHistogram::bucketUpperBound(int index)
+	{
+		if (index < SubBuckets)
+		{
+			return (uint64_t)index;
+		}
+
+		int exponent = index / SubBuckets + 1;
+		uint64_t sub = (uint64_t)(index % SubBuckets);
+		return ((SubBuckets + sub + 1) << (exponent - 2)) - 1;
+	}
+
+	void LatencyHistogram::record(uint64_t micros)
+	{
+		buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+		count.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t current = max.load(std::memory_order_relaxed);
+		while (micros > current && !max.compare_exchange_weak(current, micros, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void LatencyHistogram::reset()
+	{
+		for (int i = 0; i < BucketCount; i++)
+		{
+			buckets[i].store(0, std::memory_order_relaxed);
+		}
+		count.store(0, std::memory_order_relaxed);
+		max.store(0, std::memory_order_relaxed);
+	}
+
+	LatencyPercentiles LatencyHistogram::percentiles() const
+	{
+		LatencyPercentiles ret;
+		ret.Count = count.load(std::memory_order_relaxed);
+		ret.MaxMicros = max.load(std::memory_order_relaxed);
+		if (ret.Count == 0)
+		{
+			return ret;
+		}
+
+		// Samples recorded while scanning may make the buckets disagree slightly with Count, which is fine for reporting.
+		uint64_t p50Rank = (ret.Count + 1) / 2;
+		uint64_t p99Rank = ret.Count - ret.Count / 100;
+		uint64_t seen = 0;
+		bool p50Found = false;
+		for (int i = 0; i < BucketCount; i++)
+		{
+			seen += buckets[i].load(std::memory_order_relaxed);
+			if (!p50Found && seen >= p50Rank)
+			{
+				ret.P50Micros = bucketUpperBound(i);
+				p50Found = true;
+			}
+			if (seen >= p99Rank)
+			{
+				ret.P99Micros = bucketUpperBound(i);
+				break;
+			}
+		}
+
+		// Bucket bounds can overshoot the largest sample.
+		if (ret.P50Micros > ret.MaxMicros)
+		{
+			ret.P50Micros = ret.MaxMicros;
+		}
+		if (ret.P99Micros > ret.MaxMicros || ret.P99Micros == 0)
+		{
+			ret.P99Micros = ret.MaxMicros;
+		}
+		return ret;
+	}
+}
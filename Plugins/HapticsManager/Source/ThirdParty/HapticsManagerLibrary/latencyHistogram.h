@@ -0,0 +1,38 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_LATENCY_HISTOGRAM
+#define BHAPTICS_LATENCY_HISTOGRAM
+
+#include "model.h"
+
+#include <atomic>
+#include <stdint.h>
+
+namespace bhaptics
+{
+	// Lock-free log-linear histogram of durations in microseconds.
+	// Each power of two is split into four buckets, so percentiles are within 25% of the recorded value.
+	class LatencyHistogram
+	{
+	public:
+		LatencyHistogram();
+
+		void record(uint64_t micros);
+
+		void reset();
+
+		LatencyPercentiles percentiles() const;
+
+	private:
+		static const int SubBuckets = 4;
+		static const int BucketCount = 4 * 40;
+
+		static int bucketIndex(uint64_t micros);
+		static uint64_t bucketUpperBound(int index);
+
+		std::atomic<uint64_t> buckets[BucketCount];
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> max;
+	};
+}
+
+#endif
@@ -2,9 +2,12 @@
 #ifndef BHAPTICS_MODEL
 #define BHAPTICS_MODEL
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <string>
+#include <stdint.h>
+#include <stdio.h>
 
 
 namespace bhaptics
@@ -22,6 +25,29 @@ namespace bhaptics
 		Custom1 = 251, Custom2 = 252, Custom3 = 253, Custom4 = 254
 	};
 
+	// The most motors any device has; DotPoint indices and status values stay below it. See motorLayout.h for the
+	// count of each device.
+	static const int MaxMotors = 20;
+
+	// The most path points one frame carries. Further points are dropped, unless the frame is rasterized.
+	static const int MaxPathPoints = 32;
+
+	// Requests serialize by appending to one string, so a message is built without temporaries. Numbers are formatted
+	// as std::to_string formats them, so the JSON is unchanged.
+	inline void appendNumber(std::string& out, int value)
+	{
+		char buffer[16];
+		int length = snprintf(buffer, sizeof(buffer), "%d", value);
+		out.append(buffer, (size_t)length);
+	}
+
+	inline void appendNumber(std::string& out, float value)
+	{
+		char buffer[64];
+		int length = snprintf(buffer, sizeof(buffer), "%f", value);
+		out.append(buffer, (size_t)std::min(length, (int)sizeof(buffer) - 1));
+	}
+
 	enum FeedbackMode {
 		PATH_MODE,
 		DOT_MODE
@@ -31,19 +57,30 @@ namespace bhaptics
 	{
 		int index;
 		int intensity;
+		DotPoint() = default; // left uninitialized for FixedPoints
 		DotPoint(int _index, int _intensity)
 		{
 			index = _index;
 			if (_index < 0)
 				index = 0;
-			else if (_index > 19)
-				index = 19;
+			else if (_index > MaxMotors - 1)
+				index = MaxMotors - 1;
 			intensity = _intensity;
 		}
 
-		std::string to_string()
+		void appendTo(std::string& out) const
+		{
+			out.append("{ \"Index\":");
+			appendNumber(out, index);
+			out.append(", \"Intensity\": ");
+			appendNumber(out, intensity);
+			out.append("}");
+		}
+
+		std::string to_string() const
 		{
-			std::string ret = "{ \"Index\":" + std::to_string(index) + ", \"Intensity\": " + std::to_string(intensity) + "}";
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 
@@ -56,6 +93,7 @@ namespace bhaptics
 		int intensity;
 		int MotorCount;
 
+		PathPoint() = default; // left uninitialized for FixedPoints
 		PathPoint(int _x, int _y, int _intensity, int motorCount = 3)
 		{
 			int xRnd =_x;
@@ -96,9 +134,23 @@ namespace bhaptics
 			y = (float)(yRnd) / 1000;
 		}
 
-		std::string to_string()
+		void appendTo(std::string& out) const
+		{
+			out.append("{ \"X\":");
+			appendNumber(out, x);
+			out.append(", \"Y\": ");
+			appendNumber(out, y);
+			out.append(", \"Intensity\": ");
+			appendNumber(out, intensity);
+			out.append(", \"MotorCount\": ");
+			appendNumber(out, MotorCount);
+			out.append("}");
+		}
+
+		std::string to_string() const
 		{
-			std::string ret = "{ \"X\":" + std::to_string(x) + ", \"Y\": " + std::to_string(y) + ", \"Intensity\": " + std::to_string(intensity) + ", \"MotorCount\": " + std::to_string(MotorCount) + "}";
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 
@@ -126,66 +178,129 @@ namespace bhaptics
 		std::string ProjectJson;
 	};
 
+	// Up to Capacity points stored inline, so frames are built and copied without touching the allocator.
+	// Points past the capacity are dropped.
+	template<class Point, int Capacity>
+	class FixedPoints
+	{
+	public:
+		static const int capacity = Capacity;
+
+		// Returns false, dropping the point, when full.
+		bool push_back(const Point& point)
+		{
+			if (count == Capacity)
+			{
+				return false;
+			}
+			items[count++] = point;
+			return true;
+		}
+
+		// Replaces the points with those in [first, last). Returns how many did not fit.
+		template<class Iterator>
+		size_t assign(Iterator first, Iterator last)
+		{
+			count = 0;
+			size_t dropped = 0;
+			for (; first != last; ++first)
+			{
+				dropped += push_back(*first) ? 0 : 1;
+			}
+			return dropped;
+		}
+
+		Point* erase(Point* first, Point* last)
+		{
+			std::move(last, end(), first);
+			count -= (int)(last - first);
+			return first;
+		}
+
+		void clear() { count = 0; }
+		size_t size() const { return (size_t)count; }
+		bool empty() const { return count == 0; }
+
+		Point* data() { return items; }
+		const Point* data() const { return items; }
+		Point* begin() { return items; }
+		Point* end() { return items + count; }
+		const Point* begin() const { return items; }
+		const Point* end() const { return items + count; }
+		Point& operator[](size_t i) { return items[i]; }
+		const Point& operator[](size_t i) const { return items[i]; }
+
+	private:
+		Point items[Capacity];
+		int count = 0;
+	};
+
 	class Frame
 	{
 	public:
 		int DurationMillis = 0;
-		Position Position;
-		std::vector<PathPoint> PathPoints;
-		std::vector<DotPoint> DotPoints;
-		int Texture;
-
-		static Frame AsPathPointFrame(std::vector<PathPoint> points, bhaptics::Position position, int durationMillis, int texture = 0)
+		bhaptics::Position Position = All;
+		FixedPoints<PathPoint, MaxPathPoints> PathPoints;
+		FixedPoints<DotPoint, MaxMotors> DotPoints;
+		int Texture = 0;
+
+		// Points may be any container of PathPoint, e.g. a std::vector; only the first MaxPathPoints are kept.
+		template<class Points>
+		static Frame AsPathPointFrame(const Points& points, bhaptics::Position position, int durationMillis, int texture = 0)
 		{
 			Frame frame;
 			frame.Position = position;
-			frame.PathPoints = points;
+			frame.PathPoints.assign(std::begin(points), std::end(points));
 			frame.Texture = texture;
 			frame.DurationMillis = durationMillis;
 			return frame;
 		}
 
-		static Frame AsDotPointFrame(std::vector<DotPoint> points, bhaptics::Position position, int durationMillis, int texture = 0)
+		// Points may be any container of DotPoint; only the first MaxMotors are kept.
+		template<class Points>
+		static Frame AsDotPointFrame(const Points& points, bhaptics::Position position, int durationMillis, int texture = 0)
 		{
 			Frame frame;
 			frame.Position = position;
-			frame.DotPoints = points;
+			frame.DotPoints.assign(std::begin(points), std::end(points));
 			frame.Texture = texture;
 			frame.DurationMillis = durationMillis;
 			return frame;
 		}
 
-		std::string to_string()
+		void appendTo(std::string& out) const
 		{
-			std::vector<std::string> tempVec1, tempVec2;
-			std::string pathArrayStr, dotArrayStr;
-			pathArrayStr = "[";
-			for (size_t i = 0; i < PathPoints.size(); i++)
+			out.append("{ \"DurationMillis\":");
+			appendNumber(out, DurationMillis);
+			out.append(", \"Position\": ");
+			appendNumber(out, (int)Position);
+			out.append(", \"Texture\": ");
+			appendNumber(out, Texture);
+			out.append(", \"DotPoints\": [");
+			for (size_t i = 0; i < DotPoints.size(); i++)
 			{
-				std::string tmp = PathPoints[i].to_string();
-				pathArrayStr.append(tmp);
-				if (i + 1 < PathPoints.size())
+				if (i > 0)
 				{
-					pathArrayStr.append(",");
+					out.append(",");
 				}
+				DotPoints[i].appendTo(out);
 			}
-			pathArrayStr.append("]");
-
-			dotArrayStr = "[";
-			for (size_t i = 0; i < DotPoints.size(); i++)
+			out.append("], \"PathPoints\": [");
+			for (size_t i = 0; i < PathPoints.size(); i++)
 			{
-
-				std::string tmp = DotPoints[i].to_string();
-				dotArrayStr.append(tmp);
-				if (i + 1 < DotPoints.size())
+				if (i > 0)
 				{
-					dotArrayStr.append(",");
+					out.append(",");
 				}
+				PathPoints[i].appendTo(out);
 			}
-			dotArrayStr.append("]");
+			out.append("]}");
+		}
 
-			std::string ret = "{ \"DurationMillis\":" + std::to_string(DurationMillis) + ", \"Position\": " + std::to_string(Position) + ", \"Texture\": " + std::to_string(Texture) +
-				", \"DotPoints\": " + dotArrayStr + ", \"PathPoints\": " + pathArrayStr + "}";
+		std::string to_string() const
+		{
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
@@ -195,9 +310,19 @@ namespace bhaptics
 		float Intensity;
 		float Duration;
 
-		std::string to_string()
+		void appendTo(std::string& out) const
 		{
-			std::string ret = "{ \"intensity\" : " + std::to_string(Intensity) + ", \"duration\" : " + std::to_string(Duration) + "}";
+			out.append("{ \"intensity\" : ");
+			appendNumber(out, Intensity);
+			out.append(", \"duration\" : ");
+			appendNumber(out, Duration);
+			out.append("}");
+		}
+
+		std::string to_string() const
+		{
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
@@ -207,9 +332,19 @@ namespace bhaptics
 		float OffsetAngleX;
 		float OffsetY;
 
-		std::string to_string()
+		void appendTo(std::string& out) const
 		{
-			std::string ret = "{ \"offsetAngleX\" : " + std::to_string(OffsetAngleX) + ", \"offsetY\" : " + std::to_string(OffsetY) + "}";
+			out.append("{ \"offsetAngleX\" : ");
+			appendNumber(out, OffsetAngleX);
+			out.append(", \"offsetY\" : ");
+			appendNumber(out, OffsetY);
+			out.append("}");
+		}
+
+		std::string to_string() const
+		{
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
@@ -220,40 +355,171 @@ namespace bhaptics
 		std::string Key;
 		std::string ProjectJson;
 
-		std::string to_string()
+		void appendTo(std::string& out) const
+		{
+			out.append("{ \"Key\" : \"");
+			out.append(Key);
+			out.append("\", \"Project\" : ");
+			out.append(ProjectJson);
+			out.append("}");
+		}
+
+		std::string to_string() const
 		{
-			std::string ret = "{ \"Key\" : \"" + Key + "\", \"Project\" : " + ProjectJson + "}";
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
 
+	enum class SubmitType
+	{
+		Frame, Key, TurnOff, TurnOffAll
+	};
+
+	// The options of a registered submit, sent as its "Parameters" only when HasOptions is set.
+	struct SubmitParameters
+	{
+		bool HasOptions = false;
+		std::string AltKey;
+		ScaleOption Scale;
+		RotationOption Rotation;
+	};
+
 	struct SubmitRequest
 	{
-		std::string Type;
+		SubmitType Type = SubmitType::Frame;
 		std::string Key;
-		Frame Frame;
-		std::map<std::string, std::string> Parameters;
+		bhaptics::Frame Frame;
+		SubmitParameters Parameters;
+		// Every path point of a frame with more than MaxPathPoints, used in place of Frame.PathPoints: all of them are
+		// rasterized when path rasterization is on, otherwise the frame keeps the first MaxPathPoints and the rest are
+		// counted as DroppedPathPoints. Empty for frames that fit.
+		std::vector<PathPoint> AllPathPoints;
+
+		static SubmitRequest AsFrame(const std::string& key, const bhaptics::Frame& frame)
+		{
+			SubmitRequest req;
+			req.Type = SubmitType::Frame;
+			req.Key = key;
+			req.Frame = frame;
+			return req;
+		}
+
+		static SubmitRequest AsRegistered(const std::string& key)
+		{
+			SubmitRequest req;
+			req.Type = SubmitType::Key;
+			req.Key = key;
+			return req;
+		}
+
+		static SubmitRequest AsRegistered(const std::string& key, const std::string& altKey, ScaleOption option, RotationOption rotOption)
+		{
+			SubmitRequest req = AsRegistered(key);
+			req.Parameters.HasOptions = true;
+			req.Parameters.AltKey = altKey;
+			req.Parameters.Scale = option;
+			req.Parameters.Rotation = rotOption;
+			return req;
+		}
+
+		static SubmitRequest AsTurnOff(const std::string& key)
+		{
+			SubmitRequest req;
+			req.Type = SubmitType::TurnOff;
+			req.Key = key;
+			return req;
+		}
+
+		static SubmitRequest AsTurnOffAll()
+		{
+			SubmitRequest req;
+			req.Type = SubmitType::TurnOffAll;
+			return req;
+		}
+
+		// The key the Player plays this request under: the altKey of a registered feedback, if it has one.
+		const std::string& identity() const
+		{
+			return Parameters.AltKey.empty() ? Key : Parameters.AltKey;
+		}
 
-		std::string to_string()
+		static const char* typeName(SubmitType type)
 		{
-			std::string paramMapStr = "{";
-			for (auto& p : Parameters)
+			switch (type)
 			{
-				paramMapStr.append("\"" + p.first + "\": " + p.second + ",");
+			case SubmitType::Key:
+				return "key";
+			case SubmitType::TurnOff:
+				return "turnOff";
+			case SubmitType::TurnOffAll:
+				return "turnOffAll";
+			default:
+				return "frame";
 			}
-			paramMapStr.pop_back();
-			paramMapStr.append("}");
+		}
 
-			std::string paramString = "";
-			if (paramMapStr.size() > 2) {
-				paramString = ", \"Parameters\": " + paramMapStr;
+		void appendTo(std::string& out) const
+		{
+			out.append("{ \"Type\" : \"");
+			out.append(typeName(Type));
+			out.append("\", \"Key\" : \"");
+			out.append(Key);
+			out.append("\"");
+			if (Parameters.HasOptions)
+			{
+				out.append(", \"Parameters\": {");
+				if (!Parameters.AltKey.empty())
+				{
+					out.append("\"altKey\": \"");
+					out.append(Parameters.AltKey);
+					out.append("\",");
+				}
+				out.append("\"rotationOption\": ");
+				Parameters.Rotation.appendTo(out);
+				out.append(",\"scaleOption\": ");
+				Parameters.Scale.appendTo(out);
+				out.append("}");
 			}
+			out.append(", \"Frame\" : ");
+			Frame.appendTo(out);
+			out.append(" }");
+		}
 
-			std::string ret = "{ \"Type\" : \"" + Type + "\", \"Key\" : \"" + Key + "\"" + paramString + ", \"Frame\" : " + Frame.to_string() + " }";
+		std::string to_string() const
+		{
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
 
+	// A submit request to send DelayMillis after it is scheduled; see HapticPlayer::scheduleBatch. With
+	// CompensateLatency, DelayMillis is when the feedback should be felt and the request is sent earlier by the
+	// measured lead (see LinkLatency).
+	struct ScheduledSubmit
+	{
+		int DelayMillis = 0;
+		bool CompensateLatency = false;
+		SubmitRequest Request;
+
+		static ScheduledSubmit After(int delayMillis, const SubmitRequest& request)
+		{
+			ScheduledSubmit scheduled;
+			scheduled.DelayMillis = delayMillis;
+			scheduled.Request = request;
+			return scheduled;
+		}
+
+		static ScheduledSubmit AtOnset(int onsetMillis, const SubmitRequest& request)
+		{
+			ScheduledSubmit scheduled = After(onsetMillis, request);
+			scheduled.CompensateLatency = true;
+			return scheduled;
+		}
+	};
+
 	class PlayerRequest
 	{
 	public:
@@ -265,41 +531,203 @@ namespace bhaptics
 			return new PlayerRequest();
 		}
 
-		std::string to_string()
+		void appendTo(std::string& out) const
 		{
-			std::string registerArrayStr, submitArrayStr;
-
-			registerArrayStr = "[";
+			out.append("{ \"Register\" : [");
 			for (size_t i = 0; i < Register.size(); i++)
 			{
-				registerArrayStr.append(Register[i].to_string());
-				if (i + 1 < Register.size())
+				if (i > 0)
 				{
-					registerArrayStr.append(",");
+					out.append(",");
 				}
+				Register[i].appendTo(out);
 			}
-			registerArrayStr.append("]");
-
-			submitArrayStr = "[";
+			out.append("], \"Submit\" : [");
 			for (size_t i = 0; i < Submit.size(); i++)
 			{
-				submitArrayStr.append(Submit[i].to_string());
-				if (i + 1 < Submit.size())
+				if (i > 0)
 				{
-					submitArrayStr.append(",");
+					out.append(",");
 				}
+				Submit[i].appendTo(out);
 			}
-			submitArrayStr.append("]");
+			out.append("]}");
+		}
 
-			std::string ret = "{ \"Register\" : " + registerArrayStr + ", \"Submit\" : " + submitArrayStr + "}";
+		std::string to_string() const
+		{
+			std::string ret;
+			appendTo(ret);
 			return ret;
 		}
 	};
 
+	// Bytes exchanged with the Player since the library was loaded. Payload bytes are the JSON messages,
+	// wire bytes are what actually crossed the socket, so the difference is the compression saving.
+	struct TrafficStats
+	{
+		uint64_t PayloadBytesSent = 0;
+		uint64_t WireBytesSent = 0;
+		uint64_t PayloadBytesReceived = 0;
+		uint64_t WireBytesReceived = 0;
+		uint64_t CompressedMessagesSent = 0;
+	};
+
+	// Monotonic counters of the haptics client since the library was loaded. Times are cumulative nanoseconds.
+	struct HapticStats
+	{
+		// Calls per submit type, counted whether or not they reached the Player.
+		uint64_t BytesSubmits = 0;
+		uint64_t DotSubmits = 0;
+		uint64_t PathSubmits = 0;
+		uint64_t RegisteredSubmits = 0;
+		uint64_t TurnOffs = 0;
+		uint64_t Registrations = 0;
+
+		// Submits never sent because feedback was disabled or the Player was not connected.
+		uint64_t DroppedFrames = 0;
+		// Submits merged into another frame before sending.
+		uint64_t CoalescedFrames = 0;
+		// Submits rejected because their device was not connected, while culling is enabled.
+		uint64_t CulledSubmits = 0;
+		// Registered submits with options played as local frames, by whether their transform was already cached.
+		uint64_t TransformCacheHits = 0;
+		uint64_t TransformCacheMisses = 0;
+		// Path points turned into motor intensities by the library, while path rasterization is enabled.
+		uint64_t RasterizedPathPoints = 0;
+		// Path points past MaxPathPoints in one frame, dropped because the frame was not rasterized.
+		uint64_t DroppedPathPoints = 0;
+		// Requests put on the scheduler, and those cancelled before they fell due.
+		uint64_t ScheduledSubmits = 0;
+		uint64_t CancelledScheduledSubmits = 0;
+		// 20 ms windows of audio analysed for haptics, and those dropped because the queue was full or they were too old
+		// by the time the timer thread took them.
+		uint64_t AudioWindows = 0;
+		uint64_t DroppedAudioWindows = 0;
+
+		uint64_t MessagesSent = 0;
+		uint64_t MessagesReceived = 0;
+		TrafficStats Traffic;
+
+		uint64_t SerializationNanos = 0;
+		uint64_t StatusParseNanos = 0;
+		uint64_t ReconnectAttempts = 0;
+		// Largest number of bytes waiting in the socket's send buffer after a send.
+		uint64_t TxBufferHighWater = 0;
+
+		// Time spent blocked on each of the client's locks.
+		uint64_t PollingLockWaitNanos = 0;
+		uint64_t StateLockWaitNanos = 0;
+		uint64_t RegisterLockWaitNanos = 0;
+		uint64_t ResponseLockWaitNanos = 0;
+	};
+
+	// Percentiles of one latency stage, in microseconds.
+	struct LatencyPercentiles
+	{
+		uint64_t Count = 0;
+		uint64_t P50Micros = 0;
+		uint64_t P99Micros = 0;
+		uint64_t MaxMicros = 0;
+	};
+
+	// Time taken by submits on their way to the Player, split by stage. Serialize is API entry to JSON ready,
+	// Enqueue covers waiting for the socket and framing into the send buffer, Send is the time the frame waited
+	// in the send buffer until its last byte was accepted by ::send. Total is API entry to sent.
+	struct SubmitLatencyStats
+	{
+		LatencyPercentiles Serialize;
+		LatencyPercentiles Enqueue;
+		LatencyPercentiles Send;
+		LatencyPercentiles Total;
+	};
+
+	enum class WaveShape
+	{
+		Constant,
+		Sine,
+		Square,
+		Triangle,
+		Saw,
+		Noise // a new random level per motor every period, or every frame without a frequency
+	};
+
+	// Attack, decay and release in milliseconds; SustainLevel, 0 to 1, is held from the end of the decay to the release.
+	struct Adsr
+	{
+		int AttackMillis = 0;
+		int DecayMillis = 0;
+		float SustainLevel = 1.0f;
+		int ReleaseMillis = 0;
+	};
+
+	// A procedural effect, evaluated by the library into a frame per timer tick instead of being registered with the
+	// Player; see WaveformSynth. Motor i of Position plays at
+	//   100 * Intensity * envelope * (1 - Depth + Depth * oscillator) * sweep weight of i
+	// where the oscillator runs from 0 to 1 at FrequencyHz.
+	struct SynthEffect
+	{
+		bhaptics::Position Position = VestFront;
+		float Intensity = 1.0f;
+		int DurationMillis = 0; // from the start to the release; 0 plays until released
+		Adsr Envelope;
+
+		WaveShape Shape = WaveShape::Constant;
+		float FrequencyHz = 0.0f;
+		float Depth = 1.0f; // 0 ignores the oscillator, 1 swings the level fully to 0
+
+		uint32_t MotorMask = 0xFFFFFFFF; // bit i lets the effect drive motor i
+
+		// A spot SweepWidth motors wide either side, moving from motor index SweepFrom to SweepTo over SweepMillis, then
+		// starting over with SweepLoop. A SweepMillis of 0 drives every motor in MotorMask evenly.
+		float SweepFrom = 0.0f;
+		float SweepTo = 0.0f;
+		float SweepWidth = 1.0f;
+		int SweepMillis = 0;
+		bool SweepLoop = false;
+
+		uint32_t Seed = 1; // of the noise, so an effect can be replayed identically
+	};
+
+	static const int AudioBands = 4;
+
+	// One device driven by audio. Band levels are spread over the rows of its motor layout, the lowest band on the bottom
+	// row and the highest on the top row; a device with a single row plays its loudest band.
+	struct AudioHapticsRoute
+	{
+		bhaptics::Position Position = VestFront;
+		float Gain = 1.0f;
+		float BandGains[AudioBands] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	};
+
+	// Haptics derived from audio; see AudioHaptics. Band i spans CrossoverHz[i - 1] to CrossoverHz[i].
+	struct AudioHapticsConfig
+	{
+		float CrossoverHz[AudioBands - 1] = { 150.0f, 600.0f, 2500.0f };
+		bool UsePeak = false;    // follow each band's peak instead of its RMS, for sharper transients
+		float FloorDb = -48.0f;  // band levels at or below play nothing; 0 dBFS plays at full intensity
+		int ReleaseMillis = 100; // time a level takes to fall from full to nothing once the sound stops
+		std::vector<AudioHapticsRoute> Routes; // empty disables audio haptics
+	};
+
+	// The link to the Player as measured by the client, in microseconds; zero until the first samples. RoundTrip is
+	// smoothed over WebSocket pings, Processing is the Player's delay from receiving a submit to reporting it active.
+	// Lead is how early onset-tagged submits are sent: half the round trip plus processing.
+	struct LinkLatency
+	{
+		uint64_t RoundTripMicros = 0;
+		uint64_t RoundTripVarianceMicros = 0;
+		uint64_t MinRoundTripMicros = 0;
+		uint64_t ProcessingMicros = 0;
+		uint64_t LeadMicros = 0;
+		uint64_t RoundTripSamples = 0;
+		uint64_t ProcessingSamples = 0;
+	};
+
 	struct HapticFeedback
 	{
 		Position DevicePosition;
-		std::vector<int>& Values;
+		std::vector<int> Values;
 	};
 
 }
@@ -0,0 +1,131 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_MOTOR_LAYOUT
+#define BHAPTICS_MOTOR_LAYOUT
+
+#include "positionSchema.h"
+
+namespace bhaptics
+{
+	// How the motors of the device at a Position are packed into DotPoint indices and status values, and where they sit
+	// on the unit square that PathPoint x and y address. Motors form a grid of Columns by Rows, indexed row by row.
+	// Coordinates are in units of motor spacing, so a distance of 1 reaches the next motor.
+	//
+	// Header-only, like positionSchema.h, so the engine module can size its arrays without calling into the library.
+	struct MotorLayout
+	{
+		static const int MaxMotors = bhaptics::MaxMotors;
+
+		int MotorCount;
+		int Columns;
+		int Rows;
+		bool Mapped; // false if the motor positions are unknown: MotorCount is then MaxMotors and paths stay unmapped
+		float X[MaxMotors];
+		float Y[MaxMotors];
+	};
+
+	constexpr MotorLayout makeMotorGrid(int columns, int rows, bool mapped = true)
+	{
+		MotorLayout layout{};
+		layout.MotorCount = columns * rows;
+		layout.Columns = columns;
+		layout.Rows = rows;
+		layout.Mapped = mapped;
+		for (int i = 0; i < MotorLayout::MaxMotors; i++)
+		{
+			layout.X[i] = i < layout.MotorCount ? (float)(i % columns) : 0;
+			layout.Y[i] = i < layout.MotorCount ? (float)(i / columns) : 0;
+		}
+		return layout;
+	}
+
+	namespace motorLayoutTables
+	{
+		// The layout of every PositionSchema entry, by schema index, expanded from its MotorGrid at compile time.
+		// Unknown positions use the last slot, laid out like All.
+		struct Tables
+		{
+			MotorLayout ByIndex[PositionCount + 1];
+			int StatusOffset[PositionCount]; // where the entry's values start in DeviceStatus::Values
+			int StatusMotors; // all motors of all entries
+			bool Fits;
+		};
+
+		constexpr Tables build()
+		{
+			Tables tables{};
+			tables.Fits = true;
+			for (int i = 0; i < PositionCount; i++)
+			{
+				const MotorGrid& grid = PositionSchema[i].Motors;
+				if (grid.Columns * grid.Rows > MaxMotors)
+				{
+					tables.Fits = false;
+				}
+				tables.ByIndex[i] = makeMotorGrid(grid.Columns, grid.Rows, grid.Mapped);
+				tables.StatusOffset[i] = tables.StatusMotors;
+				tables.StatusMotors += tables.ByIndex[i].MotorCount;
+			}
+			tables.ByIndex[PositionCount] = makeMotorGrid(motorGrids::Unmapped.Columns, motorGrids::Unmapped.Rows,
+				motorGrids::Unmapped.Mapped);
+			return tables;
+		}
+
+		static constexpr Tables Generated = build();
+		static_assert(Generated.Fits, "A MotorGrid in PositionSchema has more than MaxMotors motors");
+	}
+
+	// The layout of the device at position, from its PositionSchema entry.
+	inline const MotorLayout& motorLayout(Position position)
+	{
+		int index = positionIndex(position);
+		return motorLayoutTables::Generated.ByIndex[index < 0 ? PositionCount : index];
+	}
+
+	inline int motorCount(Position position)
+	{
+		return motorLayout(position).MotorCount;
+	}
+
+	// The motor values of every device in the Player's last status, packed in PositionSchema order so each entry takes
+	// only its own motors: 3 bytes for a shoe, 20 for a vest half. Fixed-capacity, so it is copied and compared without
+	// allocating.
+	struct DeviceStatus
+	{
+		static const int Capacity = motorLayoutTables::Generated.StatusMotors;
+
+		uint32_t Reported = 0; // bit i is set if the Player reported PositionSchema entry i
+		uint8_t Values[Capacity] = {};
+
+		// The motorCount(position) values of position, or null if the Player did not report it.
+		const uint8_t* values(Position position) const
+		{
+			int index = positionIndex(position);
+			return index >= 0 && (Reported & (1u << index)) != 0 ? &Values[motorLayoutTables::Generated.StatusOffset[index]] : nullptr;
+		}
+
+		// Marks position as reported and returns its motorCount(position) values to fill in, or null if it is not a Position.
+		uint8_t* report(Position position)
+		{
+			int index = positionIndex(position);
+			if (index < 0)
+			{
+				return nullptr;
+			}
+			Reported |= 1u << index;
+			return &Values[motorLayoutTables::Generated.StatusOffset[index]];
+		}
+
+		bool operator==(const DeviceStatus& other) const
+		{
+			return Reported == other.Reported && memcmp(Values, other.Values, sizeof(Values)) == 0;
+		}
+
+		bool operator!=(const DeviceStatus& other) const
+		{
+			return !(*this == other);
+		}
+	};
+	static_assert(PositionCount <= 32, "DeviceStatus::Reported has a bit per PositionSchema entry");
+}
+
+#endif
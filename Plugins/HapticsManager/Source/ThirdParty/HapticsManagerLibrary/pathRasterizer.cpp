@@ -0,0 +1,53 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "pathRasterizer.h"
+
+#include <math.h>
+
+namespace bhaptics
+{
+	void rasterizePath(const MotorLayout& layout, const PathPoint* points, size_t count, uint8_t* motors)
+	{
+		const int motorCount = layout.MotorCount;
+		const float columnScale = (float)(layout.Columns - 1);
+		const float rowScale = (float)(layout.Rows - 1);
+		float distances[MotorLayout::MaxMotors];
+
+		for (size_t p = 0; p < count; p++)
+		{
+			const PathPoint& point = points[p];
+			if (point.intensity <= 0)
+			{
+				continue;
+			}
+
+			// Branch-free over every motor, so the compiler can vectorize it.
+			const float x = point.x * columnScale;
+			const float y = point.y * rowScale;
+			for (int i = 0; i < motorCount; i++)
+			{
+				const float dx = layout.X[i] - x;
+				const float dy = layout.Y[i] - y;
+				distances[i] = dx * dx + dy * dy;
+			}
+
+			// MotorCount is at most 3: pick the nearest motors one at a time.
+			for (int pick = 0; pick < point.MotorCount && pick < motorCount; pick++)
+			{
+				int nearest = 0;
+				for (int i = 1; i < motorCount; i++)
+				{
+					nearest = distances[i] < distances[nearest] ? i : nearest;
+				}
+				if (distances[nearest] >= 1)
+				{
+					break;
+				}
+
+				int value = (int)lroundf(point.intensity * (1 - sqrtf(distances[nearest])));
+				value = value > 100 ? 100 : value;
+				motors[nearest] = (uint8_t)(value > motors[nearest] ? value : motors[nearest]);
+				distances[nearest] = 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,18 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_PATH_RASTERIZER
+#define BHAPTICS_PATH_RASTERIZER
+
+#include "motorLayout.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace bhaptics
+{
+	// Maps path points to motor intensities, approximating the Player: each point drives its MotorCount nearest motors,
+	// fading linearly to 0 one motor spacing away. Points are combined with the values already in motors by taking the
+	// maximum. motors holds layout.MotorCount intensities from 0 to 100.
+	void rasterizePath(const MotorLayout& layout, const PathPoint* points, size_t count, uint8_t* motors);
+}
+
+#endif
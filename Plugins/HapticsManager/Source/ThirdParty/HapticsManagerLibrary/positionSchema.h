@@ -0,0 +1,222 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_POSITION_SCHEMA
+#define BHAPTICS_POSITION_SCHEMA
+
+#include "model.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+namespace bhaptics
+{
+	// Every Position with the name the Player uses for it, the physical device it addresses and that device's motors.
+	// Conversions between positions, names, connected bits and motor layouts are lookups into tables generated from
+	// this one list at compile time.
+	//
+	// Header-only, like motorLayout.h, so the engine module converts positions without calling into the library.
+	// The motors of a device: a grid of Columns by Rows, expanded into a MotorLayout by motorLayout.h.
+	struct MotorGrid
+	{
+		int Columns;
+		int Rows;
+		bool Mapped; // false if the motor positions are unknown: paths addressing them stay unmapped
+	};
+
+	// Tactot halves have 20 motors, Tactosy sleeves, Tactal and the gloves 6, and the shoes 3. Positions that do not
+	// name one device (All, Vest, Racket, the custom positions) keep the full 20 values.
+	namespace motorGrids
+	{
+		static constexpr MotorGrid Tactot = { 4, 5, true };
+		static constexpr MotorGrid Tactosy = { 3, 2, true };
+		static constexpr MotorGrid Tactal = { 6, 1, true };
+		static constexpr MotorGrid Shoe = { 3, 1, true };
+		static constexpr MotorGrid Unmapped = { 4, 5, false };
+	}
+
+	struct PositionInfo
+	{
+		Position Value;
+		const char* Name;
+		Position Device; // positions addressing the same device share its connected bit and playing state
+		MotorGrid Motors;
+		bool Listed; // one entry per physical device in status lists, which follow the order of this table
+	};
+
+	static constexpr PositionInfo PositionSchema[] = {
+		{ All, "All", All, motorGrids::Unmapped, false },
+		{ Left, "Left", Left, motorGrids::Tactosy, false },
+		{ Right, "Right", Right, motorGrids::Tactosy, false },
+		{ Vest, "Vest", Vest, motorGrids::Unmapped, false },
+		{ Racket, "Racket", Racket, motorGrids::Unmapped, false },
+		{ ForearmL, "ForearmL", Left, motorGrids::Tactosy, true },
+		{ ForearmR, "ForearmR", Right, motorGrids::Tactosy, true },
+		{ Head, "Head", Head, motorGrids::Tactal, true },
+		{ VestFront, "VestFront", Vest, motorGrids::Tactot, true },
+		{ VestBack, "VestBack", Vest, motorGrids::Tactot, true },
+		{ HandL, "HandL", HandL, motorGrids::Tactosy, true },
+		{ HandR, "HandR", HandR, motorGrids::Tactosy, true },
+		{ FootL, "FootL", FootL, motorGrids::Shoe, true },
+		{ FootR, "FootR", FootR, motorGrids::Shoe, true },
+		{ GloveLeft, "GloveLeft", HandL, motorGrids::Tactosy, false },
+		{ GloveRight, "GloveRight", HandR, motorGrids::Tactosy, false },
+		{ Custom1, "Custom1", All, motorGrids::Unmapped, false },
+		{ Custom2, "Custom2", All, motorGrids::Unmapped, false },
+		{ Custom3, "Custom3", All, motorGrids::Unmapped, false },
+		{ Custom4, "Custom4", All, motorGrids::Unmapped, false },
+	};
+
+	static const int PositionCount = sizeof(PositionSchema) / sizeof(PositionSchema[0]);
+
+	namespace positionTables
+	{
+		// Position values fit in a byte; each maps to its schema index, or -1.
+		static const int ValueSlots = 256;
+
+		// Names are found by a perfect hash: FNV-1a with a seed chosen so no two names share a slot. If a new name
+		// collides, the static_assert below fails; search for another seed.
+		static const int NameSlots = 32;
+		static const uint32_t NameSeed = 993;
+
+		constexpr uint32_t hashName(const char* name, size_t length)
+		{
+			uint32_t hash = 2166136261u ^ NameSeed;
+			for (size_t i = 0; i < length; i++)
+			{
+				hash ^= (uint8_t)name[i];
+				hash *= 16777619u;
+			}
+			hash ^= hash >> 15;
+			return hash % NameSlots;
+		}
+
+		constexpr size_t nameLength(const char* name)
+		{
+			size_t length = 0;
+			while (name[length] != '\0')
+			{
+				length++;
+			}
+			return length;
+		}
+
+		struct Tables
+		{
+			int8_t ByValue[ValueSlots];
+			int8_t ByName[NameSlots];
+			bool PerfectHash;
+		};
+
+		constexpr Tables build()
+		{
+			Tables tables{};
+			tables.PerfectHash = true;
+			for (int i = 0; i < ValueSlots; i++)
+			{
+				tables.ByValue[i] = -1;
+			}
+			for (int i = 0; i < NameSlots; i++)
+			{
+				tables.ByName[i] = -1;
+			}
+			for (int i = 0; i < PositionCount; i++)
+			{
+				tables.ByValue[PositionSchema[i].Value] = (int8_t)i;
+				uint32_t slot = hashName(PositionSchema[i].Name, nameLength(PositionSchema[i].Name));
+				if (tables.ByName[slot] != -1)
+				{
+					tables.PerfectHash = false;
+				}
+				tables.ByName[slot] = (int8_t)i;
+			}
+			return tables;
+		}
+
+		static constexpr Tables Generated = build();
+		static_assert(Generated.PerfectHash, "Two position names share a hash slot; choose another NameSeed");
+	}
+
+	// Index of position in PositionSchema, or -1 if it is not a Position.
+	constexpr int positionIndex(Position position)
+	{
+		return (int)position < 0 || (int)position >= positionTables::ValueSlots ? -1 : positionTables::Generated.ByValue[(int)position];
+	}
+
+	// The motor grid of position, usable at compile time to size arrays; motorLayout() expands it.
+	constexpr MotorGrid motorGrid(Position position)
+	{
+		return positionIndex(position) < 0 ? motorGrids::Unmapped : PositionSchema[positionIndex(position)].Motors;
+	}
+
+	// Schema entry of position, or null if it is not a Position.
+	inline const PositionInfo* positionInfo(Position position)
+	{
+		int index = positionIndex(position);
+		return index < 0 ? nullptr : &PositionSchema[index];
+	}
+
+	// The Player's name for position, or "" if it has none.
+	inline const char* positionName(Position position)
+	{
+		const PositionInfo* info = positionInfo(position);
+		return info ? info->Name : "";
+	}
+
+	// Parses a position name; returns false and leaves position unchanged if the name is unknown.
+	inline bool positionFromName(const char* name, size_t length, Position& position)
+	{
+		int index = positionTables::Generated.ByName[positionTables::hashName(name, length)];
+		if (index < 0)
+		{
+			return false;
+		}
+		const PositionInfo& candidate = PositionSchema[index];
+		if (strlen(candidate.Name) != length || memcmp(candidate.Name, name, length) != 0)
+		{
+			return false;
+		}
+		position = candidate.Value;
+		return true;
+	}
+
+	inline bool positionFromName(const std::string& name, Position& position)
+	{
+		return positionFromName(name.data(), name.size(), position);
+	}
+
+	// Parses a position name, returning All if it is unknown.
+	inline Position positionFromName(const std::string& name)
+	{
+		Position position = All;
+		positionFromName(name, position);
+		return position;
+	}
+
+	// The Position with the given value, e.g. of an engine enum that mirrors it, or All if there is none.
+	inline Position positionFromValue(int value)
+	{
+		const PositionInfo* info = positionInfo((Position)value);
+		return info ? info->Value : All;
+	}
+
+	// The position naming the physical device position addresses: Vest for VestFront, Left for ForearmL.
+	inline Position positionDevice(Position position)
+	{
+		const PositionInfo* info = positionInfo(position);
+		return info ? info->Device : All;
+	}
+
+	// One bit per physical device, so connected checks are a single AND. Positions that address the same device share
+	// its bit: Left and ForearmL, Right and ForearmR, Vest, VestFront and VestBack, HandL and GloveLeft, HandR and GloveRight.
+	// All and the custom positions map to every bit and are never treated as disconnected.
+	static const uint32_t AllPositionsMask = 0xFFFFFFFF;
+
+	inline uint32_t positionMask(Position position)
+	{
+		Position device = positionDevice(position);
+		return device == All ? AllPositionsMask : 1u << device;
+	}
+}
+
+#endif
@@ -0,0 +1,198 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "requestRecorder.h"
+
+#include <string.h>
+
+namespace bhaptics
+{
+	static const char RecordingMagic[5] = { 'B', 'H', 'R', 'E', 'C' };
+	static const uint8_t RecordingVersion = 1;
+	static const uint8_t StatusRecordedFlag = 1;
+
+	static size_t putVarint(uint8_t* buffer, uint64_t value)
+	{
+		size_t length = 0;
+		while (value >= 0x80)
+		{
+			buffer[length++] = (uint8_t)(value | 0x80);
+			value >>= 7;
+		}
+		buffer[length++] = (uint8_t)value;
+		return length;
+	}
+
+	RequestRecorder::~RequestRecorder()
+	{
+		stop();
+	}
+
+	bool RequestRecorder::start(const std::string& path, bool recordStatus)
+	{
+		std::lock_guard<std::mutex> lock(fileMtx);
+		recording = false;
+		close();
+
+		file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Could not record session to %s\n", path.c_str());
+			return false;
+		}
+		setvbuf(file, nullptr, _IOFBF, 64 * 1024);
+
+		uint64_t startTime = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		uint8_t header[16];
+		memcpy(header, RecordingMagic, sizeof(RecordingMagic));
+		header[5] = RecordingVersion;
+		header[6] = recordStatus ? StatusRecordedFlag : 0;
+		header[7] = 0;
+		for (int i = 0; i < 8; i++)
+		{
+			header[8 + i] = (uint8_t)(startTime >> (8 * i));
+		}
+		fwrite(header, 1, sizeof(header), file);
+
+		includeStatus = recordStatus;
+		previous = std::chrono::steady_clock::now();
+		recording = true;
+		return true;
+	}
+
+	void RequestRecorder::stop()
+	{
+		std::lock_guard<std::mutex> lock(fileMtx);
+		recording = false;
+		close();
+	}
+
+	void RequestRecorder::close()
+	{
+		if (file != nullptr)
+		{
+			fclose(file);
+			file = nullptr;
+		}
+	}
+
+	void RequestRecorder::recordSent(const std::string& message)
+	{
+		if (!isRecording())
+		{
+			return;
+		}
+		write(RecordType::RequestSent, message.data(), message.size());
+	}
+
+	void RequestRecorder::recordReceived(const char* message, size_t length)
+	{
+		if (!isRecording())
+		{
+			return;
+		}
+		write(RecordType::StatusReceived, message, length);
+	}
+
+	void RequestRecorder::write(RecordType type, const char* payload, size_t length)
+	{
+		std::lock_guard<std::mutex> lock(fileMtx);
+		if (file == nullptr || (type == RecordType::StatusReceived && !includeStatus))
+		{
+			return;
+		}
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		uint64_t delta = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - previous).count();
+		previous += std::chrono::microseconds(delta); // carry the sub-microsecond remainder into the next delta
+
+		uint8_t header[21];
+		size_t headerLength = 0;
+		header[headerLength++] = (uint8_t)type;
+		headerLength += putVarint(header + headerLength, delta);
+		headerLength += putVarint(header + headerLength, length);
+		if (fwrite(header, 1, headerLength, file) != headerLength || fwrite(payload, 1, length, file) != length)
+		{
+			fprintf(stderr, "Session recording stopped: write failed\n");
+			recording = false;
+			close();
+		}
+	}
+
+	RecordingReader::~RecordingReader()
+	{
+		if (file != nullptr)
+		{
+			fclose(file);
+		}
+	}
+
+	bool RecordingReader::open(const std::string& path)
+	{
+		file = fopen(path.c_str(), "rb");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Could not open %s\n", path.c_str());
+			return false;
+		}
+
+		uint8_t header[16];
+		if (fread(header, 1, sizeof(header), file) != sizeof(header)
+			|| memcmp(header, RecordingMagic, sizeof(RecordingMagic)) != 0
+			|| header[5] != RecordingVersion)
+		{
+			fprintf(stderr, "%s is not a session recording\n", path.c_str());
+			fclose(file);
+			file = nullptr;
+			return false;
+		}
+
+		statusRecorded = (header[6] & StatusRecordedFlag) != 0;
+		startTime = 0;
+		for (int i = 0; i < 8; i++)
+		{
+			startTime |= (uint64_t)header[8 + i] << (8 * i);
+		}
+		elapsed = 0;
+		return true;
+	}
+
+	bool RecordingReader::readVarint(uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			int c = fgetc(file);
+			if (c == EOF)
+			{
+				return false;
+			}
+			value |= (uint64_t)(c & 0x7f) << shift;
+			if ((c & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool RecordingReader::next(RecordedMessage& message)
+	{
+		if (file == nullptr)
+		{
+			return false;
+		}
+
+		int type = fgetc(file);
+		uint64_t delta, length;
+		if (type == EOF || !readVarint(delta) || !readVarint(length))
+		{
+			return false;
+		}
+
+		message.Type = (RecordType)type;
+		elapsed += delta;
+		message.TimeMicros = elapsed;
+		message.Payload.resize((size_t)length);
+		return length == 0 || fread(&message.Payload[0], 1, (size_t)length, file) == length;
+	}
+}
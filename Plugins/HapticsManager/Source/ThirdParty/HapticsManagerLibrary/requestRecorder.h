@@ -0,0 +1,85 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_REQUEST_RECORDER
+#define BHAPTICS_REQUEST_RECORDER
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+namespace bhaptics
+{
+	// Session log format, all integers little-endian:
+	//   header: "BHREC" | version (1 byte) | flags (1 byte, bit 0: status recorded) | 0 | start time (8 bytes, microseconds since the Unix epoch)
+	//   record: type (1 byte) | microseconds since the previous record (varint) | payload length (varint) | payload
+	// Payloads are the JSON messages exactly as they went over (or came off) the WebSocket.
+	enum class RecordType : uint8_t
+	{
+		RequestSent = 1,
+		StatusReceived = 2,
+	};
+
+	struct RecordedMessage
+	{
+		RecordType Type = RecordType::RequestSent;
+		uint64_t TimeMicros = 0; // since the start of the recording
+		std::string Payload;
+	};
+
+	// Appends the messages exchanged with the Player to a session log.
+	// Writes are serialised by an internal mutex; when not recording each call is a single atomic load.
+	class RequestRecorder
+	{
+	public:
+		~RequestRecorder();
+
+		// Starts a new log at path, replacing any recording in progress.
+		bool start(const std::string& path, bool includeStatus);
+
+		void stop();
+
+		bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+		void recordSent(const std::string& message);
+
+		void recordReceived(const char* message, size_t length);
+
+	private:
+		std::atomic<bool> recording{ false };
+		bool includeStatus = false;
+		std::mutex fileMtx; // guards everything below
+		FILE* file = nullptr;
+		std::chrono::steady_clock::time_point previous;
+
+		void write(RecordType type, const char* payload, size_t length);
+		void close();
+	};
+
+	// Reads a session log written by RequestRecorder.
+	class RecordingReader
+	{
+	public:
+		~RecordingReader();
+
+		bool open(const std::string& path);
+
+		// Returns false at the end of the log or on a truncated record.
+		bool next(RecordedMessage& message);
+
+		bool includesStatus() const { return statusRecorded; }
+
+		uint64_t startMicros() const { return startTime; }
+
+	private:
+		FILE* file = nullptr;
+		bool statusRecorded = false;
+		uint64_t startTime = 0;
+		uint64_t elapsed = 0;
+
+		bool readVarint(uint64_t& value);
+	};
+}
+
+#endif
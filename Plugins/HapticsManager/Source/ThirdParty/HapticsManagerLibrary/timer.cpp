@@ -19,9 +19,24 @@ void HapticTimer::addTimerHandler(std::function<void()> &callback)
     callbackFunc = callback;
 }
 
+void HapticTimer::addPollHandler(std::function<int()> &poll)
+{
+    pollFunc = poll;
+}
+
+void HapticTimer::wake()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx);
+        woken = true;
+    }
+    sleepCv.notify_one();
+}
+
 void HapticTimer::stop()
 {
     started = false;
+    wake();
     if (runner.joinable())
     {
         runner.join();
@@ -35,7 +50,7 @@ void HapticTimer::workerFunc()
         std::chrono::steady_clock::time_point current = std::chrono::steady_clock::now();
                 
         //int values = (int) std::chrono::duration_cast<std::chrono::milliseconds>(current - prev).count();
-		bool isIntervalOver = (current > (prev + std::chrono::milliseconds(interval)));
+		bool isIntervalOver = (current > (prev + std::chrono::milliseconds(interval.load())));
 
 		if(callbackFunc && isIntervalOver)
         {
@@ -43,6 +58,15 @@ void HapticTimer::workerFunc()
             callbackFunc();
         }
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+        int sleepMillis = sleepTime;
+        if (pollFunc)
+        {
+            int pollMillis = pollFunc();
+            sleepMillis = pollMillis < sleepMillis ? pollMillis : sleepMillis;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        sleepCv.wait_for(lock, std::chrono::milliseconds(sleepMillis), [this]() { return woken; });
+        woken = false;
     }
 }
@@ -8,6 +8,8 @@
 #include <mutex>
 #include <future>
 #include <atomic>
+#include <condition_variable>
+#include <functional>
 
     class HapticTimer
     {
@@ -20,14 +22,29 @@
 
 		void stop();
 
+		// Milliseconds between callbacks; may be changed while the timer runs.
+		void setInterval(int millis) { interval = millis; }
+
+		// Called every time the thread wakes, before it sleeps again; returns the milliseconds it may sleep at most.
+		// Lets work due between callbacks, such as scheduled submits, run within a millisecond.
+		void addPollHandler(std::function<int()> &poll);
+
+		// Wakes the thread now instead of after its current sleep.
+		void wake();
+
     private:
-        std::atomic<bool> started = false;
+        std::atomic<bool> started{ false };
         std::function<void()> callbackFunc;
-        int interval = 100;
+        std::function<int()> pollFunc;
+        std::atomic<int> interval{ 100 };
         int sleepTime = 5;
 
         std::chrono::steady_clock::time_point prev;
 
+        std::mutex sleepMtx;
+        std::condition_variable sleepCv;
+        bool woken = false; // guarded by sleepMtx
+
 		void workerFunc();
         std::thread runner;
     };
@@ -0,0 +1,255 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "timingWheel.h"
+
+namespace bhaptics
+{
+	TimingWheel::TimingWheel()
+	{
+		for (int level = 0; level < Levels; level++)
+		{
+			for (int slot = 0; slot < Slots; slot++)
+			{
+				heads[level][slot] = None;
+				tails[level][slot] = None;
+			}
+		}
+	}
+
+	void TimingWheel::schedule(uint64_t dueTick, const SubmitRequest& request)
+	{
+		int32_t entry;
+		if (freeEntries.empty())
+		{
+			entry = (int32_t)entries.size();
+			entries.push_back(Entry());
+		}
+		else
+		{
+			entry = freeEntries.back();
+			freeEntries.pop_back();
+		}
+
+		Entry& item = entries[entry];
+		item.Due = dueTick;
+		item.Request = request;
+		place(entry, current + 1);
+
+		// New entries go first in their identity's list; cancel does not care about order.
+		std::unordered_map<std::string, int32_t>::iterator head = keyHeads.find(request.identity());
+		item.KeyPrev = None;
+		if (head == keyHeads.end())
+		{
+			item.KeyNext = None;
+			keyHeads.insert(std::make_pair(request.identity(), entry));
+		}
+		else
+		{
+			item.KeyNext = head->second;
+			entries[head->second].KeyPrev = entry;
+			head->second = entry;
+		}
+		count++;
+	}
+
+	size_t TimingWheel::cancel(const std::string& identity)
+	{
+		size_t cancelled = 0;
+		if (identity.empty())
+		{
+			for (std::unordered_map<std::string, int32_t>::iterator it = keyHeads.begin(); it != keyHeads.end(); ++it)
+			{
+				for (int32_t entry = it->second; entry != None; entry = entries[entry].KeyNext)
+				{
+					unlinkSlot(entry);
+					release(entry);
+					cancelled++;
+				}
+			}
+			keyHeads.clear();
+			count = 0;
+			return cancelled;
+		}
+
+		std::unordered_map<std::string, int32_t>::iterator head = keyHeads.find(identity);
+		if (head == keyHeads.end())
+		{
+			return 0;
+		}
+		for (int32_t entry = head->second; entry != None; entry = entries[entry].KeyNext)
+		{
+			unlinkSlot(entry);
+			release(entry);
+			cancelled++;
+		}
+		keyHeads.erase(head);
+		count -= cancelled;
+		return cancelled;
+	}
+
+	void TimingWheel::advance(uint64_t tick, std::vector<SubmitRequest>& due)
+	{
+		while (current < tick)
+		{
+			if (count == 0)
+			{
+				current = tick;
+				return;
+			}
+
+			current++;
+			int slot = (int)(current & (Slots - 1));
+			if (slot == 0)
+			{
+				// Cascade the levels whose slot boundary this tick crosses, highest first, so their entries can still
+				// land in the lower slots visited from this tick on.
+				int highest = 1;
+				while (highest + 1 < Levels && ((current >> (SlotBits * highest)) & (Slots - 1)) == 0)
+				{
+					highest++;
+				}
+				for (int level = highest; level >= 1; level--)
+				{
+					cascade(level, (int)((current >> (SlotBits * level)) & (Slots - 1)));
+				}
+			}
+
+			int32_t entry = heads[0][slot];
+			heads[0][slot] = None;
+			tails[0][slot] = None;
+			while (entry != None)
+			{
+				int32_t next = entries[entry].Next;
+				if (entries[entry].Due > current)
+				{
+					place(entry, current + 1);
+				}
+				else
+				{
+					unlinkKey(entry);
+					due.push_back(entries[entry].Request);
+					release(entry);
+					count--;
+				}
+				entry = next;
+			}
+		}
+	}
+
+	uint64_t TimingWheel::ticksUntilDue(uint64_t limit) const
+	{
+		if (count == 0)
+		{
+			return limit;
+		}
+		uint64_t window = limit < (uint64_t)Slots ? limit : (uint64_t)Slots;
+		for (uint64_t ahead = 1; ahead <= window; ahead++)
+		{
+			if (heads[0][(current + ahead) & (Slots - 1)] != None)
+			{
+				return ahead;
+			}
+		}
+
+		// Nothing on level 0: the next entry cannot fall due before the next cascade.
+		uint64_t untilCascade = Slots - (current & (Slots - 1));
+		return untilCascade < limit ? untilCascade : limit;
+	}
+
+	void TimingWheel::place(int32_t entry, uint64_t earliest)
+	{
+		Entry& item = entries[entry];
+		uint64_t at = item.Due > earliest ? item.Due : earliest;
+		uint64_t ahead = at - current;
+
+		int level = 0;
+		while (level < Levels - 1 && ahead >= ((uint64_t)1 << (SlotBits * (level + 1))))
+		{
+			level++;
+		}
+		uint64_t horizon = ((uint64_t)1 << (SlotBits * Levels)) - 1;
+		if (ahead > horizon)
+		{
+			// Parked; advance places it again when this slot cascades.
+			at = current + horizon;
+		}
+
+		item.Level = level;
+		item.Slot = (int)((at >> (SlotBits * level)) & (Slots - 1));
+		item.Next = None;
+		item.Prev = tails[level][item.Slot];
+		if (item.Prev == None)
+		{
+			heads[level][item.Slot] = entry;
+		}
+		else
+		{
+			entries[item.Prev].Next = entry;
+		}
+		tails[level][item.Slot] = entry;
+	}
+
+	void TimingWheel::unlinkSlot(int32_t entry)
+	{
+		Entry& item = entries[entry];
+		if (item.Prev == None)
+		{
+			heads[item.Level][item.Slot] = item.Next;
+		}
+		else
+		{
+			entries[item.Prev].Next = item.Next;
+		}
+		if (item.Next == None)
+		{
+			tails[item.Level][item.Slot] = item.Prev;
+		}
+		else
+		{
+			entries[item.Next].Prev = item.Prev;
+		}
+	}
+
+	void TimingWheel::unlinkKey(int32_t entry)
+	{
+		Entry& item = entries[entry];
+		if (item.KeyPrev != None)
+		{
+			entries[item.KeyPrev].KeyNext = item.KeyNext;
+		}
+		else
+		{
+			std::unordered_map<std::string, int32_t>::iterator head = keyHeads.find(item.Request.identity());
+			if (item.KeyNext == None)
+			{
+				keyHeads.erase(head);
+			}
+			else
+			{
+				head->second = item.KeyNext;
+			}
+		}
+		if (item.KeyNext != None)
+		{
+			entries[item.KeyNext].KeyPrev = item.KeyPrev;
+		}
+	}
+
+	void TimingWheel::release(int32_t entry)
+	{
+		// Keeps the pool's string buffers for reuse; the request is overwritten when the entry is next scheduled.
+		freeEntries.push_back(entry);
+	}
+
+	void TimingWheel::cascade(int level, int slot)
+	{
+		int32_t entry = heads[level][slot];
+		heads[level][slot] = None;
+		tails[level][slot] = None;
+		while (entry != None)
+		{
+			int32_t next = entries[entry].Next;
+			place(entry, current);
+			entry = next;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_TIMING_WHEEL
+#define BHAPTICS_TIMING_WHEEL
+
+#include "model.h"
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bhaptics
+{
+	// Holds submit requests until their due tick (1 ms each) in a hierarchical timing wheel: 4 levels of 64 slots
+	// covering 64 ms, 4 s, 4.5 min and 4.6 h. Scheduling and cancelling are O(1); advancing visits each elapsed tick
+	// once and moves an entry down a level at most 3 times. Entries due further out than the top level are parked in
+	// its last slot and placed again as time passes.
+	//
+	// Not thread-safe; HapticPlayer guards it with scheduleMtx.
+	class TimingWheel
+	{
+	public:
+		TimingWheel();
+
+		// Tick the wheel has advanced to. Requests scheduled at or before it are due on the next advance.
+		uint64_t now() const { return current; }
+
+		// Entries not yet due or cancelled.
+		size_t size() const { return count; }
+
+		void schedule(uint64_t dueTick, const SubmitRequest& request);
+
+		// Drops the entries whose request identity (key, or altKey when set) is identity, or every entry when it is
+		// empty. Returns how many were dropped.
+		size_t cancel(const std::string& identity);
+
+		// Moves to tick, appending the requests that fell due to due in the order of their due ticks.
+		void advance(uint64_t tick, std::vector<SubmitRequest>& due);
+
+		// Ticks until the earliest entry may fall due, at most limit; limit when the wheel is empty. Exact for entries
+		// within 64 ms, a lower bound otherwise.
+		uint64_t ticksUntilDue(uint64_t limit) const;
+
+	private:
+		static const int SlotBits = 6;
+		static const int Slots = 1 << SlotBits;
+		static const int Levels = 4;
+		static const int32_t None = -1;
+
+		struct Entry
+		{
+			uint64_t Due;
+			SubmitRequest Request;
+			int32_t Prev;      // in its slot
+			int32_t Next;
+			int32_t KeyPrev;   // among the entries of its identity
+			int32_t KeyNext;
+			int Level;
+			int Slot;
+		};
+
+		std::vector<Entry> entries;   // pool; freed entries are reused through freeEntries
+		std::vector<int32_t> freeEntries;
+		int32_t heads[Levels][Slots];
+		int32_t tails[Levels][Slots];
+		std::unordered_map<std::string, int32_t> keyHeads;
+		uint64_t current = 0;
+		size_t count = 0;
+
+		// Links entry into the slot its due tick falls in, relative to current. earliest is the first tick a slot
+		// may still be visited at: current + 1 for new entries, current while cascading.
+		void place(int32_t entry, uint64_t earliest);
+		void unlinkSlot(int32_t entry);
+		void unlinkKey(int32_t entry);
+		void release(int32_t entry);
+
+		// Re-places the entries of one slot of level, moving them towards level 0.
+		void cascade(int level, int slot);
+	};
+}
+
+#endif
@@ -0,0 +1,204 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "traceLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace bhaptics
+{
+	TraceLog* TraceLog::instance()
+	{
+		static TraceLog traceLog;
+		return &traceLog;
+	}
+
+	uint32_t TraceLog::threadId()
+	{
+		static std::atomic<uint32_t> nextId{ 1 };
+		static thread_local uint32_t id = nextId.fetch_add(1);
+		return id;
+	}
+
+	int64_t TraceLog::micros(std::chrono::steady_clock::time_point time) const
+	{
+		return (int64_t)std::chrono::duration_cast<std::chrono::microseconds>(time - origin).count();
+	}
+
+	void TraceLog::start(size_t eventCapacity, const std::string& dumpPath)
+	{
+		enabled = false;
+
+		// The ring is allocated once: threads may still be writing into it after a stop.
+		if (!events && eventCapacity > 0)
+		{
+			events.reset(new Event[eventCapacity]);
+			capacity = eventCapacity;
+		}
+		if (!events)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < capacity; i++)
+		{
+			events[i].sequence.store(0, std::memory_order_relaxed);
+		}
+		head = 0;
+		origin = std::chrono::steady_clock::now();
+		shutdownPath = dumpPath;
+		enabled = true;
+	}
+
+	void TraceLog::stop()
+	{
+		enabled = false;
+	}
+
+	void TraceLog::nameThread(const char* name)
+	{
+		std::lock_guard<std::mutex> lock(threadMtx);
+		threadNames[threadId()] = name;
+	}
+
+	void TraceLog::complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+		const std::string& detail, int64_t value)
+	{
+		if (!isEnabled())
+		{
+			return;
+		}
+		int64_t timestamp = micros(start);
+		record('X', name, timestamp, micros(end) - timestamp, detail, value);
+	}
+
+	void TraceLog::instant(const char* name, const std::string& detail, int64_t value)
+	{
+		if (!isEnabled())
+		{
+			return;
+		}
+		record('i', name, micros(std::chrono::steady_clock::now()), 0, detail, value);
+	}
+
+	void TraceLog::record(char phase, const char* name, int64_t timestamp, int64_t duration, const std::string& detail, int64_t value)
+	{
+		uint64_t slot = head.fetch_add(1, std::memory_order_relaxed);
+		Event& event = events[slot % capacity];
+
+		// Seqlock: readers only accept the event if the sequence is unchanged around their copy.
+		event.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		event.name = name;
+		event.phase = phase;
+		event.thread = threadId();
+		event.timestamp = timestamp;
+		event.duration = duration;
+		event.value = value;
+		size_t length = detail.size() < DetailLength - 1 ? detail.size() : DetailLength - 1;
+		memcpy(event.detail, detail.data(), length);
+		event.detail[length] = '\0';
+		event.sequence.store(slot + 1, std::memory_order_release);
+	}
+
+	static void writeEscaped(FILE* file, const char* text)
+	{
+		for (; *text; text++)
+		{
+			unsigned char c = (unsigned char)*text;
+			if (c == '"' || c == '\\')
+			{
+				fprintf(file, "\\%c", c);
+			}
+			else if (c < 0x20)
+			{
+				fprintf(file, "\\u%04x", c);
+			}
+			else
+			{
+				fputc(c, file);
+			}
+		}
+	}
+
+	bool TraceLog::dump(const std::string& path)
+	{
+		if (!events || path.empty())
+		{
+			return false;
+		}
+
+		FILE* file = fopen(path.c_str(), "w");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Could not write trace to %s\n", path.c_str());
+			return false;
+		}
+
+		fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+		fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"HapticLibrary\"}}", file);
+
+		{
+			std::lock_guard<std::mutex> lock(threadMtx);
+			for (auto& thread : threadNames)
+			{
+				fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", thread.first);
+				writeEscaped(file, thread.second.c_str());
+				fputs("\"}}", file);
+			}
+		}
+
+		uint64_t end = head.load(std::memory_order_acquire);
+		uint64_t begin = end > capacity ? end - capacity : 0;
+		for (uint64_t slot = begin; slot < end; slot++)
+		{
+			Event& source = events[slot % capacity];
+			uint64_t sequence = source.sequence.load(std::memory_order_acquire);
+			if (sequence != slot + 1)
+			{
+				continue;
+			}
+
+			const char* name = source.name;
+			char phase = source.phase;
+			uint32_t thread = source.thread;
+			int64_t timestamp = source.timestamp;
+			int64_t duration = source.duration;
+			int64_t value = source.value;
+			char detail[DetailLength];
+			memcpy(detail, source.detail, DetailLength);
+			detail[DetailLength - 1] = '\0';
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (source.sequence.load(std::memory_order_relaxed) != sequence)
+			{
+				continue;
+			}
+
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"haptics\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%lld",
+				name, phase, thread, (long long)timestamp);
+			if (phase == 'X')
+			{
+				fprintf(file, ",\"dur\":%lld", (long long)duration);
+			}
+			else
+			{
+				fputs(",\"s\":\"t\"", file);
+			}
+			fputs(",\"args\":{\"detail\":\"", file);
+			writeEscaped(file, detail);
+			fprintf(file, "\",\"value\":%lld}}", (long long)value);
+		}
+
+		fputs("\n]}\n", file);
+		fclose(file);
+		return true;
+	}
+
+	void TraceLog::dumpOnShutdown()
+	{
+		if (!shutdownPath.empty())
+		{
+			dump(shutdownPath);
+		}
+	}
+}
@@ -0,0 +1,76 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_TRACE_LOG
+#define BHAPTICS_TRACE_LOG
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+namespace bhaptics
+{
+	// Ring buffer of timestamped library events, written out in Chrome trace-event format
+	// for chrome://tracing or Perfetto. Recording is lock-free; when disabled each call is a single atomic load.
+	class TraceLog
+	{
+	public:
+		// Event names must be string literals: only the pointer is stored.
+		void complete(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+			const std::string& detail = std::string(), int64_t value = 0);
+
+		void instant(const char* name, const std::string& detail = std::string(), int64_t value = 0);
+
+		// Names the calling thread in the trace.
+		void nameThread(const char* name);
+
+		// Starts recording into a ring of the given number of events, discarding anything recorded before.
+		// A non-empty dumpPath is written when the player is destroyed.
+		void start(size_t capacity, const std::string& dumpPath);
+
+		void stop();
+
+		bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+		// Writes the events currently in the ring. Safe while recording: events being overwritten are skipped.
+		bool dump(const std::string& path);
+
+		// Dumps to the path given to start, if any.
+		void dumpOnShutdown();
+
+		static TraceLog* instance();
+
+	private:
+		static const size_t DetailLength = 40;
+
+		struct Event
+		{
+			std::atomic<uint64_t> sequence{ 0 };
+			const char* name;
+			char phase;
+			uint32_t thread;
+			int64_t timestamp;
+			int64_t duration;
+			int64_t value;
+			char detail[DetailLength];
+		};
+
+		std::atomic<bool> enabled{ false };
+		std::atomic<uint64_t> head{ 0 };
+		std::unique_ptr<Event[]> events;
+		size_t capacity = 0;
+		std::chrono::steady_clock::time_point origin;
+		std::string shutdownPath;
+
+		std::mutex threadMtx; // guards threadNames
+		std::map<uint32_t, std::string> threadNames;
+
+		void record(char phase, const char* name, int64_t timestamp, int64_t duration, const std::string& detail, int64_t value);
+		int64_t micros(std::chrono::steady_clock::time_point time) const;
+		static uint32_t threadId();
+	};
+}
+
+#endif
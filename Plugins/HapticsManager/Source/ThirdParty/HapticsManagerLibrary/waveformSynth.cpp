@@ -0,0 +1,227 @@
+//Copyright bHaptics Inc. 2017-2019
+#include "waveformSynth.h"
+#include "motorLayout.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bhaptics
+{
+	namespace
+	{
+		const double Pi = 3.14159265358979323846;
+
+		float elapsedMillis(WaveformSynth::TimePoint from, WaveformSynth::TimePoint to)
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count() / 1000.0f;
+		}
+	}
+
+	void WaveformSynth::play(const std::string& key, const SynthEffect& effect, TimePoint now)
+	{
+		Voice* voice = find(key);
+		if (voice == nullptr)
+		{
+			voices.push_back(Voice());
+			voice = &voices.back();
+			voice->Key = key;
+		}
+		voice->Effect = effect;
+		voice->Started = now;
+		voice->LastRender = now;
+		voice->Released = false;
+		voice->ReleaseLevel = 0.0f;
+		voice->Phase = 0.0;
+		voice->Noise = effect.Seed == 0 ? 1 : effect.Seed;
+		for (int i = 0; i < MaxMotors; i++)
+		{
+			voice->NoiseLevels[i] = (nextNoise(voice->Noise) & 0xFFFF) / 65535.0f;
+		}
+	}
+
+	bool WaveformSynth::update(const std::string& key, const SynthEffect& effect)
+	{
+		Voice* voice = find(key);
+		if (voice == nullptr)
+		{
+			return false;
+		}
+		voice->Effect = effect;
+		return true;
+	}
+
+	void WaveformSynth::release(const std::string& key, TimePoint now)
+	{
+		for (Voice& voice : voices)
+		{
+			if ((key.empty() || voice.Key == key) && !voice.Released)
+			{
+				voice.ReleaseLevel = attackDecaySustain(voice.Effect.Envelope, elapsedMillis(voice.Started, now));
+				voice.ReleaseStarted = now;
+				voice.Released = true;
+			}
+		}
+	}
+
+	void WaveformSynth::stop(const std::string& key)
+	{
+		voices.erase(std::remove_if(voices.begin(), voices.end(),
+			[&key](const Voice& voice) { return key.empty() || voice.Key == key; }), voices.end());
+	}
+
+	bool WaveformSynth::isPlaying(const std::string& key) const
+	{
+		return std::find_if(voices.begin(), voices.end(), [&key](const Voice& voice) { return voice.Key == key; }) != voices.end();
+	}
+
+	void WaveformSynth::render(TimePoint now, std::vector<SynthFrame>& frames)
+	{
+		frames.clear();
+		size_t kept = 0;
+		for (size_t v = 0; v < voices.size(); v++)
+		{
+			Voice& voice = voices[v];
+			float level;
+			if (!envelopeAt(voice, now, level))
+			{
+				continue;
+			}
+
+			const SynthEffect& effect = voice.Effect;
+			double previousPhase = voice.Phase;
+			voice.Phase += effect.FrequencyHz * elapsedMillis(voice.LastRender, now) / 1000.0;
+			voice.LastRender = now;
+			if (effect.Shape == WaveShape::Noise && (effect.FrequencyHz <= 0.0f || std::floor(voice.Phase) != std::floor(previousPhase)))
+			{
+				for (int i = 0; i < MaxMotors; i++)
+				{
+					voice.NoiseLevels[i] = (nextNoise(voice.Noise) & 0xFFFF) / 65535.0f;
+				}
+			}
+			// Only the fraction matters; dropping whole cycles keeps the phase precise however long the voice plays.
+			voice.Phase -= std::floor(voice.Phase);
+
+			float sinceStart = elapsedMillis(voice.Started, now);
+			float cycle = oscillator(effect.Shape, voice.Phase);
+			float depth = std::min(std::max(effect.Depth, 0.0f), 1.0f);
+			SynthFrame frame;
+			frame.Position = effect.Position;
+			int motors = motorCount(effect.Position);
+			for (int i = 0; i < MaxMotors; i++)
+			{
+				frame.Dots[i] = 0;
+				if (i >= motors || (effect.MotorMask & (1u << i)) == 0)
+				{
+					continue;
+				}
+				float wave = effect.Shape == WaveShape::Noise ? voice.NoiseLevels[i] : cycle;
+				float value = 100.0f * effect.Intensity * level * (1.0f - depth + depth * wave) * sweepWeight(effect, sinceStart, i);
+				frame.Dots[i] = std::min(100, std::max(0, (int)(value + 0.5f)));
+			}
+			frames.push_back(frame);
+
+			if (kept != v)
+			{
+				voices[kept] = std::move(voice);
+			}
+			kept++;
+		}
+		voices.resize(kept);
+	}
+
+	WaveformSynth::Voice* WaveformSynth::find(const std::string& key)
+	{
+		for (Voice& voice : voices)
+		{
+			if (voice.Key == key)
+			{
+				return &voice;
+			}
+		}
+		return nullptr;
+	}
+
+	float WaveformSynth::attackDecaySustain(const Adsr& envelope, float ms)
+	{
+		float sustain = std::min(std::max(envelope.SustainLevel, 0.0f), 1.0f);
+		if (envelope.AttackMillis > 0 && ms < envelope.AttackMillis)
+		{
+			return ms / envelope.AttackMillis;
+		}
+		ms -= std::max(envelope.AttackMillis, 0);
+		if (envelope.DecayMillis > 0 && ms < envelope.DecayMillis)
+		{
+			return 1.0f - (1.0f - sustain) * ms / envelope.DecayMillis;
+		}
+		return sustain;
+	}
+
+	bool WaveformSynth::envelopeAt(Voice& voice, TimePoint now, float& level)
+	{
+		const SynthEffect& effect = voice.Effect;
+		float sinceStart = elapsedMillis(voice.Started, now);
+		if (!voice.Released && effect.DurationMillis > 0 && sinceStart >= effect.DurationMillis)
+		{
+			voice.ReleaseLevel = attackDecaySustain(effect.Envelope, (float)effect.DurationMillis);
+			voice.ReleaseStarted = voice.Started + std::chrono::milliseconds(effect.DurationMillis);
+			voice.Released = true;
+		}
+		if (!voice.Released)
+		{
+			level = attackDecaySustain(effect.Envelope, sinceStart);
+			return true;
+		}
+
+		float sinceRelease = elapsedMillis(voice.ReleaseStarted, now);
+		if (sinceRelease >= effect.Envelope.ReleaseMillis)
+		{
+			return false;
+		}
+		level = voice.ReleaseLevel * (1.0f - sinceRelease / effect.Envelope.ReleaseMillis);
+		return true;
+	}
+
+	float WaveformSynth::oscillator(WaveShape shape, double phase)
+	{
+		switch (shape)
+		{
+		case WaveShape::Sine:
+			// Starts at 0 rather than mid-level, so a voice fades in with its first cycle.
+			return (float)(0.5 - 0.5 * std::cos(2.0 * Pi * phase));
+		case WaveShape::Square:
+			return phase < 0.5 ? 1.0f : 0.0f;
+		case WaveShape::Triangle:
+			return (float)(phase < 0.5 ? 2.0 * phase : 2.0 - 2.0 * phase);
+		case WaveShape::Saw:
+			return (float)phase;
+		default:
+			return 1.0f;
+		}
+	}
+
+	float WaveformSynth::sweepWeight(const SynthEffect& effect, float ms, int motor)
+	{
+		if (effect.SweepMillis <= 0)
+		{
+			return 1.0f;
+		}
+		float progress = ms / effect.SweepMillis;
+		progress = effect.SweepLoop ? progress - std::floor(progress) : std::min(progress, 1.0f);
+		float center = effect.SweepFrom + (effect.SweepTo - effect.SweepFrom) * progress;
+		float distance = std::fabs(motor - center);
+		if (effect.SweepWidth <= 0.0f)
+		{
+			return distance < 0.5f ? 1.0f : 0.0f;
+		}
+		return std::max(0.0f, 1.0f - distance / effect.SweepWidth);
+	}
+
+	uint32_t WaveformSynth::nextNoise(uint32_t& state)
+	{
+		// xorshift32: cheap, and the same sequence on every platform for a given seed.
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+}
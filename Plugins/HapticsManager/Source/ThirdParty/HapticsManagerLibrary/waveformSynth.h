@@ -0,0 +1,81 @@
+//Copyright bHaptics Inc. 2017-2019
+#ifndef BHAPTICS_WAVEFORM_SYNTH
+#define BHAPTICS_WAVEFORM_SYNTH
+
+#include "model.h"
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bhaptics
+{
+	// Motor levels of one voice for one tick, 0 to 100.
+	struct SynthFrame
+	{
+		bhaptics::Position Position;
+		int Dots[MaxMotors];
+	};
+
+	// Plays SynthEffects keyed by name. Parameters may be replaced while a voice plays; its envelope and oscillator phase
+	// carry on, so per-tick updates from game code do not click or restart.
+	//
+	// Not thread-safe; HapticPlayer guards it with localMtx and renders it from the timer thread.
+	class WaveformSynth
+	{
+	public:
+		typedef std::chrono::steady_clock::time_point TimePoint;
+
+		size_t size() const { return voices.size(); }
+
+		// Starts key, replacing a voice already playing under it.
+		void play(const std::string& key, const SynthEffect& effect, TimePoint now);
+
+		// Replaces the parameters of key's voice; false if it is not playing.
+		bool update(const std::string& key, const SynthEffect& effect);
+
+		// Moves key's voice, or every voice if key is empty, into its release.
+		void release(const std::string& key, TimePoint now);
+
+		// Drops key's voice, or every voice if key is empty, without a release.
+		void stop(const std::string& key);
+
+		bool isPlaying(const std::string& key) const;
+
+		// Replaces frames with one frame per voice at now, then drops the voices that finished.
+		void render(TimePoint now, std::vector<SynthFrame>& frames);
+
+	private:
+		struct Voice
+		{
+			std::string Key;
+			SynthEffect Effect;
+			TimePoint Started;
+			TimePoint LastRender;
+			bool Released;
+			TimePoint ReleaseStarted;
+			float ReleaseLevel; // envelope level when the release started
+			double Phase;       // of the oscillator, in cycles
+			uint32_t Noise;
+			float NoiseLevels[MaxMotors];
+		};
+		std::vector<Voice> voices;
+
+		Voice* find(const std::string& key);
+
+		// Level of the envelope before any release, ms after the start.
+		static float attackDecaySustain(const Adsr& envelope, float ms);
+
+		// Level of the envelope at now; false once the release has ended.
+		static bool envelopeAt(Voice& voice, TimePoint now, float& level);
+
+		static float oscillator(WaveShape shape, double phase);
+
+		static float sweepWeight(const SynthEffect& effect, float ms, int motor);
+
+		static uint32_t nextNoise(uint32_t& state);
+	};
+}
+
+#endif